@@ -0,0 +1,925 @@
+// Runs the boid simulation without a GPU and reports its throughput.
+//
+// Usage: boids_bench [--boids N] [--steps M] [--warmup W] [--threads T] [--kernel scalar|sse|avx2]
+//                    [--time-step S] [--integrator legacy|euler|verlet [--max-substeps N]]
+//                    [--visual-range] [--topological [--neighbors K]] [--sort-every K] [--species N]
+//                    [--obstacles N] [--predators P] [--seed S] [--checksum-every K]
+//                    [--verify [--tolerance E]] [--profile] [--trace FILE]
+//                    [--load-checkpoint FILE] [--save-checkpoint FILE [--quantize]]
+//                    [--record FILE [--record-budget MIB] [--verify-record]]
+//
+// --integrator selects how boids move over a time step: legacy (the default) moves them by their velocity once
+// per step whatever its length; euler and verlet scale the motion by the time step, and with --max-substeps
+// split long steps so that a larger --time-step gives the same flight at a lower cost per simulated second.
+//
+// --visual-range and --topological select how boids pick the neighbours whose velocity they match: those
+// within the visual range, or the K nearest (7 by default). Without either, boids match all other boids.
+//
+// --sort-every sorts the boids by Morton code every K steps. On Linux, the benchmark also counts the
+// last-level cache misses of the measured steps, if the kernel lets it open a hardware counter.
+//
+// --species splits the boids evenly into N species that flock with their own kind and avoid the others.
+// Each species flies a little faster than the one before.
+//
+// --obstacles places N sphere meshes at random in the box for the boids to steer around, and --predators
+// sends P predators circling through the box for the boids to flee from.
+//
+// --profile prints the time of each phase of the measured steps and histograms of the neighbour counts, and
+// --trace writes the measured steps as a Chrome trace. Both need a build with BOIDS_ENABLE_PROFILING.
+//
+// --save-checkpoint writes the state after the last step to a file; --quantize stores the positions in 16 bits.
+// --load-checkpoint starts from a saved state rather than from new random boids: the boids, species, settings and
+// random sequence come from the checkpoint, which is mapped into memory rather than read. Loading a checkpoint
+// saved after W steps and running with --warmup 0 continues the original run bit for bit, predators aside, so long
+// runs can skip their warm-up.
+//
+// --record streams the positions and velocities after every measured step to a compressed trajectory file,
+// keeping at most the budget of frames (64 MiB by default) waiting for the writer thread, and reports the
+// recorder's throughput. The time Record takes between steps is reported separately from the steps. With
+// --verify-record the benchmark then reads the file back with TrajectoryReader and compares the recorded states
+// at every checksum step with the swarm's; the run fails if the file cannot be read in full or a component
+// differs by more than half its quantization step.
+//
+// --checksum-every prints a checksum of the boid state every K steps. --verify also runs a single-threaded
+// scalar reference from the same seed and compares the states at every checksum; the run fails if any
+// position or velocity component differs by more than the tolerance (zero by default).
+
+#include "pch.h"
+
+#include <chrono>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+
+#if defined(_WIN32)
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "MappedFile.h"
+#include "Swarm.h"
+#include "TrajectoryRecorder.h"
+
+using namespace DirectX;
+
+namespace
+{
+    // The same tuning as the SimpleBoids demo.
+    const float BOID_RADIUS = 1.5f;
+    const float BOID_MIN_DISTANCE = 1.0f;
+    const float BOID_MATCHING_FACTOR = 0.2f;
+    const float MAX_BOID_SPEED = 0.7f;
+    const float BOID_AVOID_FACTOR = 0.3f;
+    const float BOID_TURN_FACTOR = 0.5f;
+    const float BOID_VISUAL_RANGE = 3.0f;
+    const float BOID_MOVE_TO_CENTER_FACTOR = 0.01f;
+    const float BOX_EDGE_LENGTH = 45.0f;
+
+    // Each species is this much faster than the one before, relative to the max speed of the first.
+    const float SPECIES_SPEED_STEP = 0.1f;
+
+    // The obstacles are spheres of this many latitude and longitude bands, so each has 1024 triangles.
+    const int OBSTACLE_STACK_COUNT = 16;
+    const int OBSTACLE_SLICE_COUNT = 32;
+    const float OBSTACLE_MIN_RADIUS = 4.f;
+    const float OBSTACLE_MAX_RADIUS = 10.f;
+
+    // The predators circle the centre of the box at this fraction of its half edge length.
+    const float PREDATOR_ORBIT = 0.6f;
+    const float PREDATOR_ANGULAR_SPEED = 0.02f;   // radians per step
+
+    struct Options
+    {
+        int BoidCount = 2000;
+        int StepCount = 100;
+        int WarmupStepCount = 10;
+        unsigned ThreadCount = 0;
+        KernelWidth Kernel = GetSupportedKernelWidth();
+        float TimeStep = 1.f / 60.f;
+        Integrator Integration = Integrator::Legacy;
+        int MaxSubstepCount = 1;
+        bool IsVisualRangeEnabled = false;
+        bool IsTopologicalEnabled = false;
+        int NeighborCount = Swarm::DEFAULT_TOPOLOGICAL_NEIGHBOR_COUNT;
+        int SortInterval = 0;
+        int SpeciesCount = 1;
+        int ObstacleCount = 0;
+        int PredatorCount = 0;
+        bool IsProfileEnabled = false;
+        char const* TracePath = nullptr;
+        char const* LoadCheckpointPath = nullptr;
+        char const* SaveCheckpointPath = nullptr;
+        bool IsCheckpointQuantized = false;
+        char const* RecordPath = nullptr;
+        int RecordBudget = 64;  // MiB
+        bool IsRecordVerifyEnabled = false;
+        uint32_t Seed = 1;
+        int ChecksumInterval = 0;
+        bool IsVerifyEnabled = false;
+        float Tolerance = 0.f;
+    };
+
+    void PrintUsage()
+    {
+        std::printf(
+            "Usage: boids_bench [--boids N] [--steps M] [--warmup W] [--threads T] [--kernel scalar|sse|avx2]\n"
+            "                   [--time-step S] [--integrator legacy|euler|verlet [--max-substeps N]]\n"
+            "                   [--visual-range] [--topological [--neighbors K]] [--sort-every K] [--species N]\n"
+            "                   [--obstacles N] [--predators P] [--seed S] [--checksum-every K]\n"
+            "                   [--verify [--tolerance E]] [--profile] [--trace FILE]\n"
+            "                   [--load-checkpoint FILE] [--save-checkpoint FILE [--quantize]]\n"
+            "                   [--record FILE [--record-budget MIB] [--verify-record]]\n");
+    }
+
+    char const* GetKernelName(KernelWidth width)
+    {
+        switch (width)
+        {
+        case KernelWidth::AVX2:
+            return "avx2";
+        case KernelWidth::SSE:
+            return "sse";
+        default:
+            return "scalar";
+        }
+    }
+
+    bool ParseKernel(char const* name, KernelWidth& width)
+    {
+        if (std::strcmp(name, "scalar") == 0)
+            width = KernelWidth::Scalar;
+        else if (std::strcmp(name, "sse") == 0)
+            width = KernelWidth::SSE;
+        else if (std::strcmp(name, "avx2") == 0)
+            width = KernelWidth::AVX2;
+        else
+            return false;
+
+        return true;
+    }
+
+    char const* GetIntegratorName(Integrator integrator)
+    {
+        switch (integrator)
+        {
+        case Integrator::SemiImplicitEuler:
+            return "euler";
+        case Integrator::Verlet:
+            return "verlet";
+        default:
+            return "legacy";
+        }
+    }
+
+    bool ParseIntegrator(char const* name, Integrator& integrator)
+    {
+        if (std::strcmp(name, "legacy") == 0)
+            integrator = Integrator::Legacy;
+        else if (std::strcmp(name, "euler") == 0)
+            integrator = Integrator::SemiImplicitEuler;
+        else if (std::strcmp(name, "verlet") == 0)
+            integrator = Integrator::Verlet;
+        else
+            return false;
+
+        return true;
+    }
+
+    bool ParseOptions(int argc, char* argv[], Options& options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            char const* arg = argv[i];
+            char const* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+
+            if (std::strcmp(arg, "--visual-range") == 0)
+            {
+                options.IsVisualRangeEnabled = true;
+                continue;
+            }
+
+            if (std::strcmp(arg, "--topological") == 0)
+            {
+                options.IsTopologicalEnabled = true;
+                continue;
+            }
+
+            if (std::strcmp(arg, "--profile") == 0)
+            {
+                options.IsProfileEnabled = true;
+                continue;
+            }
+
+            if (std::strcmp(arg, "--quantize") == 0)
+            {
+                options.IsCheckpointQuantized = true;
+                continue;
+            }
+
+            if (std::strcmp(arg, "--verify") == 0)
+            {
+                options.IsVerifyEnabled = true;
+                continue;
+            }
+
+            if (std::strcmp(arg, "--verify-record") == 0)
+            {
+                options.IsRecordVerifyEnabled = true;
+                continue;
+            }
+
+            if (value == nullptr)
+                return false;
+
+            if (std::strcmp(arg, "--boids") == 0)
+                options.BoidCount = std::atoi(value);
+            else if (std::strcmp(arg, "--steps") == 0)
+                options.StepCount = std::atoi(value);
+            else if (std::strcmp(arg, "--warmup") == 0)
+                options.WarmupStepCount = std::atoi(value);
+            else if (std::strcmp(arg, "--threads") == 0)
+                options.ThreadCount = static_cast<unsigned>(std::atoi(value));
+            else if (std::strcmp(arg, "--neighbors") == 0)
+                options.NeighborCount = std::atoi(value);
+            else if (std::strcmp(arg, "--sort-every") == 0)
+                options.SortInterval = std::atoi(value);
+            else if (std::strcmp(arg, "--species") == 0)
+                options.SpeciesCount = std::atoi(value);
+            else if (std::strcmp(arg, "--obstacles") == 0)
+                options.ObstacleCount = std::atoi(value);
+            else if (std::strcmp(arg, "--predators") == 0)
+                options.PredatorCount = std::atoi(value);
+            else if (std::strcmp(arg, "--trace") == 0)
+                options.TracePath = value;
+            else if (std::strcmp(arg, "--load-checkpoint") == 0)
+                options.LoadCheckpointPath = value;
+            else if (std::strcmp(arg, "--save-checkpoint") == 0)
+                options.SaveCheckpointPath = value;
+            else if (std::strcmp(arg, "--record") == 0)
+                options.RecordPath = value;
+            else if (std::strcmp(arg, "--record-budget") == 0)
+                options.RecordBudget = std::atoi(value);
+            else if (std::strcmp(arg, "--time-step") == 0)
+                options.TimeStep = static_cast<float>(std::atof(value));
+            else if (std::strcmp(arg, "--max-substeps") == 0)
+                options.MaxSubstepCount = std::atoi(value);
+            else if (std::strcmp(arg, "--seed") == 0)
+                options.Seed = static_cast<uint32_t>(std::strtoul(value, nullptr, 10));
+            else if (std::strcmp(arg, "--checksum-every") == 0)
+                options.ChecksumInterval = std::atoi(value);
+            else if (std::strcmp(arg, "--tolerance") == 0)
+                options.Tolerance = static_cast<float>(std::atof(value));
+            else if (std::strcmp(arg, "--kernel") == 0)
+            {
+                if (!ParseKernel(value, options.Kernel))
+                    return false;
+            }
+            else if (std::strcmp(arg, "--integrator") == 0)
+            {
+                if (!ParseIntegrator(value, options.Integration))
+                    return false;
+            }
+            else
+                return false;
+
+            ++i;
+        }
+
+        // Verification compares the states at the checksum steps; by default only after the last step.
+        if ((options.IsVerifyEnabled || options.IsRecordVerifyEnabled) && options.ChecksumInterval == 0)
+            options.ChecksumInterval = options.StepCount;
+
+        return options.BoidCount > 0 && options.StepCount > 0 && options.WarmupStepCount >= 0 &&
+            options.ChecksumInterval >= 0 && options.Tolerance >= 0.f && options.SortInterval >= 0 &&
+            options.ObstacleCount >= 0 && options.PredatorCount >= 0 && options.TimeStep > 0.f && options.RecordBudget > 0 &&
+            options.MaxSubstepCount >= 1 && options.MaxSubstepCount <= Swarm::MAX_SUBSTEP_COUNT &&
+            options.SpeciesCount >= 1 && options.SpeciesCount <= Swarm::MAX_SPECIES_COUNT &&
+            options.NeighborCount >= 1 && options.NeighborCount <= Swarm::MAX_TOPOLOGICAL_NEIGHBOR_COUNT &&
+            (!options.IsRecordVerifyEnabled || options.RecordPath);
+    }
+
+    // Appends a sphere of latitude and longitude bands to the triangle list.
+    void AddSphere(XMFLOAT3 const& centre, float radius, std::vector<XMFLOAT3>& positions, std::vector<uint32_t>& indices)
+    {
+        uint32_t first = static_cast<uint32_t>(positions.size());
+
+        for (int stack = 0; stack <= OBSTACLE_STACK_COUNT; ++stack)
+        {
+            float latitude = XM_PI * stack / OBSTACLE_STACK_COUNT;
+
+            for (int slice = 0; slice <= OBSTACLE_SLICE_COUNT; ++slice)
+            {
+                float longitude = XM_2PI * slice / OBSTACLE_SLICE_COUNT;
+                positions.emplace_back(
+                    centre.x + radius * std::sin(latitude) * std::cos(longitude),
+                    centre.y + radius * std::cos(latitude),
+                    centre.z + radius * std::sin(latitude) * std::sin(longitude));
+            }
+        }
+
+        uint32_t stride = OBSTACLE_SLICE_COUNT + 1;
+        for (uint32_t stack = 0; stack < OBSTACLE_STACK_COUNT; ++stack)
+        {
+            for (uint32_t slice = 0; slice < OBSTACLE_SLICE_COUNT; ++slice)
+            {
+                uint32_t a = first + stack * stride + slice;
+                uint32_t b = a + stride;
+                indices.insert(indices.end(), { a, b, a + 1, a + 1, b, b + 1 });
+            }
+        }
+    }
+
+    // Places the obstacles at random in the box, the same for every swarm of a run.
+    void SetObstacles(Swarm& swarm, Options const& options)
+    {
+        if (options.ObstacleCount == 0)
+            return;
+
+        std::mt19937 engine(options.Seed);
+        std::uniform_real_distribution<float> coordinate(-0.8f * BOX_EDGE_LENGTH, 0.8f * BOX_EDGE_LENGTH);
+        std::uniform_real_distribution<float> radius(OBSTACLE_MIN_RADIUS, OBSTACLE_MAX_RADIUS);
+
+        std::vector<XMFLOAT3> positions;
+        std::vector<uint32_t> indices;
+
+        for (int i = 0; i < options.ObstacleCount; ++i)
+        {
+            XMFLOAT3 centre;
+            centre.x = coordinate(engine);
+            centre.y = coordinate(engine);
+            centre.z = coordinate(engine);
+            AddSphere(centre, radius(engine), positions, indices);
+        }
+
+        swarm.SetObstacles(positions, indices);
+    }
+
+    // Returns the positions of the predators at the given step. They circle the centre of the box at
+    // different heights, evenly spaced around the circle.
+    std::vector<XMFLOAT3> GetPredatorPositions(int predatorCount, int stepIndex)
+    {
+        std::vector<XMFLOAT3> positions(predatorCount);
+
+        for (int p = 0; p < predatorCount; ++p)
+        {
+            float angle = PREDATOR_ANGULAR_SPEED * stepIndex + XM_2PI * p / predatorCount;
+            float orbit = PREDATOR_ORBIT * BOX_EDGE_LENGTH;
+            positions[p] = XMFLOAT3(orbit * std::cos(angle), orbit * std::sin(0.5f * angle), orbit * std::sin(angle));
+        }
+
+        return positions;
+    }
+
+    // Creates a swarm with the options, or from the checkpoint if there is one. Returns null if the checkpoint does
+    // not describe a valid swarm.
+    std::unique_ptr<Swarm> CreateSwarm(Options const& options, KernelWidth kernel, unsigned threadCount, SwarmCheckpoint const* checkpoint)
+    {
+        auto swarm = std::make_unique<Swarm>(
+            BOID_RADIUS,
+            BOID_MIN_DISTANCE,
+            BOID_MATCHING_FACTOR,
+            MAX_BOID_SPEED,
+            BOID_AVOID_FACTOR,
+            BOID_TURN_FACTOR,
+            BOID_VISUAL_RANGE,
+            BOID_MOVE_TO_CENTER_FACTOR,
+            BOX_EDGE_LENGTH);
+
+        swarm->SetThreadCount(threadCount);
+        swarm->SetKernelWidth(kernel);
+        swarm->IsVisualRangeEnabled(options.IsVisualRangeEnabled);
+        swarm->IsTopologicalEnabled(options.IsTopologicalEnabled);
+        swarm->SetTopologicalNeighborCount(options.NeighborCount);
+        swarm->SetSortInterval(options.SortInterval);
+        swarm->SetIntegrator(options.Integration);
+        swarm->SetMaxSubstepCount(options.MaxSubstepCount);
+        swarm->Seed(options.Seed);
+
+        if (checkpoint)
+        {
+            if (!swarm->LoadCheckpoint(*checkpoint))
+                return nullptr;
+
+            SetObstacles(*swarm, options);
+            return swarm;
+        }
+
+        for (int s = 1; s < options.SpeciesCount; ++s)
+        {
+            int species = swarm->AddSpecies();
+            swarm->SetBoidParameter(species, BoidParameter::MaxSpeed, MAX_BOID_SPEED * (1.f + SPECIES_SPEED_STEP * species));
+        }
+
+        for (int s = 0; s < options.SpeciesCount; ++s)
+        {
+            for (int t = 0; t < options.SpeciesCount; ++t)
+                swarm->SetInteraction(s, t, s == t ? SpeciesInteraction::Attract : SpeciesInteraction::Avoid);
+
+            // Spread the remainder over the first species.
+            int count = options.BoidCount / options.SpeciesCount + (s < options.BoidCount % options.SpeciesCount ? 1 : 0);
+            swarm->AddBoids(count, s);
+        }
+
+        SetObstacles(*swarm, options);
+        return swarm;
+    }
+
+    // Reports the settings that a swarm loaded from a checkpoint brought along.
+    void ReadOptions(Swarm const& swarm, Options& options)
+    {
+        options.BoidCount = static_cast<int>(swarm.Size());
+        options.SpeciesCount = swarm.GetSpeciesCount();
+        options.IsVisualRangeEnabled = swarm.IsVisualRangeEnabled();
+        options.IsTopologicalEnabled = swarm.IsTopologicalEnabled();
+        options.NeighborCount = swarm.GetTopologicalNeighborCount();
+        options.SortInterval = swarm.GetSortInterval();
+        options.Integration = swarm.GetIntegrator();
+        options.MaxSubstepCount = swarm.GetMaxSubstepCount();
+    }
+
+    // Writes a checkpoint of the swarm to a file. Returns its size in bytes, or zero if it could not be written.
+    size_t SaveCheckpoint(Swarm& swarm, Options const& options)
+    {
+        std::vector<std::byte> checkpoint;
+        swarm.SaveCheckpoint(checkpoint, options.IsCheckpointQuantized ? CheckpointPositionFormat::Quantized16 : CheckpointPositionFormat::Float32);
+
+        std::ofstream file(options.SaveCheckpointPath, std::ios::binary);
+        file.write(reinterpret_cast<char const*>(checkpoint.data()), static_cast<std::streamsize>(checkpoint.size()));
+        return file ? checkpoint.size() : 0;
+    }
+
+    // Returns the largest difference between any position or velocity component of the two swarms. The boids
+    // are matched by their IDs, since either swarm may have sorted them.
+    float GetMaxDifference(Swarm const& a, Swarm const& b)
+    {
+        std::span<float const> componentsA[] = {
+            a.GetPositionsX(), a.GetPositionsY(), a.GetPositionsZ(), a.GetVelocitiesX(), a.GetVelocitiesY(), a.GetVelocitiesZ() };
+        std::span<float const> componentsB[] = {
+            b.GetPositionsX(), b.GetPositionsY(), b.GetPositionsZ(), b.GetVelocitiesX(), b.GetVelocitiesY(), b.GetVelocitiesZ() };
+
+        std::vector<uint32_t> indicesB(b.GetBoidIds().size());
+        for (uint32_t i = 0; i < indicesB.size(); ++i)
+            indicesB[b.GetBoidIds()[i]] = i;
+
+        float maxDifference = 0.f;
+        for (size_t c = 0; c < std::size(componentsA); ++c)
+        {
+            for (size_t i = 0; i < componentsA[c].size(); ++i)
+                maxDifference = std::max(maxDifference, std::fabs(componentsA[c][i] - componentsB[c][indicesB[a.GetBoidIds()[i]]]));
+        }
+
+        return maxDifference;
+    }
+
+    // Counts the last-level cache misses of the calling thread and the threads it creates afterwards.
+    class CacheMissCounter
+    {
+    public:
+        CacheMissCounter()
+        {
+#if defined(__linux__)
+            perf_event_attr attributes{};
+            attributes.type = PERF_TYPE_HARDWARE;
+            attributes.size = sizeof(attributes);
+            attributes.config = PERF_COUNT_HW_CACHE_MISSES;
+            attributes.disabled = 1;
+            attributes.inherit = 1;
+            attributes.exclude_kernel = 1;
+            attributes.exclude_hv = 1;
+            m_descriptor = static_cast<int>(syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+#endif
+        }
+
+        ~CacheMissCounter()
+        {
+#if defined(__linux__)
+            if (m_descriptor >= 0)
+                close(m_descriptor);
+#endif
+        }
+
+        bool IsAvailable() const { return m_descriptor >= 0; }
+
+        void Start()
+        {
+#if defined(__linux__)
+            if (IsAvailable())
+                ioctl(m_descriptor, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+        }
+
+        void Stop()
+        {
+#if defined(__linux__)
+            if (IsAvailable())
+                ioctl(m_descriptor, PERF_EVENT_IOC_DISABLE, 0);
+#endif
+        }
+
+        // Returns the misses counted while the counter was running.
+        uint64_t GetCount() const
+        {
+            uint64_t count = 0;
+#if defined(__linux__)
+            if (IsAvailable() && read(m_descriptor, &count, sizeof(count)) != sizeof(count))
+                count = 0;
+#endif
+            return count;
+        }
+
+    private:
+        int m_descriptor = -1;
+    };
+
+    void PrintHistogram(char const* title, SwarmProfile::Histogram const& histogram, uint64_t boidStepCount)
+    {
+        std::printf("%s\n", title);
+
+        for (int b = 0; b < SwarmProfile::HISTOGRAM_BIN_COUNT; ++b)
+        {
+            if (histogram[b] == 0)
+                continue;
+
+            size_t lo = b == 0 ? 0 : size_t(1) << (b - 1);
+            size_t hi = (size_t(1) << b) - 1;
+
+            std::string label = std::to_string(lo);
+            if (b == SwarmProfile::HISTOGRAM_BIN_COUNT - 1)
+                label += "+";
+            else if (hi > lo)
+                label += "-" + std::to_string(hi);
+
+            std::printf("  %-12s %6.2f%%\n", label.c_str(),
+                100.0 * histogram[b] / boidStepCount);
+        }
+    }
+
+    void PrintProfile(SwarmProfile const& profile)
+    {
+        std::printf("phase             ms/step   %%\n");
+
+        double totalSeconds = profile.Seconds[static_cast<int>(SwarmPhase::UpdateBoids)];
+        for (int p = 0; p < static_cast<int>(SwarmPhase::UpdateBoids); ++p)
+            totalSeconds += profile.Seconds[p];
+
+        for (int p = 0; p < SwarmProfile::PHASE_COUNT; ++p)
+        {
+            auto phase = static_cast<SwarmPhase>(p);
+            double seconds = profile.Seconds[p];
+
+            // The per-boid sections are CPU time over all threads. Show them as shares of the CPU time of the update phase.
+            bool isPerBoid = phase > SwarmPhase::UpdateBoids;
+            double share = 0.0;
+            if (isPerBoid)
+            {
+                double cpuSeconds = 0.0;
+                for (int q = static_cast<int>(SwarmPhase::UpdateBoids) + 1; q < SwarmProfile::PHASE_COUNT; ++q)
+                    cpuSeconds += profile.Seconds[q];
+
+                share = cpuSeconds > 0.0 ? seconds / cpuSeconds : 0.0;
+            }
+            else
+                share = totalSeconds > 0.0 ? seconds / totalSeconds : 0.0;
+
+            std::printf("%s%-16s %8.3f %5.1f\n", isPerBoid ? "  " : "", SwarmProfile::GetPhaseName(phase),
+                seconds * 1e3 / profile.StepCount, 100.0 * share);
+        }
+
+        PrintHistogram("grid candidates per boid", profile.CandidateCounts, profile.BoidStepCount);
+        PrintHistogram("aligned neighbours per boid", profile.RangeCounts, profile.BoidStepCount);
+    }
+
+    void PrintRecorderStats(TrajectoryRecorderStats const& stats, double recordSeconds)
+    {
+        double writtenMiB = stats.WrittenBytes / (1024.0 * 1024.0);
+        double framesRecorded = static_cast<double>(std::max<uint64_t>(stats.FrameCount + stats.DroppedFrameCount, 1));
+
+        std::printf("recorded:       %" PRIu64 " frames, %" PRIu64 " dropped, %.2f MiB\n",
+            stats.FrameCount, stats.DroppedFrameCount, writtenMiB);
+        if (stats.IsWriteFailed)
+            std::printf("recorded:       stopped after a failed write; the file is incomplete\n");
+        std::printf("bytes/boid-frame: %.2f (%.1fx smaller than floats)\n",
+            stats.BoidFrameCount > 0 ? static_cast<double>(stats.WrittenBytes) / stats.BoidFrameCount : 0.0,
+            stats.WrittenBytes > 0 ? static_cast<double>(stats.RawBytes) / stats.WrittenBytes : 0.0);
+        std::printf("record (ms/frame): %.3f between steps\n", recordSeconds * 1e3 / framesRecorded);
+        std::printf("writer (ms/frame): %.3f encoding, %.3f writing\n",
+            stats.EncodeSeconds * 1e3 / std::max<uint64_t>(stats.FrameCount, 1),
+            stats.WriteSeconds * 1e3 / std::max<uint64_t>(stats.FrameCount, 1));
+        std::printf("writer (MiB/s):  %.1f of frames, %.1f written\n",
+            stats.RawBytes / (1024.0 * 1024.0) / std::max(stats.EncodeSeconds + stats.WriteSeconds, 1e-9),
+            writtenMiB / std::max(stats.EncodeSeconds + stats.WriteSeconds, 1e-9));
+    }
+
+    // Reads back the file the recorder wrote and compares its frames with the states copied when they were
+    // recorded, in step order. Returns false if a frame is missing or damaged or differs from its state by more
+    // than the quantization allows.
+    bool VerifyRecording(char const* path, TrajectoryRecorderStats const& stats, std::vector<TrajectoryFrame> const& states)
+    {
+        TrajectoryReader reader;
+        if (!reader.Open(path))
+        {
+            std::printf("record check:   %s is not a trajectory of this version\n", path);
+            return false;
+        }
+
+        // Rounding to the nearest step moves a component by at most half a step.
+        float maxPositionError = 0.5f * reader.GetPositionPrecision();
+        float maxVelocityError = 0.5f * reader.GetVelocityPrecision();
+
+        TrajectoryFrame frame;
+        uint64_t frameCount = 0;
+        size_t comparedCount = 0;
+        float positionError = 0.f;
+        float velocityError = 0.f;
+        bool isCorrect = !stats.IsWriteFailed;
+
+        while (reader.ReadFrame(frame))
+        {
+            ++frameCount;
+            if (comparedCount == states.size() || states[comparedCount].StepIndex != frame.StepIndex)
+                continue;
+
+            TrajectoryFrame const& state = states[comparedCount++];
+            if (frame.Ids != state.Ids)
+            {
+                std::printf("record check:   the boids of step %" PRIu64 " differ\n", frame.StepIndex);
+                isCorrect = false;
+                continue;
+            }
+
+            std::span<float const> positions[][2] = {
+                { frame.Boids.GetPositionsX(), state.Boids.GetPositionsX() },
+                { frame.Boids.GetPositionsY(), state.Boids.GetPositionsY() },
+                { frame.Boids.GetPositionsZ(), state.Boids.GetPositionsZ() } };
+            std::span<float const> velocities[][2] = {
+                { frame.Boids.GetVelocitiesX(), state.Boids.GetVelocitiesX() },
+                { frame.Boids.GetVelocitiesY(), state.Boids.GetVelocitiesY() },
+                { frame.Boids.GetVelocitiesZ(), state.Boids.GetVelocitiesZ() } };
+
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                for (size_t i = 0; i < frame.Ids.size(); ++i)
+                {
+                    positionError = std::max(positionError, std::fabs(positions[axis][0][i] - positions[axis][1][i]));
+                    velocityError = std::max(velocityError, std::fabs(velocities[axis][0][i] - velocities[axis][1][i]));
+                }
+            }
+        }
+
+        bool isWithinPrecision = positionError <= maxPositionError && velocityError <= maxVelocityError;
+        isCorrect = isCorrect && frameCount == stats.FrameCount && comparedCount == states.size() && isWithinPrecision;
+
+        std::printf("record check:   %" PRIu64 " of %" PRIu64 " frames read, %zu of %zu states compared, "
+            "max error %g in positions, %g in velocities (%s)\n", frameCount, stats.FrameCount, comparedCount, states.size(),
+            positionError, velocityError, isCorrect ? "OK" : "MISMATCH");
+
+        return isCorrect;
+    }
+
+    // Returns the peak resident set size of the process in bytes.
+    size_t GetPeakResidentSetSize()
+    {
+#if defined(_WIN32)
+        PROCESS_MEMORY_COUNTERS counters{};
+        GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters));
+        return counters.PeakWorkingSetSize;
+#else
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+        return static_cast<size_t>(usage.ru_maxrss);            // bytes
+#else
+        return static_cast<size_t>(usage.ru_maxrss) * 1024;     // kilobytes
+#endif
+#endif
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    if (!ParseOptions(argc, argv, options))
+    {
+        PrintUsage();
+        return EXIT_FAILURE;
+    }
+
+    // Open the counter before the swarm starts its worker threads, so that it counts their misses too.
+    CacheMissCounter cacheMisses;
+
+    // The checkpoint is used in place from the mapping, which lasts until the swarms have copied it.
+    MappedFile checkpointFile;
+    SwarmCheckpoint checkpoint;
+    if (options.LoadCheckpointPath && !(checkpointFile.Open(options.LoadCheckpointPath) && checkpoint.Open(checkpointFile.GetData())))
+    {
+        std::printf("%s is not a checkpoint of this version\n", options.LoadCheckpointPath);
+        return EXIT_FAILURE;
+    }
+
+    SwarmCheckpoint const* initialState = options.LoadCheckpointPath ? &checkpoint : nullptr;
+
+    auto loadStart = std::chrono::steady_clock::now();
+    auto swarm = CreateSwarm(options, options.Kernel, options.ThreadCount, initialState);
+    double loadSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - loadStart).count();
+
+    auto reference = options.IsVerifyEnabled ? CreateSwarm(options, KernelWidth::Scalar, 1, initialState) : nullptr;
+    if (!swarm || (options.IsVerifyEnabled && !reference))
+    {
+        std::printf("%s does not describe a valid swarm\n", options.LoadCheckpointPath);
+        return EXIT_FAILURE;
+    }
+
+    if (initialState)
+    {
+        ReadOptions(*swarm, options);
+        checkpointFile.Close();
+    }
+
+    // Moves the predators before every step, warm-up steps included.
+    int stepIndex = 0;
+    auto movePredators = [&]()
+        {
+            if (options.PredatorCount == 0)
+                return;
+
+            auto predators = GetPredatorPositions(options.PredatorCount, stepIndex++);
+            swarm->SetPredators(predators);
+            if (reference)
+                reference->SetPredators(predators);
+        };
+
+    for (int i = 0; i < options.WarmupStepCount; ++i)
+    {
+        movePredators();
+        swarm->Update(options.TimeStep);
+        if (reference)
+            reference->Update(options.TimeStep);
+    }
+
+    TrajectoryRecorder recorder;
+    if (options.RecordPath)
+    {
+        TrajectoryRecorderOptions recorderOptions;
+        recorderOptions.MemoryBudget = static_cast<size_t>(options.RecordBudget) << 20;
+        if (!recorder.Open(options.RecordPath, recorderOptions))
+        {
+            std::printf("%s could not be created\n", options.RecordPath);
+            return EXIT_FAILURE;
+        }
+    }
+
+    // Profile the measured steps only.
+    swarm->GetProfiler().Reset();
+    swarm->GetProfiler().IsTraceEnabled(options.TracePath != nullptr);
+
+    // Only the updates of the measured swarm are timed.
+    std::chrono::steady_clock::duration elapsed{};
+    std::chrono::steady_clock::duration recordElapsed{};
+    std::vector<TrajectoryFrame> recordedStates;    // at the checksum steps, for --verify-record
+    bool isVerified = true;
+    bool isRecordVerified = true;
+
+    for (int i = 1; i <= options.StepCount; ++i)
+    {
+        movePredators();
+
+        auto start = std::chrono::steady_clock::now();
+        cacheMisses.Start();
+        swarm->Update(options.TimeStep);
+        cacheMisses.Stop();
+        elapsed += std::chrono::steady_clock::now() - start;
+
+        if (options.RecordPath)
+        {
+            auto recordStart = std::chrono::steady_clock::now();
+            bool isRecorded = recorder.Record(*swarm, i);
+            recordElapsed += std::chrono::steady_clock::now() - recordStart;
+
+            if (isRecorded && options.IsRecordVerifyEnabled && i % options.ChecksumInterval == 0)
+            {
+                auto& state = recordedStates.emplace_back();
+                state.StepIndex = i;
+                swarm->CopyState(state.Boids, state.Ids);
+            }
+        }
+
+        if (reference)
+            reference->Update(options.TimeStep);
+
+        if (options.ChecksumInterval == 0 || i % options.ChecksumInterval != 0)
+            continue;
+
+        // The checksum depends on the order of the boids, so only runs with the same sort interval compare.
+        uint64_t checksum = swarm->ComputeChecksum();
+        std::printf("step %6d:    checksum %016" PRIx64, i, checksum);
+
+        if (reference)
+        {
+            float difference = GetMaxDifference(*swarm, *reference);
+            bool isIdentical = checksum == reference->ComputeChecksum();
+            bool isWithinTolerance = isIdentical || difference <= options.Tolerance;
+            isVerified = isVerified && isWithinTolerance;
+
+            std::printf(", max difference %g (%s)", difference,
+                isIdentical ? "identical" : isWithinTolerance ? "within tolerance" : "MISMATCH");
+        }
+
+        std::printf("\n");
+    }
+
+    double seconds = std::chrono::duration<double>(elapsed).count();
+    size_t swarmMemory = swarm->GetMemoryUsage();
+    double boidSteps = static_cast<double>(options.BoidCount) * options.StepCount;
+
+    std::printf("boids:          %d\n", options.BoidCount);
+    std::printf("steps:          %d\n", options.StepCount);
+    std::printf("threads:        %u\n", swarm->GetThreadCount());
+    std::printf("kernel:         %s\n", GetKernelName(swarm->GetKernelWidth()));
+    if (options.IsTopologicalEnabled)
+        std::printf("neighbors:      %d nearest\n", options.NeighborCount);
+    else
+        std::printf("neighbors:      %s\n", options.IsVisualRangeEnabled ? "visual range" : "all");
+    std::printf("time step:      %g s\n", options.TimeStep);
+    std::printf("integrator:     %s (up to %d sub-steps)\n", GetIntegratorName(options.Integration), options.MaxSubstepCount);
+    std::printf("sort interval:  %d\n", options.SortInterval);
+    std::printf("species:        %d\n", options.SpeciesCount);
+    std::printf("obstacles:      %d (%d triangles)\n", options.ObstacleCount,
+        options.ObstacleCount * OBSTACLE_STACK_COUNT * OBSTACLE_SLICE_COUNT * 2);
+    std::printf("predators:      %d\n", options.PredatorCount);
+    std::printf("seed:           %" PRIu32 "\n", options.Seed);
+    std::printf("steps/sec:      %.2f\n", options.StepCount / seconds);
+    std::printf("ns/boid-step:   %.2f\n", seconds * 1e9 / boidSteps);
+
+    if (cacheMisses.IsAvailable())
+        std::printf("LLC misses/boid-step: %.2f\n", cacheMisses.GetCount() / boidSteps);
+    else
+        std::printf("LLC misses/boid-step: unavailable\n");
+
+    std::printf("swarm (MiB):    %.2f\n", swarmMemory / (1024.0 * 1024.0));
+    std::printf("bytes/boid:     %.2f\n", static_cast<double>(swarmMemory) / options.BoidCount);
+    std::printf("peak RSS (MiB): %.2f\n", GetPeakResidentSetSize() / (1024.0 * 1024.0));
+
+    if (options.RecordPath)
+    {
+        recorder.Close();
+        PrintRecorderStats(recorder.GetStats(), std::chrono::duration<double>(recordElapsed).count());
+
+        if (options.IsRecordVerifyEnabled)
+            isRecordVerified = VerifyRecording(options.RecordPath, recorder.GetStats(), recordedStates);
+    }
+
+    if (options.LoadCheckpointPath)
+        std::printf("loaded:         %s in %.2f ms\n", options.LoadCheckpointPath, loadSeconds * 1e3);
+
+    if (options.SaveCheckpointPath)
+    {
+        size_t checkpointSize = SaveCheckpoint(*swarm, options);
+        if (checkpointSize > 0)
+            std::printf("saved:          %s (%.2f MiB)\n", options.SaveCheckpointPath, checkpointSize / (1024.0 * 1024.0));
+        else
+            std::printf("saved:          %s could not be written\n", options.SaveCheckpointPath);
+    }
+
+    if ((options.IsProfileEnabled || options.TracePath) && !Swarm::IsProfilingCompiledIn())
+        std::printf("profile:        unavailable; build with BOIDS_ENABLE_PROFILING\n");
+    else
+    {
+        if (options.IsProfileEnabled)
+            PrintProfile(swarm->GetProfiler().GetProfile());
+
+        if (options.TracePath)
+        {
+            std::ofstream trace(options.TracePath);
+            swarm->GetProfiler().WriteChromeTrace(trace);
+            std::printf("trace:          %s\n", trace ? options.TracePath : "could not be written");
+        }
+    }
+
+    if (!isVerified)
+    {
+        std::printf("verification against the scalar reference failed\n");
+        return EXIT_FAILURE;
+    }
+
+    if (!isRecordVerified)
+    {
+        std::printf("verification of the recorded trajectory failed\n");
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
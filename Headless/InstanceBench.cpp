@@ -0,0 +1,210 @@
+// Checks how InstanceBatcher packs world matrices and splits them into batches, then reports the packing time.
+//
+// Usage: instance_bench [--instances N] [--capacity C] [--repeat R]
+//
+// The checks cover an empty set, one instance, exactly one full batch, full batches only, a partial last batch
+// and a zero capacity, which holds one instance per batch. For each, the batches must cover the instances in
+// order without gaps, and every packed instance must transform points like its world matrix. The benchmark then
+// packs N random affine matrices (100000 by default) into batches of C (4096 by default) R times (5 by default)
+// and prints the fastest time. It exits with failure if a check fails.
+
+#include "pch.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+
+#include "InstanceBatcher.h"
+
+using namespace DirectX;
+
+namespace
+{
+    struct Options
+    {
+        int InstanceCount = 100000;
+        int BatchCapacity = 4096;
+        int RepeatCount = 5;
+    };
+
+    void PrintUsage()
+    {
+        std::printf("Usage: instance_bench [--instances N] [--capacity C] [--repeat R]\n");
+    }
+
+    bool ParseOptions(int argc, char* argv[], Options& options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            char const* arg = argv[i];
+            bool hasValue = i + 1 < argc;
+
+            if (std::strcmp(arg, "--instances") == 0 && hasValue)
+                options.InstanceCount = std::atoi(argv[++i]);
+            else if (std::strcmp(arg, "--capacity") == 0 && hasValue)
+                options.BatchCapacity = std::atoi(argv[++i]);
+            else if (std::strcmp(arg, "--repeat") == 0 && hasValue)
+                options.RepeatCount = std::atoi(argv[++i]);
+            else
+                return false;
+        }
+
+        return options.InstanceCount >= 0 && options.BatchCapacity >= 1 && options.RepeatCount >= 1;
+    }
+
+    // Scales, rotates and translates at random, like the world matrices of the boids.
+    std::vector<XMFLOAT4X4> CreateWorldMatrices(int count, uint32_t seed)
+    {
+        std::mt19937 random(seed);
+        std::uniform_real_distribution<float> distribution(-10.0f, 10.0f);
+
+        std::vector<XMFLOAT4X4> matrices(count);
+        for (auto& matrix : matrices)
+        {
+            XMMATRIX world =
+                XMMatrixScaling(1.0f + std::fabs(distribution(random)), 1.0f, 0.5f) *
+                XMMatrixRotationRollPitchYaw(distribution(random), distribution(random), distribution(random)) *
+                XMMatrixTranslation(distribution(random), distribution(random), distribution(random));
+
+            XMStoreFloat4x4(&matrix, world);
+        }
+
+        return matrices;
+    }
+
+    // Transforms a point the way the instanced vertex shader does.
+    XMFLOAT3 TransformPoint(InstanceTransform const& instance, XMFLOAT3 const& p)
+    {
+        auto dot = [&p](XMFLOAT4 const& column) { return p.x * column.x + p.y * column.y + p.z * column.z + column.w; };
+        return XMFLOAT3(dot(instance.Column0), dot(instance.Column1), dot(instance.Column2));
+    }
+
+    // Returns false and prints the reason if the batches or instances do not match the matrices.
+    bool CheckPacking(char const* name, int instanceCount, uint32_t batchCapacity, size_t expectedBatchCount)
+    {
+        std::vector<XMFLOAT4X4> matrices = CreateWorldMatrices(instanceCount, 1);
+
+        InstanceBatcher batcher(batchCapacity);
+        batcher.Pack(matrices);
+
+        auto const batches = batcher.GetBatches();
+        if (batches.size() != expectedBatchCount)
+        {
+            std::printf("%s: %zu batches, expected %zu\n", name, batches.size(), expectedBatchCount);
+            return false;
+        }
+
+        if (batcher.GetInstances().size() != matrices.size())
+        {
+            std::printf("%s: %zu instances, expected %zu\n", name, batcher.GetInstances().size(), matrices.size());
+            return false;
+        }
+
+        // The batches follow each other without gaps, and only the last may be partial.
+        uint32_t nextInstance = 0;
+        for (size_t i = 0; i < batches.size(); ++i)
+        {
+            InstanceBatch const& batch = batches[i];
+            bool isLast = i + 1 == batches.size();
+
+            if (batch.FirstInstance != nextInstance || batch.InstanceCount == 0 ||
+                batch.InstanceCount > batcher.GetBatchCapacity() || (!isLast && batch.InstanceCount != batcher.GetBatchCapacity()))
+            {
+                std::printf("%s: batch %zu covers [%u, %u)\n", name, i, batch.FirstInstance, batch.FirstInstance + batch.InstanceCount);
+                return false;
+            }
+
+            if (batcher.GetInstances(batch).data() != batcher.GetInstances().data() + batch.FirstInstance)
+            {
+                std::printf("%s: batch %zu does not view its instances\n", name, i);
+                return false;
+            }
+
+            nextInstance += batch.InstanceCount;
+        }
+
+        if (nextInstance != matrices.size())
+        {
+            std::printf("%s: the batches cover %u of %zu instances\n", name, nextInstance, matrices.size());
+            return false;
+        }
+
+        const XMFLOAT3 point(0.25f, -1.5f, 2.0f);
+        for (size_t i = 0; i < matrices.size(); ++i)
+        {
+            XMFLOAT3 expected;
+            XMStoreFloat3(&expected, XMVector3TransformCoord(XMLoadFloat3(&point), XMLoadFloat4x4(&matrices[i])));
+            XMFLOAT3 actual = TransformPoint(batcher.GetInstances()[i], point);
+
+            float error = std::fabs(actual.x - expected.x) + std::fabs(actual.y - expected.y) + std::fabs(actual.z - expected.z);
+            if (error > 1e-4f)
+            {
+                std::printf("%s: instance %zu moves the point by %g from its world matrix\n", name, i, error);
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Returns false if any check fails. Each check packs fresh matrices into a new batcher.
+    bool RunChecks()
+    {
+        bool isCorrect = true;
+        isCorrect = CheckPacking("empty", 0, 16, 0) && isCorrect;
+        isCorrect = CheckPacking("one instance", 1, 16, 1) && isCorrect;
+        isCorrect = CheckPacking("one full batch", 16, 16, 1) && isCorrect;
+        isCorrect = CheckPacking("full batches", 48, 16, 3) && isCorrect;
+        isCorrect = CheckPacking("partial last batch", 50, 16, 4) && isCorrect;
+        isCorrect = CheckPacking("zero capacity", 3, 0, 3) && isCorrect;
+
+        // Packing again replaces the previous instances and batches.
+        InstanceBatcher batcher(16);
+        batcher.Pack(CreateWorldMatrices(50, 2));
+        batcher.Pack({});
+        if (!batcher.GetInstances().empty() || !batcher.GetBatches().empty())
+        {
+            std::printf("repack: the previous instances are left over\n");
+            isCorrect = false;
+        }
+
+        return isCorrect;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    if (!ParseOptions(argc, argv, options))
+    {
+        PrintUsage();
+        return EXIT_FAILURE;
+    }
+
+    if (!RunChecks())
+        return EXIT_FAILURE;
+
+    std::printf("instance batching checks passed\n");
+
+    std::vector<XMFLOAT4X4> matrices = CreateWorldMatrices(options.InstanceCount, 3);
+    InstanceBatcher batcher(options.BatchCapacity);
+    double bestSeconds = HUGE_VAL;
+
+    for (int i = 0; i < options.RepeatCount; ++i)
+    {
+        auto start = std::chrono::steady_clock::now();
+        batcher.Pack(matrices);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        bestSeconds = std::min(bestSeconds, seconds);
+    }
+
+    std::printf("packed %d instances into %zu batches of up to %u in %.3f ms (%.2f ns per instance)\n",
+        options.InstanceCount, batcher.GetBatches().size(), batcher.GetBatchCapacity(), bestSeconds * 1e3,
+        options.InstanceCount > 0 ? bestSeconds * 1e9 / options.InstanceCount : 0.0);
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,365 @@
+// Builds the mesh generators' geometry without a GPU and reports its size and build time.
+//
+// Usage: mesh_bench [--max-level L] [--repeat R] [--filter NAME] [--threads N] [--optimize] [--overdraw T]
+//                   [--model FILE]
+//
+// Runs every MeshBuilder primitive, textured and colored, at tessellation levels 1 to L (6 by default). At
+// level k, round meshes have 4 * 2^k slices and 2 * 2^k stacks, grids have 4 * 2^k quads a side, stars have
+// 4 * 2^k arms and geospheres are subdivided k times. The colored geosphere is built with its vertices shared
+// between neighbouring triangles and without, as ColorMeshGenerator does with and without weldVertices. The
+// model is a textured sphere of the same level, written out in the model file format and parsed back. Meshes
+// without a level are built once per run. Each build is repeated R times (5 by default) and the fastest is
+// reported. --filter keeps the primitives whose names contain NAME. --threads N builds the cylinders, spheres,
+// grids and pipes on a pool of N threads (0 for one per hardware thread) and checks each against a serial build.
+// --optimize runs MeshOptimizer on each mesh and adds its vertex cache ACMR and ATVR before and after, and the
+// time it took; --overdraw T also sorts the triangles for overdraw with threshold T, e.g. 1.05. --model FILE
+// measures a model file instead of the written sphere; its texture coordinates are read if the VertexList line
+// mentions them, as in "VertexList (pos, normal, tex)".
+
+#include "pch.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cwchar>
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <memory>
+
+#include "MeshBuilder.h"
+#include "MeshOptimizer.h"
+#include "ThreadPool.h"
+
+namespace
+{
+    struct Options
+    {
+        int MaxLevel = 6;
+        int RepeatCount = 5;
+        char const* Filter = "";
+        int ThreadCount = 1;
+        bool Optimize = false;
+        float OverdrawThreshold = 0.0f;
+        char const* ModelFile = nullptr;
+    };
+
+    struct BuildResult
+    {
+        size_t VertexCount = 0;
+        size_t IndexCount = 0;
+        size_t ByteCount = 0;
+        double Seconds = 0.0;
+        MeshOptimizationResult Optimization;
+        double OptimizeSeconds = 0.0;
+    };
+
+    template<typename Data>
+    struct Primitive
+    {
+        char const* Name;
+        bool IsTessellated;
+        std::function<void(Data& data, uint32_t level, ThreadPool* threadPool)> Build;
+    };
+
+    void PrintUsage()
+    {
+        std::printf("Usage: mesh_bench [--max-level L] [--repeat R] [--filter NAME] [--threads N] [--optimize] [--overdraw T]\n");
+        std::printf("                  [--model FILE]\n");
+    }
+
+    bool ParseOptions(int argc, char* argv[], Options& options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            char const* arg = argv[i];
+            bool hasValue = i + 1 < argc;
+
+            if (std::strcmp(arg, "--max-level") == 0 && hasValue)
+                options.MaxLevel = std::atoi(argv[++i]);
+            else if (std::strcmp(arg, "--repeat") == 0 && hasValue)
+                options.RepeatCount = std::atoi(argv[++i]);
+            else if (std::strcmp(arg, "--filter") == 0 && hasValue)
+                options.Filter = argv[++i];
+            else if (std::strcmp(arg, "--threads") == 0 && hasValue)
+                options.ThreadCount = std::atoi(argv[++i]);
+            else if (std::strcmp(arg, "--optimize") == 0)
+                options.Optimize = true;
+            else if (std::strcmp(arg, "--overdraw") == 0 && hasValue)
+                options.OverdrawThreshold = static_cast<float>(std::atof(argv[++i]));
+            else if (std::strcmp(arg, "--model") == 0 && hasValue)
+                options.ModelFile = argv[++i];
+            else
+                return false;
+        }
+
+        // Sorting for overdraw is part of the optimization.
+        options.Optimize = options.Optimize || options.OverdrawThreshold > 0.0f;
+
+        return options.MaxLevel >= 1 && options.RepeatCount >= 1 && options.ThreadCount >= 0 && options.OverdrawThreshold >= 0.0f;
+    }
+
+    uint32_t GetSliceCount(uint32_t level) { return 4u << level; }
+    uint32_t GetStackCount(uint32_t level) { return 2u << level; }
+
+    // Writes a mesh in the format that CreateModel reads.
+    std::vector<std::wstring> WriteModel(TextureMeshData const& data)
+    {
+        std::vector<std::wstring> lines;
+        lines.reserve(data.Vertices.size() + data.Indices.size() / 3 + 8);
+
+        lines.push_back(L"VertexCount: " + std::to_wstring(data.Vertices.size()));
+        lines.push_back(L"TriangleCount: " + std::to_wstring(data.Indices.size() / 3));
+        lines.push_back(L"VertexList (pos, normal, tex)");
+        lines.push_back(L"{");
+
+        wchar_t line[256];
+        for (auto const& v : data.Vertices)
+        {
+            std::swprintf(line, std::size(line), L"\t%f %f %f %f %f %f %f %f",
+                v.Position.x, v.Position.y, v.Position.z, v.Normal.x, v.Normal.y, v.Normal.z, v.Texture.x, v.Texture.y);
+            lines.push_back(line);
+        }
+
+        lines.push_back(L"}");
+        lines.push_back(L"TriangleList");
+        lines.push_back(L"{");
+
+        for (size_t i = 0; i < data.Indices.size(); i += 3)
+        {
+            std::swprintf(line, std::size(line), L"\t%u %u %u", data.Indices[i], data.Indices[i + 1], data.Indices[i + 2]);
+            lines.push_back(line);
+        }
+
+        lines.push_back(L"}");
+        return lines;
+    }
+
+    std::vector<Primitive<TextureMeshData>> GetTexturePrimitives()
+    {
+        return
+        {
+            { "cube", false, [](TextureMeshData& data, uint32_t, ThreadPool*) { MeshBuilder::CreateCube(data, "mesh"); } },
+            { "simple cube", false, [](TextureMeshData& data, uint32_t, ThreadPool*) { MeshBuilder::CreateSimpleCube(data, "mesh"); } },
+            { "pyramid", false, [](TextureMeshData& data, uint32_t, ThreadPool*) { MeshBuilder::CreatePyramid(data, "mesh"); } },
+            { "simple pyramid", false, [](TextureMeshData& data, uint32_t, ThreadPool*) { MeshBuilder::CreateSimplePyramid(data, "mesh"); } },
+            { "quad", false, [](TextureMeshData& data, uint32_t, ThreadPool*) { MeshBuilder::CreateQuad(data, "mesh"); } },
+            { "cylinder", true, [](TextureMeshData& data, uint32_t level, ThreadPool* threadPool)
+                { MeshBuilder::CreateCylinder(data, "mesh", 1.0f, 0.5f, 2.0f, GetSliceCount(level), GetStackCount(level), threadPool); } },
+            { "sphere", true, [](TextureMeshData& data, uint32_t level, ThreadPool* threadPool)
+                { MeshBuilder::CreateSphere(data, "mesh", 1.0f, GetSliceCount(level), GetStackCount(level), threadPool); } },
+            { "geosphere", true, [](TextureMeshData& data, uint32_t level, ThreadPool*)
+                { MeshBuilder::CreateGeosphere(data, "mesh", 1.0f, static_cast<uint16_t>(level)); } },
+            { "grid", true, [](TextureMeshData& data, uint32_t level, ThreadPool* threadPool)
+                { MeshBuilder::CreateGrid(data, "mesh", 10.0f, 10.0f, GetSliceCount(level), GetSliceCount(level), threadPool); } },
+            { "pipe", true, [](TextureMeshData& data, uint32_t level, ThreadPool* threadPool)
+                { MeshBuilder::CreatePipe(data, "mesh", 1.0f, 2.0f, GetSliceCount(level), GetStackCount(level), true, threadPool); } },
+            { "star", true, [](TextureMeshData& data, uint32_t level, ThreadPool*)
+                { MeshBuilder::CreateStar(data, "mesh", GetSliceCount(level), 0.5f, 1.0f, 0.2f); } },
+        };
+    }
+
+    std::vector<Primitive<ColorMeshData>> GetColorPrimitives()
+    {
+        return
+        {
+            { "color cube", false, [](ColorMeshData& data, uint32_t, ThreadPool*) { MeshBuilder::CreateCube(data, "mesh"); } },
+            { "color pyramid", false, [](ColorMeshData& data, uint32_t, ThreadPool*) { MeshBuilder::CreatePyramid(data, "mesh"); } },
+            { "color cylinder", true, [](ColorMeshData& data, uint32_t level, ThreadPool* threadPool)
+                { MeshBuilder::CreateCylinder(data, "mesh", 1.0f, 0.5f, 2.0f, GetSliceCount(level), GetStackCount(level), threadPool); } },
+            { "color sphere", true, [](ColorMeshData& data, uint32_t level, ThreadPool* threadPool)
+                { MeshBuilder::CreateSphere(data, "mesh", 1.0f, GetSliceCount(level), GetStackCount(level), threadPool); } },
+            { "color geosphere", true, [](ColorMeshData& data, uint32_t level, ThreadPool*)
+                { MeshBuilder::CreateGeosphere(data, "mesh", 1.0f, static_cast<uint16_t>(level), true); } },
+            { "color geosphere unwelded", true, [](ColorMeshData& data, uint32_t level, ThreadPool*)
+                { MeshBuilder::CreateGeosphere(data, "mesh", 1.0f, static_cast<uint16_t>(level), false); } },
+            { "color grid", true, [](ColorMeshData& data, uint32_t level, ThreadPool* threadPool)
+                { MeshBuilder::CreateGrid(data, "mesh", 10.0f, 10.0f, GetSliceCount(level), GetSliceCount(level), threadPool); } },
+        };
+    }
+
+    template<typename Data>
+    BuildResult Measure(std::function<void(Data& data)> const& build, Options const& options)
+    {
+        BuildResult result;
+        result.Seconds = HUGE_VAL;
+        result.OptimizeSeconds = HUGE_VAL;
+
+        for (int i = 0; i < options.RepeatCount; ++i)
+        {
+            Data data;
+
+            auto start = std::chrono::steady_clock::now();
+            build(data);
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+            result.Seconds = std::min(result.Seconds, seconds);
+            result.VertexCount = data.Vertices.size();
+            result.IndexCount = data.Indices.size();
+            result.ByteCount = data.Vertices.size() * sizeof(data.Vertices[0]) + data.Indices.size() * sizeof(uint32_t);
+
+            if (options.Optimize)
+            {
+                start = std::chrono::steady_clock::now();
+                result.Optimization = MeshOptimizer::Optimize(data, data.Meshes.begin()->second, options.OverdrawThreshold);
+                seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+                result.OptimizeSeconds = std::min(result.OptimizeSeconds, seconds);
+            }
+        }
+
+        return result;
+    }
+
+    template<typename Data>
+    bool IsSameMesh(Data const& a, Data const& b)
+    {
+        return a.Vertices.size() == b.Vertices.size() && a.Indices == b.Indices &&
+            std::memcmp(a.Vertices.data(), b.Vertices.data(), a.Vertices.size() * sizeof(a.Vertices[0])) == 0;
+    }
+
+    void PrintHeader(Options const& options)
+    {
+        std::printf("%-26s %5s %10s %10s %8s %9s", "primitive", "level", "vertices", "triangles", "MiB", "ms");
+        if (options.Optimize)
+            std::printf(" %13s %13s %9s", "acmr", "atvr", "opt ms");
+
+        std::printf("\n");
+    }
+
+    void PrintResult(char const* name, int level, BuildResult const& result, Options const& options)
+    {
+        char levelText[16] = "-";
+        if (level > 0)
+            std::snprintf(levelText, sizeof(levelText), "%d", level);
+
+        std::printf("%-26s %5s %10zu %10zu %8.2f %9.3f",
+            name, levelText, result.VertexCount, result.IndexCount / 3,
+            result.ByteCount / (1024.0 * 1024.0), result.Seconds * 1e3);
+
+        if (options.Optimize)
+        {
+            MeshOptimizationResult const& optimization = result.Optimization;
+            std::printf(" %5.3f > %5.3f %5.3f > %5.3f %9.3f",
+                optimization.Before.Acmr, optimization.After.Acmr, optimization.Before.Atvr, optimization.After.Atvr,
+                result.OptimizeSeconds * 1e3);
+        }
+
+        std::printf("\n");
+    }
+
+    // Returns false if a parallel build differs from the serial one.
+    template<typename Data>
+    bool RunPrimitives(std::vector<Primitive<Data>> const& primitives, Options const& options, ThreadPool* threadPool)
+    {
+        bool isSame = true;
+
+        for (auto const& primitive : primitives)
+        {
+            if (std::strstr(primitive.Name, options.Filter) == nullptr)
+                continue;
+
+            int levelCount = primitive.IsTessellated ? options.MaxLevel : 1;
+            for (int level = 1; level <= levelCount; ++level)
+            {
+                auto build = [&](Data& data) { primitive.Build(data, level, threadPool); };
+                BuildResult result = Measure<Data>(build, options);
+                PrintResult(primitive.Name, primitive.IsTessellated ? level : 0, result, options);
+
+                if (threadPool != nullptr)
+                {
+                    Data serial;
+                    Data parallel;
+                    primitive.Build(serial, level, nullptr);
+                    primitive.Build(parallel, level, threadPool);
+
+                    if (!IsSameMesh(serial, parallel))
+                    {
+                        std::printf("%s %d: the parallel build differs from the serial one\n", primitive.Name, level);
+                        isSame = false;
+                    }
+                }
+            }
+        }
+
+        return isSame;
+    }
+
+    // Returns false if the model file cannot be read.
+    bool RunModelFile(Options const& options)
+    {
+        std::ifstream file(options.ModelFile);
+        if (!file)
+        {
+            std::printf("Cannot open %s\n", options.ModelFile);
+            return false;
+        }
+
+        // The model files are ASCII, so each char widens to one wchar_t.
+        std::vector<std::wstring> lines;
+        bool hasTexture = false;
+        for (std::string line; std::getline(file, line); )
+        {
+            // "VertexList" itself contains "tex", so the search starts after it.
+            size_t listPosition = line.find("VertexList");
+            if (listPosition != std::string::npos)
+                hasTexture = line.find("tex", listPosition + std::strlen("VertexList")) != std::string::npos;
+
+            lines.emplace_back(line.begin(), line.end());
+        }
+
+        auto build = [&](TextureMeshData& data) { MeshBuilder::CreateModel(data, "mesh", lines, hasTexture); };
+        PrintResult("model", 0, Measure<TextureMeshData>(build, options), options);
+        return true;
+    }
+
+    // Returns false if the model file cannot be read.
+    bool RunModel(Options const& options)
+    {
+        if (std::strstr("model", options.Filter) == nullptr)
+            return true;
+
+        if (options.ModelFile != nullptr)
+            return RunModelFile(options);
+
+        for (int level = 1; level <= options.MaxLevel; ++level)
+        {
+            TextureMeshData sphere;
+            MeshBuilder::CreateSphere(sphere, "sphere", 1.0f, GetSliceCount(level), GetStackCount(level));
+            std::vector<std::wstring> lines = WriteModel(sphere);
+
+            auto build = [&](TextureMeshData& data) { MeshBuilder::CreateModel(data, "mesh", lines, true); };
+            PrintResult("model", level, Measure<TextureMeshData>(build, options), options);
+        }
+
+        return true;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    if (!ParseOptions(argc, argv, options))
+    {
+        PrintUsage();
+        return EXIT_FAILURE;
+    }
+
+    // The builder stops subdividing colored geospheres past this level.
+    options.MaxLevel = std::min(options.MaxLevel, int{ MeshBuilder::MAX_COLOR_GEOSPHERE_SUBDIVISION_COUNT });
+
+    std::printf("mesh builds, fastest of %d, %s\n", options.RepeatCount, options.ThreadCount == 1 ? "serial" : "on a thread pool");
+    PrintHeader(options);
+
+    std::unique_ptr<ThreadPool> threadPool;
+    if (options.ThreadCount != 1)
+        threadPool = std::make_unique<ThreadPool>(options.ThreadCount);
+
+    bool isSame = RunPrimitives(GetTexturePrimitives(), options, threadPool.get());
+    bool isModelRead = RunModel(options);
+    isSame = RunPrimitives(GetColorPrimitives(), options, threadPool.get()) && isSame;
+
+    return isSame && isModelRead ? EXIT_SUCCESS : EXIT_FAILURE;
+}
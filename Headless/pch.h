@@ -0,0 +1,17 @@
+#pragma once
+
+// Stands in for the demos' precompiled headers when the platform-independent sources are built
+// without WinRT and Direct3D, for example by the CMake targets.
+
+#include <DirectXMath.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Run-time assertion. ASSERT is evaluated only in Debug builds.
+#define ASSERT assert
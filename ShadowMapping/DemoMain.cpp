@@ -68,8 +68,8 @@ void DemoMain::StartRenderLoop()
             }
         });
 
-    // Run task on a dedicated high priority background thread.
-    m_renderLoopWorker = ThreadPool::RunAsync(workItemHandler, WorkItemPriority::High, WorkItemOptions::TimeSliced);
+    // Run task on a dedicated high priority background thread of the WinRT thread pool.
+    m_renderLoopWorker = winrt::Windows::System::Threading::ThreadPool::RunAsync(workItemHandler, WorkItemPriority::High, WorkItemOptions::TimeSliced);
 }
 
 void DemoMain::StopRenderLoop()
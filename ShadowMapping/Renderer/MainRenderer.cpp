@@ -32,6 +32,9 @@ winrt::Windows::Foundation::IAsyncAction MainRenderer::CreateDeviceDependentReso
     m_meshGenerator->CreateCube("cube");
     m_meshGenerator->CreateCylinder("cylinder", 0.5f, 0.3f, 5.0f, 30, 20);
     m_meshGenerator->CreateGeosphere("sphere", 1.0f, 4);
+
+    // The scene is opaque, so the triangles can also be sorted to hide more of each other.
+    m_meshGenerator->OptimizeMeshes(1.05f);
     m_meshGenerator->CreateBuffers();
 }
 
@@ -0,0 +1,352 @@
+#include "pch.h"
+#include "Bvh.h"
+
+#include <cfloat>
+
+using namespace DirectX;
+
+namespace
+{
+    // Returns the point of the triangle closest to p. From Ericson (2004), "Real-Time Collision Detection", 5.1.5.
+    XMVECTOR GetClosestPointOnTriangle(FXMVECTOR p, FXMVECTOR a, FXMVECTOR b, GXMVECTOR c)
+    {
+        XMVECTOR ab = b - a;
+        XMVECTOR ac = c - a;
+        XMVECTOR ap = p - a;
+
+        float d1 = XMVectorGetX(XMVector3Dot(ab, ap));
+        float d2 = XMVectorGetX(XMVector3Dot(ac, ap));
+        if (d1 <= 0.f && d2 <= 0.f)
+            return a;
+
+        XMVECTOR bp = p - b;
+        float d3 = XMVectorGetX(XMVector3Dot(ab, bp));
+        float d4 = XMVectorGetX(XMVector3Dot(ac, bp));
+        if (d3 >= 0.f && d4 <= d3)
+            return b;
+
+        float vc = d1 * d4 - d3 * d2;
+        if (vc <= 0.f && d1 >= 0.f && d3 <= 0.f)
+            return a + (d1 / (d1 - d3)) * ab;
+
+        XMVECTOR cp = p - c;
+        float d5 = XMVectorGetX(XMVector3Dot(ab, cp));
+        float d6 = XMVectorGetX(XMVector3Dot(ac, cp));
+        if (d6 >= 0.f && d5 <= d6)
+            return c;
+
+        float vb = d5 * d2 - d1 * d6;
+        if (vb <= 0.f && d2 >= 0.f && d6 <= 0.f)
+            return a + (d2 / (d2 - d6)) * ac;
+
+        float va = d3 * d6 - d5 * d4;
+        if (va <= 0.f && (d4 - d3) >= 0.f && (d5 - d6) >= 0.f)
+            return b + ((d4 - d3) / ((d4 - d3) + (d5 - d6))) * (c - b);
+
+        float denominator = 1.f / (va + vb + vc);
+        return a + ab * (vb * denominator) + ac * (vc * denominator);
+    }
+
+    // Returns the distance along the ray to the triangle, or a negative value if the ray misses it.
+    // Moeller and Trumbore (1997), "Fast, Minimum Storage Ray/Triangle Intersection".
+    float IntersectRayTriangle(FXMVECTOR origin, FXMVECTOR direction, FXMVECTOR a, GXMVECTOR b, HXMVECTOR c)
+    {
+        const float EPSILON = 1e-8f;
+
+        XMVECTOR ab = b - a;
+        XMVECTOR ac = c - a;
+        XMVECTOR p = XMVector3Cross(direction, ac);
+        float determinant = XMVectorGetX(XMVector3Dot(ab, p));
+        if (std::fabs(determinant) < EPSILON)
+            return -1.f;
+
+        float inverseDeterminant = 1.f / determinant;
+        XMVECTOR t = origin - a;
+        float u = XMVectorGetX(XMVector3Dot(t, p)) * inverseDeterminant;
+        if (u < 0.f || u > 1.f)
+            return -1.f;
+
+        XMVECTOR q = XMVector3Cross(t, ab);
+        float v = XMVectorGetX(XMVector3Dot(direction, q)) * inverseDeterminant;
+        if (v < 0.f || u + v > 1.f)
+            return -1.f;
+
+        return XMVectorGetX(XMVector3Dot(ac, q)) * inverseDeterminant;
+    }
+
+    // Returns the squared distance from the point to the box; zero if the point is inside.
+    float GetDistanceSq(XMFLOAT3 const& point, XMFLOAT3 const& min, XMFLOAT3 const& max)
+    {
+        float dx = std::max(std::max(min.x - point.x, point.x - max.x), 0.f);
+        float dy = std::max(std::max(min.y - point.y, point.y - max.y), 0.f);
+        float dz = std::max(std::max(min.z - point.z, point.z - max.z), 0.f);
+        return dx * dx + dy * dy + dz * dz;
+    }
+
+    // Returns the distance along the ray to where it enters the box, or FLT_MAX if it misses the box.
+    float IntersectRayBox(XMFLOAT3 const& origin, XMFLOAT3 const& inverseDirection, XMFLOAT3 const& min, XMFLOAT3 const& max)
+    {
+        float o[] = { origin.x, origin.y, origin.z };
+        float d[] = { inverseDirection.x, inverseDirection.y, inverseDirection.z };
+        float lo[] = { min.x, min.y, min.z };
+        float hi[] = { max.x, max.y, max.z };
+
+        float enter = 0.f;
+        float exit = FLT_MAX;
+
+        for (int c = 0; c < 3; ++c)
+        {
+            float t0 = (lo[c] - o[c]) * d[c];
+            float t1 = (hi[c] - o[c]) * d[c];
+            enter = std::max(enter, std::min(t0, t1));
+            exit = std::min(exit, std::max(t0, t1));
+        }
+
+        return enter <= exit ? enter : FLT_MAX;
+    }
+}
+
+void Bvh::Build(DirectX::XMFLOAT3 const* positions, [[maybe_unused]] size_t vertexCount, uint32_t const* indices, size_t indexCount)
+{
+    uint32_t triangleCount = static_cast<uint32_t>(indexCount / 3);
+
+    m_triangles.resize(triangleCount);
+    m_nodes.clear();
+    m_nodes.reserve(triangleCount > 0 ? 2 * triangleCount - 1 : 0);
+
+    for (uint32_t t = 0; t < triangleCount; ++t)
+    {
+        ASSERT(indices[3 * t] < vertexCount && indices[3 * t + 1] < vertexCount && indices[3 * t + 2] < vertexCount);
+
+        auto& triangle = m_triangles[t];
+        triangle.A = positions[indices[3 * t]];
+        triangle.B = positions[indices[3 * t + 1]];
+        triangle.C = positions[indices[3 * t + 2]];
+        triangle.Index = t;
+
+        // Degenerate triangles get a zero normal, which never rejects them.
+        XMVECTOR normal = XMVector3Cross(XMLoadFloat3(&triangle.B) - XMLoadFloat3(&triangle.A), XMLoadFloat3(&triangle.C) - XMLoadFloat3(&triangle.A));
+        float length = XMVectorGetX(XMVector3Length(normal));
+        XMStoreFloat3(&triangle.Normal, length > 0.f ? normal / length : XMVectorZero());
+
+        // The sphere around the centroid is not the smallest, but it is close for the well-shaped triangles of meshes.
+        XMVECTOR centroid = (XMLoadFloat3(&triangle.A) + XMLoadFloat3(&triangle.B) + XMLoadFloat3(&triangle.C)) / 3.f;
+        XMStoreFloat3(&triangle.Centre, centroid);
+        triangle.Radius = 0.f;
+        for (auto const* vertex : { &triangle.A, &triangle.B, &triangle.C })
+            triangle.Radius = std::max(triangle.Radius, XMVectorGetX(XMVector3Length(XMLoadFloat3(vertex) - centroid)));
+    }
+
+    if (triangleCount == 0)
+        return;
+
+    // The nodes split a list of triangle indices, so each split moves four bytes per triangle. The triangles
+    // are put in leaf order once the tree is complete.
+    std::vector<uint32_t> order(triangleCount);
+    for (uint32_t t = 0; t < triangleCount; ++t)
+        order[t] = t;
+
+    BuildNode(order, 0, triangleCount);
+
+    std::vector<Triangle> triangles(triangleCount);
+    for (uint32_t t = 0; t < triangleCount; ++t)
+        triangles[t] = m_triangles[order[t]];
+
+    m_triangles.swap(triangles);
+}
+
+// Adds the node for the triangles order[begin, end) and its descendants. Returns the index of the node.
+uint32_t Bvh::BuildNode(std::vector<uint32_t>& order, uint32_t begin, uint32_t end)
+{
+    uint32_t index = static_cast<uint32_t>(m_nodes.size());
+    m_nodes.emplace_back();
+
+    XMVECTOR min = XMVectorReplicate(FLT_MAX);
+    XMVECTOR max = XMVectorReplicate(-FLT_MAX);
+    XMVECTOR centroidMin = min;
+    XMVECTOR centroidMax = max;
+
+    for (uint32_t t = begin; t < end; ++t)
+    {
+        auto const& triangle = m_triangles[order[t]];
+        for (auto const* vertex : { &triangle.A, &triangle.B, &triangle.C })
+        {
+            min = XMVectorMin(min, XMLoadFloat3(vertex));
+            max = XMVectorMax(max, XMLoadFloat3(vertex));
+        }
+
+        centroidMin = XMVectorMin(centroidMin, XMLoadFloat3(&triangle.Centre));
+        centroidMax = XMVectorMax(centroidMax, XMLoadFloat3(&triangle.Centre));
+    }
+
+    XMStoreFloat3(&m_nodes[index].Min, min);
+    XMStoreFloat3(&m_nodes[index].Max, max);
+
+    if (end - begin <= TRIANGLES_PER_LEAF)
+    {
+        m_nodes[index].Offset = begin;
+        m_nodes[index].Count = end - begin;
+        return index;
+    }
+
+    // Split at the median centroid along the axis the centroids spread the most.
+    XMFLOAT3 extent;
+    XMStoreFloat3(&extent, centroidMax - centroidMin);
+    int axis = (extent.x >= extent.y && extent.x >= extent.z) ? 0 : (extent.y >= extent.z ? 1 : 2);
+
+    auto getCoordinate = [axis](XMFLOAT3 const& value) { return axis == 0 ? value.x : (axis == 1 ? value.y : value.z); };
+
+    uint32_t mid = (end - begin) / 2;
+    std::nth_element(order.begin() + begin, order.begin() + begin + mid, order.begin() + end, [&](uint32_t a, uint32_t b)
+        {
+            return getCoordinate(m_triangles[a].Centre) < getCoordinate(m_triangles[b].Centre);
+        });
+
+    BuildNode(order, begin, begin + mid);
+    uint32_t second = BuildNode(order, begin + mid, end);
+
+    m_nodes[index].Offset = second;
+    m_nodes[index].Count = 0;
+    return index;
+}
+
+bool Bvh::FindClosestPoint(DirectX::FXMVECTOR point, float maxDistance, BvhClosestPoint& result) const
+{
+    if (m_nodes.empty())
+        return false;
+
+    float bestDistanceSq = maxDistance * maxDistance;
+    bool isFound = false;
+
+    // The stack holds the nodes with the squared distance to their boxes, so each box is measured once.
+    struct Entry
+    {
+        uint32_t    Node;
+        float       DistanceSq;
+    };
+
+    XMFLOAT3 p;
+    XMStoreFloat3(&p, point);
+
+    Entry stack[MAX_DEPTH];
+    int stackSize = 0;
+    stack[stackSize++] = { 0, GetDistanceSq(p, m_nodes[0].Min, m_nodes[0].Max) };
+
+    while (stackSize > 0)
+    {
+        Entry entry = stack[--stackSize];
+        if (entry.DistanceSq >= bestDistanceSq)
+            continue;
+
+        uint32_t nodeIndex = entry.Node;
+        Node const& node = m_nodes[nodeIndex];
+
+        if (node.Count > 0)
+        {
+            for (uint32_t t = node.Offset; t < node.Offset + node.Count; ++t)
+            {
+                auto const& triangle = m_triangles[t];
+
+                // No point of the triangle is nearer than its plane or its bounding sphere, both cheap to test.
+                float planeDistance =
+                    (p.x - triangle.A.x) * triangle.Normal.x + (p.y - triangle.A.y) * triangle.Normal.y + (p.z - triangle.A.z) * triangle.Normal.z;
+                if (planeDistance * planeDistance >= bestDistanceSq)
+                    continue;
+
+                float dx = p.x - triangle.Centre.x;
+                float dy = p.y - triangle.Centre.y;
+                float dz = p.z - triangle.Centre.z;
+                float sphereDistance = std::sqrt(dx * dx + dy * dy + dz * dz) - triangle.Radius;
+                if (sphereDistance > 0.f && sphereDistance * sphereDistance >= bestDistanceSq)
+                    continue;
+
+                XMVECTOR closest = GetClosestPointOnTriangle(point, XMLoadFloat3(&triangle.A), XMLoadFloat3(&triangle.B), XMLoadFloat3(&triangle.C));
+                float distanceSq = XMVectorGetX(XMVector3LengthSq(point - closest));
+
+                if (distanceSq < bestDistanceSq)
+                {
+                    bestDistanceSq = distanceSq;
+                    XMStoreFloat3(&result.Position, closest);
+                    result.Triangle = triangle.Index;
+                    isFound = true;
+                }
+            }
+
+            continue;
+        }
+
+        // Visit the nearer child first; it is more likely to shrink the search radius.
+        Entry first = { nodeIndex + 1, GetDistanceSq(p, m_nodes[nodeIndex + 1].Min, m_nodes[nodeIndex + 1].Max) };
+        Entry second = { node.Offset, GetDistanceSq(p, m_nodes[node.Offset].Min, m_nodes[node.Offset].Max) };
+        if (second.DistanceSq < first.DistanceSq)
+            std::swap(first, second);
+
+        if (second.DistanceSq < bestDistanceSq)
+            stack[stackSize++] = second;
+        if (first.DistanceSq < bestDistanceSq)
+            stack[stackSize++] = first;
+    }
+
+    if (isFound)
+        result.Distance = std::sqrt(bestDistanceSq);
+
+    return isFound;
+}
+
+bool Bvh::Raycast(DirectX::FXMVECTOR origin, DirectX::FXMVECTOR direction, float maxDistance, BvhRayHit& hit) const
+{
+    if (m_nodes.empty())
+        return false;
+
+    XMFLOAT3 rayOrigin, inverseDirection;
+    XMStoreFloat3(&rayOrigin, origin);
+    XMStoreFloat3(&inverseDirection, XMVectorReciprocal(direction));
+
+    float bestDistance = maxDistance;
+    bool isHit = false;
+
+    uint32_t stack[MAX_DEPTH];
+    int stackSize = 0;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0)
+    {
+        uint32_t nodeIndex = stack[--stackSize];
+        Node const& node = m_nodes[nodeIndex];
+
+        if (IntersectRayBox(rayOrigin, inverseDirection, node.Min, node.Max) > bestDistance)
+            continue;
+
+        if (node.Count > 0)
+        {
+            for (uint32_t t = node.Offset; t < node.Offset + node.Count; ++t)
+            {
+                auto const& triangle = m_triangles[t];
+                float distance = IntersectRayTriangle(origin, direction, XMLoadFloat3(&triangle.A), XMLoadFloat3(&triangle.B), XMLoadFloat3(&triangle.C));
+
+                if (distance >= 0.f && distance < bestDistance)
+                {
+                    bestDistance = distance;
+                    hit.Triangle = triangle.Index;
+                    isHit = true;
+                }
+            }
+
+            continue;
+        }
+
+        uint32_t first = nodeIndex + 1;
+        uint32_t second = node.Offset;
+        if (IntersectRayBox(rayOrigin, inverseDirection, m_nodes[second].Min, m_nodes[second].Max) <
+            IntersectRayBox(rayOrigin, inverseDirection, m_nodes[first].Min, m_nodes[first].Max))
+            std::swap(first, second);
+
+        stack[stackSize++] = second;
+        stack[stackSize++] = first;
+    }
+
+    if (isHit)
+        hit.Distance = bestDistance;
+
+    return isHit;
+}
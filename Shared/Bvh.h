@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// The point on the geometry closest to a query point, found by Bvh::FindClosestPoint.
+struct BvhClosestPoint
+{
+    DirectX::XMFLOAT3   Position;
+    float               Distance;
+    uint32_t            Triangle;   // the index of the triangle in the order of the input indices
+};
+
+// The first intersection of a ray with the geometry, found by Bvh::Raycast.
+struct BvhRayHit
+{
+    float               Distance;   // along the ray, in units of the length of the ray direction
+    uint32_t            Triangle;
+};
+
+// A bounding volume hierarchy over static triangles. It answers the nearest-point queries of moving agents,
+// such as boids avoiding obstacles, and ray queries, such as picking, in logarithmic time. The tree is built
+// once by splitting the triangles at the median of their centroids along the widest axis. It does not depend
+// on Direct3D and takes plain arrays, so it also builds in the renderers, which are C++17.
+class Bvh
+{
+public:
+    // Builds the hierarchy over the triangles given by the index list. Replaces any previous geometry.
+    void Build(DirectX::XMFLOAT3 const* positions, size_t vertexCount, uint32_t const* indices, size_t indexCount);
+
+    // Builds the hierarchy over the positions of the vertices of a mesh, e.g. VertexPositionNormalTexture.
+    template<typename TVertex>
+    void Build(TVertex const* vertices, size_t vertexCount, uint32_t const* indices, size_t indexCount);
+
+    // Finds the point on the triangles closest to the given point, if it is closer than the maximum distance.
+    bool FindClosestPoint(DirectX::FXMVECTOR point, float maxDistance, BvhClosestPoint& result) const;
+
+    // Finds the first triangle the ray hits, if it hits one before the maximum distance. Both sides of the
+    // triangles count.
+    bool Raycast(DirectX::FXMVECTOR origin, DirectX::FXMVECTOR direction, float maxDistance, BvhRayHit& hit) const;
+
+    // Accessors
+    bool IsEmpty() const { return m_triangles.empty(); }
+    size_t GetTriangleCount() const { return m_triangles.size(); }
+    size_t GetNodeCount() const { return m_nodes.size(); }
+
+private:
+    // Leaves hold this many triangles or fewer.
+    static const uint32_t TRIANGLES_PER_LEAF = 4;
+
+    // The deepest a query can descend. Median splits halve the triangles at each level, so this allows
+    // for far more triangles than fit in memory.
+    static const int MAX_DEPTH = 64;
+
+    // An interior node has its first child right after it and its second child at Offset. A leaf holds
+    // Count triangles starting at Offset.
+    struct Node
+    {
+        DirectX::XMFLOAT3   Min;
+        uint32_t            Offset;
+        DirectX::XMFLOAT3   Max;
+        uint32_t            Count;      // zero for interior nodes
+    };
+
+    struct Triangle
+    {
+        DirectX::XMFLOAT3   A;
+        DirectX::XMFLOAT3   B;
+        DirectX::XMFLOAT3   C;
+        DirectX::XMFLOAT3   Normal;     // of unit length
+        DirectX::XMFLOAT3   Centre;     // of a sphere around the triangle
+        float               Radius;
+        uint32_t            Index;
+    };
+
+    std::vector<Node>       m_nodes;
+    std::vector<Triangle>   m_triangles;    // in leaf order
+
+    uint32_t BuildNode(std::vector<uint32_t>& order, uint32_t begin, uint32_t end);
+};
+
+template<typename TVertex>
+void Bvh::Build(TVertex const* vertices, size_t vertexCount, uint32_t const* indices, size_t indexCount)
+{
+    std::vector<DirectX::XMFLOAT3> positions(vertexCount);
+    for (size_t i = 0; i < vertexCount; ++i)
+        positions[i] = vertices[i].Position;
+
+    Build(positions.data(), vertexCount, indices, indexCount);
+}
@@ -1,7 +1,8 @@
 #pragma once
 
 #include "DeviceResources.h"
-#include "VertexStructures.h"
+#include "MeshData.h"
+#include "ThreadPool.h"
 
 class ColorMeshGenerator
 {
@@ -12,7 +13,7 @@ public:
     void CreatePyramid(std::string const& name);
     void CreateCylinder(std::string const& name, float bottomRadius, float topRadius, float cylinderHeight, uint32_t sliceCount, uint32_t stackCount);
     void CreateSphere(std::string const& name, float radius, uint32_t sliceCount, uint32_t stackCount);
-    void CreateGeosphere(std::string const& name, float radius, uint16_t subdivisionCount);
+    void CreateGeosphere(std::string const& name, float radius, uint16_t subdivisionCount, bool weldVertices = true);
     void CreateGrid(std::string const& name, float gridWidth, float gridDepth, uint32_t quadCountHoriz, uint32_t quadCountDepth);
 
     void CreateBuffers();
@@ -21,25 +22,14 @@ public:
     void Clear();
 
 private:
-    struct MeshInfo
-    {
-        uint32_t IndexCount;
-        uint32_t StartIndexLocation;
-        uint32_t BaseVertexLocation;
-    };
-
     std::shared_ptr<DX::DeviceResources>    m_deviceResources;
 
     winrt::com_ptr<ID3D11Buffer>            m_vertexBuffer;
     winrt::com_ptr<ID3D11Buffer>            m_indexBuffer;
 
-    std::vector<VertexPositionColor>        m_vertices;
-    std::vector<uint32_t>                   m_indices;
-    std::map<std::string, MeshInfo>         m_meshes;
+    ColorMeshData                           m_meshData;
+    std::unique_ptr<ThreadPool>             m_threadPool;   // builds large meshes in parallel; released once they are uploaded
 
-    void BuildCylinderTopCap(uint32_t baseVertexLocation, float topRadius, float cylinderHeight, uint32_t sliceCount);
-    void BuildCylinderBottomCap(uint32_t baseVertexLocation, float bottomRadius, float cylinderHeight, uint32_t sliceCount);
-    void Subdivide(std::vector<VertexPositionColor>& vertices, std::vector<uint32_t>& indices);
-    void CopyIndices(std::vector<uint32_t> const& indices, uint32_t startIndexLocation, size_t indexCount);
+    ThreadPool* GetThreadPool(size_t indexCount);
 };
 
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Maps the undirected edges of a mesh to vertex indices, such as the midpoint made when an edge is split. The
+// table is a flat array with open addressing and linear probing, so a lookup touches a cache line or two and
+// allocates nothing, where a std::map walks a tree of nodes. Reset it with the number of edges to expect and
+// it never rehashes.
+class EdgeTable
+{
+public:
+    // Empties the table and makes room for the given number of edges.
+    void Reset(size_t edgeCount)
+    {
+        size_t capacity = 16;
+        int shift = 60;
+        while (capacity < 2 * edgeCount)
+        {
+            capacity *= 2;
+            --shift;
+        }
+
+        m_entries.assign(capacity, Entry{ EMPTY_KEY, 0 });
+        m_mask = capacity - 1;
+        m_shift = shift;
+        m_size = 0;
+    }
+
+    // Returns the vertex stored for the edge between vertices a and b, in either order. If there is none yet,
+    // stores the given vertex instead and returns it. The flag is true if the vertex was stored.
+    std::pair<uint32_t, bool> Insert(uint32_t a, uint32_t b, uint32_t vertex)
+    {
+        if (2 * (m_size + 1) > m_entries.size())
+            Grow();
+
+        uint64_t key = GetKey(a, b);
+        for (size_t slot = GetSlot(key); ; slot = (slot + 1) & m_mask)
+        {
+            Entry& entry = m_entries[slot];
+            if (entry.Key == key)
+                return { entry.Vertex, false };
+
+            if (entry.Key == EMPTY_KEY)
+            {
+                entry = Entry{ key, vertex };
+                ++m_size;
+                return { vertex, true };
+            }
+        }
+    }
+
+    // Accessors
+    size_t Size() const { return m_size; }
+
+private:
+    // No edge joins a vertex to itself, so this key is never used.
+    static const uint64_t EMPTY_KEY = UINT64_MAX;
+
+    struct Entry
+    {
+        uint64_t    Key;
+        uint32_t    Vertex;
+    };
+
+    std::vector<Entry>  m_entries;
+    size_t              m_mask = 0;
+    int                 m_shift = 64;   // keeps the top bits of the hash, as many as index the entries
+    size_t              m_size = 0;
+
+    static uint64_t GetKey(uint32_t a, uint32_t b)
+    {
+        return a < b ? (uint64_t{ a } << 32 | b) : (uint64_t{ b } << 32 | a);
+    }
+
+    // Fibonacci hashing spreads the keys of neighbouring edges over the whole table. Only the top bits of the
+    // product depend on every bit of the key.
+    size_t GetSlot(uint64_t key) const
+    {
+        return static_cast<size_t>((key * 0x9e3779b97f4a7c15ull) >> m_shift);
+    }
+
+    void Grow()
+    {
+        std::vector<Entry> entries;
+        entries.swap(m_entries);
+        Reset(entries.size());
+
+        for (Entry const& entry : entries)
+        {
+            if (entry.Key == EMPTY_KEY)
+                continue;
+
+            size_t slot = GetSlot(entry.Key);
+            while (m_entries[slot].Key != EMPTY_KEY)
+                slot = (slot + 1) & m_mask;
+
+            m_entries[slot] = entry;
+            ++m_size;
+        }
+    }
+};
@@ -0,0 +1,34 @@
+#include "pch.h"
+#include "InstanceBatcher.h"
+
+using namespace DirectX;
+
+InstanceBatcher::InstanceBatcher(uint32_t batchCapacity) :
+    m_batchCapacity(std::max(batchCapacity, 1u))
+{
+}
+
+void InstanceBatcher::Pack(std::span<DirectX::XMFLOAT4X4 const> worldMatrices)
+{
+    m_instances.resize(worldMatrices.size());
+
+    for (size_t i = 0; i < worldMatrices.size(); ++i)
+    {
+        auto const& m = worldMatrices[i];
+        auto& instance = m_instances[i];
+        instance.Column0 = XMFLOAT4(m._11, m._21, m._31, m._41);
+        instance.Column1 = XMFLOAT4(m._12, m._22, m._32, m._42);
+        instance.Column2 = XMFLOAT4(m._13, m._23, m._33, m._43);
+    }
+
+    m_batches.clear();
+
+    uint32_t instanceCount = static_cast<uint32_t>(m_instances.size());
+    for (uint32_t first = 0; first < instanceCount; first += m_batchCapacity)
+        m_batches.push_back({ first, std::min(m_batchCapacity, instanceCount - first) });
+}
+
+std::span<InstanceTransform const> InstanceBatcher::GetInstances(InstanceBatch const& batch) const
+{
+    return GetInstances().subspan(batch.FirstInstance, batch.InstanceCount);
+}
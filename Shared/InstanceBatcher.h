@@ -0,0 +1,44 @@
+#pragma once
+
+#include <span>
+#include <vector>
+
+// The per-instance data of an instanced draw: the first three columns of an affine world matrix in the
+// row-vector convention of XMMATRIX. The fourth column of an affine matrix is always (0, 0, 0, 1), so it
+// is not stored. A shader transforms a point p with dot(float4(p, 1), ColumnN) for each component.
+struct InstanceTransform
+{
+    DirectX::XMFLOAT4 Column0;
+    DirectX::XMFLOAT4 Column1;
+    DirectX::XMFLOAT4 Column2;
+};
+
+// A range of instances drawn with a single draw call.
+struct InstanceBatch
+{
+    uint32_t FirstInstance;
+    uint32_t InstanceCount;
+};
+
+// Packs world matrices into instance data and splits them into batches that fit into an instance buffer.
+// It does not depend on Direct3D, so the packing and batching can be tested without a GPU.
+class InstanceBatcher
+{
+public:
+    // The batch capacity is the number of instances the instance buffer can hold.
+    explicit InstanceBatcher(uint32_t batchCapacity);
+
+    // Packs the world matrices, which must be affine, and replaces the previous instances and batches.
+    void Pack(std::span<DirectX::XMFLOAT4X4 const> worldMatrices);
+
+    // Accessors
+    uint32_t GetBatchCapacity() const { return m_batchCapacity; }
+    std::span<InstanceTransform const> GetInstances() const { return m_instances; }
+    std::span<InstanceTransform const> GetInstances(InstanceBatch const& batch) const;
+    std::span<InstanceBatch const> GetBatches() const { return m_batches; }
+
+private:
+    uint32_t                        m_batchCapacity;
+    std::vector<InstanceTransform>  m_instances;
+    std::vector<InstanceBatch>      m_batches;
+};
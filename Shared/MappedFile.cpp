@@ -0,0 +1,101 @@
+#include "pch.h"
+#include "MappedFile.h"
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::~MappedFile()
+{
+    Close();
+}
+
+#if defined(_WIN32)
+
+// The FromApp functions are available to UWP apps as well as to desktop ones.
+bool MappedFile::Open(std::filesystem::path const& path)
+{
+    Close();
+
+    HANDLE file = CreateFile2(path.c_str(), GENERIC_READ, FILE_SHARE_READ, OPEN_EXISTING, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size{};
+    HANDLE mapping = nullptr;
+    if (GetFileSizeEx(file, &size) && size.QuadPart > 0)
+        mapping = CreateFileMappingFromApp(file, nullptr, PAGE_READONLY, 0, nullptr);
+
+    // The mapping keeps the file open.
+    CloseHandle(file);
+    if (!mapping)
+        return false;
+
+    void* data = MapViewOfFileFromApp(mapping, FILE_MAP_READ, 0, 0);
+    if (!data)
+    {
+        CloseHandle(mapping);
+        return false;
+    }
+
+    m_mapping = mapping;
+    m_data = static_cast<std::byte const*>(data);
+    m_size = static_cast<size_t>(size.QuadPart);
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (m_data)
+        UnmapViewOfFile(m_data);
+    if (m_mapping)
+        CloseHandle(m_mapping);
+
+    m_data = nullptr;
+    m_size = 0;
+    m_mapping = nullptr;
+}
+
+#else
+
+bool MappedFile::Open(std::filesystem::path const& path)
+{
+    Close();
+
+    int file = open(path.c_str(), O_RDONLY);
+    if (file < 0)
+        return false;
+
+    struct stat status{};
+    void* data = MAP_FAILED;
+    if (fstat(file, &status) == 0 && status.st_size > 0)
+        data = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+
+    // The mapping keeps the file open.
+    close(file);
+    if (data == MAP_FAILED)
+        return false;
+
+    m_data = static_cast<std::byte const*>(data);
+    m_size = static_cast<size_t>(status.st_size);
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (m_data)
+        munmap(const_cast<std::byte*>(m_data), m_size);
+
+    m_data = nullptr;
+    m_size = 0;
+}
+
+#endif
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+// Maps a file into memory read-only, so its contents can be used in place without reading them into a buffer.
+// Pages are loaded on first access and shared with the file cache. The mapping lasts until the object is
+// destroyed or another file is opened.
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(MappedFile const&) = delete;
+    MappedFile& operator=(MappedFile const&) = delete;
+
+    // Maps the whole file. Returns false if the file cannot be opened or mapped, or is empty.
+    bool Open(std::filesystem::path const& path);
+    void Close();
+
+    // The contents of the file, aligned to a page.
+    std::span<std::byte const> GetData() const { return { m_data, m_size }; }
+
+private:
+    std::byte const*    m_data = nullptr;
+    size_t              m_size = 0;
+#if defined(_WIN32)
+    void*               m_mapping = nullptr;
+#endif
+};
@@ -0,0 +1,2052 @@
+#include "pch.h"
+#include <algorithm>
+#include <cmath>
+
+#include "MeshBuilder.h"
+#include "EdgeTable.h"
+#include "MeshSubdivision.h"
+#include "ThreadPool.h"
+
+using namespace DirectX;
+
+/// <summary>
+/// Creates a unit cube with 24 vertices. This is sufficient to define 
+/// textures on each cube's face.
+/// </summary>
+void MeshBuilder::CreateCube(TextureMeshData& data, std::string const& name)
+{
+    ASSERT(data.Meshes.find(name) == data.Meshes.end());
+
+    MeshInfo info;
+    info.BaseVertexLocation = (uint32_t)data.Vertices.size();
+    info.StartIndexLocation = (uint32_t)data.Indices.size();
+
+    auto i = info.BaseVertexLocation;
+    data.Vertices.resize(i + 24);
+
+    float l = 0.5f, n = 1.0f;
+
+    // front face
+    data.Vertices[i++] = { XMFLOAT3(-l, -l, -l), XMFLOAT3(0, 0, -n), XMFLOAT2(0.0f, 1.0f) };
+    data.Vertices[i++] = { XMFLOAT3(-l,  l, -l), XMFLOAT3(0, 0, -n), XMFLOAT2(0.0f, 0.0f) };
+    data.Vertices[i++] = { XMFLOAT3( l,  l, -l), XMFLOAT3(0, 0, -n), XMFLOAT2(1.0f, 0.0f) };
+    data.Vertices[i++] = { XMFLOAT3( l, -l, -l), XMFLOAT3(0, 0, -n), XMFLOAT2(1.0f, 1.0f) };
+
+    // back face
+    data.Vertices[i++] = { XMFLOAT3(-l, -l,  l), XMFLOAT3(0, 0, n), XMFLOAT2(1.0f, 1.0f) };
+    data.Vertices[i++] = { XMFLOAT3( l, -l,  l), XMFLOAT3(0, 0, n), XMFLOAT2(0.0f, 1.0f) };
+    data.Vertices[i++] = { XMFLOAT3( l,  l,  l), XMFLOAT3(0, 0, n), XMFLOAT2(0.0f, 0.0f) };
+    data.Vertices[i++] = { XMFLOAT3(-l,  l,  l), XMFLOAT3(0, 0, n), XMFLOAT2(1.0f, 0.0f) };
+
+    // top face
+    data.Vertices[i++] = { XMFLOAT3(-l,  l, -l), XMFLOAT3(0, n, 0), XMFLOAT2(0.0f, 1.0f) };
+    data.Vertices[i++] = { XMFLOAT3(-l,  l,  l), XMFLOAT3(0, n, 0), XMFLOAT2(0.0f, 0.0f) };
+    data.Vertices[i++] = { XMFLOAT3( l,  l,  l), XMFLOAT3(0, n, 0), XMFLOAT2(1.0f, 0.0f) };
+    data.Vertices[i++] = { XMFLOAT3( l,  l, -l), XMFLOAT3(0, n, 0), XMFLOAT2(1.0f, 1.0f) };
+
+    // bottom face
+    data.Vertices[i++] = { XMFLOAT3(-l, -l, -l), XMFLOAT3(0, -n, 0), XMFLOAT2(1.0f, 1.0f) };
+    data.Vertices[i++] = { XMFLOAT3( l, -l, -l), XMFLOAT3(0, -n, 0), XMFLOAT2(0.0f, 1.0f) };
+    data.Vertices[i++] = { XMFLOAT3( l, -l,  l), XMFLOAT3(0, -n, 0), XMFLOAT2(0.0f, 0.0f) };
+    data.Vertices[i++] = { XMFLOAT3(-l, -l,  l), XMFLOAT3(0, -n, 0), XMFLOAT2(1.0f, 0.0f) };
+
+    // left face
+    data.Vertices[i++] = { XMFLOAT3(-l, -l,  l), XMFLOAT3(-n, 0, 0), XMFLOAT2(0.0f, 1.0f) };
+    data.Vertices[i++] = { XMFLOAT3(-l,  l,  l), XMFLOAT3(-n, 0, 0), XMFLOAT2(0.0f, 0.0f) };
+    data.Vertices[i++] = { XMFLOAT3(-l,  l, -l), XMFLOAT3(-n, 0, 0), XMFLOAT2(1.0f, 0.0f) };
+    data.Vertices[i++] = { XMFLOAT3(-l, -l, -l), XMFLOAT3(-n, 0, 0), XMFLOAT2(1.0f, 1.0f) };
+
+    // right face
+    data.Vertices[i++] = { XMFLOAT3( l, -l, -l), XMFLOAT3(n, 0, 0), XMFLOAT2(0.0f, 1.0f) };
+    data.Vertices[i++] = { XMFLOAT3( l,  l, -l), XMFLOAT3(n, 0, 0), XMFLOAT2(0.0f, 0.0f) };
+    data.Vertices[i++] = { XMFLOAT3( l,  l,  l), XMFLOAT3(n, 0, 0), XMFLOAT2(1.0f, 0.0f) };
+    data.Vertices[i++] = { XMFLOAT3( l, -l,  l), XMFLOAT3(n, 0, 0), XMFLOAT2(1.0f, 1.0f) };
+
+    ASSERT(data.Vertices.size() == i);
+
+    std::vector<uint32_t> indices =
+    {
+        // front face
+        0, 1, 2,
+        0, 2, 3,
+
+        // back face
+        4, 5, 6,
+        4, 6, 7,
+
+        // top face
+        8, 9, 10,
+        8, 10, 11,
+
+        // bottom face
+        12, 13, 14,
+        12, 14, 15,
+
+        // left face
+        16, 17, 18,
+        16, 18, 19,
+
+        // right face
+        20, 21, 22,
+        20, 22, 23,
+    };
+
+    info.IndexCount = (uint32_t)indices.size();
+    CopyIndices(data.Indices, indices, info.StartIndexLocation, info.IndexCount);
+
+    data.Meshes[name] = info;
+}
+
+/// <summary>
+/// Creates a unit cube i.e., a cube whose sides are 1 unit long. The simple cube has 8 vertices
+/// which is not sufficient to define a texture on every face.
+/// </summary>
+void MeshBuilder::CreateSimpleCube(TextureMeshData& data, std::string const& name)
+{
+    ASSERT(data.Meshes.find(name) == data.Meshes.end());
+
+    MeshInfo info;
+    info.BaseVertexLocation = (uint32_t)data.Vertices.size();
+    info.StartIndexLocation = (uint32_t)data.Indices.size();
+
+    auto i = info.BaseVertexLocation;
+    data.Vertices.resize(i + 8); // a cube has 8 vertices
+
+    float l = 0.5f, n = 1.0f / sqrtf(3.0f); // all coordinates of the normals have the value n
+    data.Vertices[i++] = { XMFLOAT3(-l, -l, -l), XMFLOAT3(-n, -n, -n) };
+    data.Vertices[i++] = { XMFLOAT3(-l, -l,  l), XMFLOAT3(-n, -n,  n) };
+    data.Vertices[i++] = { XMFLOAT3(-l,  l, -l), XMFLOAT3(-n,  n, -n) };
+    data.Vertices[i++] = { XMFLOAT3(-l,  l,  l), XMFLOAT3(-n,  n,  n) };
+    data.Vertices[i++] = { XMFLOAT3(l, -l, -l), XMFLOAT3(n, -n, -n) };
+    data.Vertices[i++] = { XMFLOAT3(l, -l,  l), XMFLOAT3(n, -n,  n) };
+    data.Vertices[i++] = { XMFLOAT3(l,  l, -l), XMFLOAT3(n,  n, -n) };
+    data.Vertices[i++] = { XMFLOAT3(l,  l,  l), XMFLOAT3(n,  n,  n) };
+
+    ASSERT(data.Vertices.size() == i);
+
+    std::vector<uint32_t> indices =
+    {
+        0, 1, 2, // -x
+        1, 3, 2,
+
+        4, 6, 5, // +x
+        5, 6, 7,
+
+        0, 5, 1, // -y
+        0, 4, 5,
+
+        2, 7, 6, // +y
+        2, 3, 7,
+
+        0, 6, 4, // -z
+        0, 2, 6,
+
+        1, 7, 3, // +z
+        1, 5, 7,
+    };
+
+    info.IndexCount = (uint32_t)indices.size();
+    CopyIndices(data.Indices, indices, info.StartIndexLocation, info.IndexCount);
+
+    data.Meshes[name] = info;
+}
+
+/// <summary>
+/// Creates a pyramid with 18 vertices. This is sufficient to define 
+/// textures on each pyramid's face.
+/// </summary>
+void MeshBuilder::CreatePyramid(TextureMeshData& data, std::string const& name)
+{
+    ASSERT(data.Meshes.find(name) == data.Meshes.end());
+
+    MeshInfo info;
+    info.BaseVertexLocation = (uint32_t)data.Vertices.size();
+    info.StartIndexLocation = (uint32_t)data.Indices.size();
+
+    auto i = info.BaseVertexLocation;
+    data.Vertices.resize(i + 18); // a pyramid with additonal vertices has 18 vertices
+
+    // vertices
+    float l = 0.5f;
+    XMFLOAT3 v0 = {  0,  l,  0 };
+    XMFLOAT3 v1 = { -l, -l, -l };
+    XMFLOAT3 v2 = {  l, -l, -l };
+    XMFLOAT3 v3 = {  l, -l,  l };
+    XMFLOAT3 v4 = { -l, -l,  l };
+
+    // normals
+    XMFLOAT3 n0; XMStoreFloat3(&n0, ComputeNormal(v0, v2, v1)); // front
+    XMFLOAT3 n1; XMStoreFloat3(&n1, ComputeNormal(v0, v3, v2)); // right
+    XMFLOAT3 n2; XMStoreFloat3(&n2, ComputeNormal(v0, v4, v3)); // back
+    XMFLOAT3 n3; XMStoreFloat3(&n3, ComputeNormal(v0, v1, v4)); // left
+    XMFLOAT3 n4; XMStoreFloat3(&n4, ComputeNormal(v1, v2, v3)); // bottom
+    XMFLOAT3 n5; XMStoreFloat3(&n5, ComputeNormal(v1, v3, v4)); // bottom (should be the same as n4)
+
+    // front
+    data.Vertices[i++] = { v0, n0, XMFLOAT2(1.0f, 1.0f) };
+    data.Vertices[i++] = { v2, n0, XMFLOAT2(0.0f, 1.0f) };
+    data.Vertices[i++] = { v1, n0, XMFLOAT2(0.5f, 0.0f) };
+
+    // right
+    data.Vertices[i++] = { v0, n1, XMFLOAT2(1.0f, 1.0f) };
+    data.Vertices[i++] = { v3, n1, XMFLOAT2(0.0f, 1.0f) };
+    data.Vertices[i++] = { v2, n1, XMFLOAT2(0.5f, 0.0f) };
+
+    // back
+    data.Vertices[i++] = { v0, n2, XMFLOAT2(1.0f, 1.0f) };
+    data.Vertices[i++] = { v4, n2, XMFLOAT2(0.0f, 1.0f) };
+    data.Vertices[i++] = { v3, n2, XMFLOAT2(0.5f, 0.0f) };
+
+    // left
+    data.Vertices[i++] = { v0, n3, XMFLOAT2(1.0f, 1.0f) };
+    data.Vertices[i++] = { v1, n3, XMFLOAT2(0.0f, 1.0f) };
+    data.Vertices[i++] = { v4, n3, XMFLOAT2(0.5f, 0.0f) };
+
+    // bottom - one half (bottom is a rectangle composed of two triangles)
+    data.Vertices[i++] = { v1, n4, XMFLOAT2(1.0f, 1.0f) };
+    data.Vertices[i++] = { v2, n4, XMFLOAT2(0.0f, 1.0f) };
+    data.Vertices[i++] = { v3, n4, XMFLOAT2(0.5f, 0.0f) };
+
+    // bottom- another half
+    data.Vertices[i++] = { v1, n5 };
+    data.Vertices[i++] = { v3, n5 };
+    data.Vertices[i++] = { v4, n5 };
+
+    ASSERT(data.Vertices.size() == i);
+
+    std::vector<uint32_t> indices =
+    {
+        0, 1, 2,
+        3, 4, 5,
+        6, 7, 8,
+        9, 10, 11,
+
+        12, 13, 14,
+        15, 16, 17
+    };
+
+    info.IndexCount = (uint32_t)indices.size();
+    CopyIndices(data.Indices, indices, info.StartIndexLocation, info.IndexCount);
+
+    data.Meshes[name] = info;
+}
+
+/// <summary>
+/// Creates a pyramid. The pyramid's base is a unit square. The simple pyramid has 5 vertices
+/// which is not sufficient to define a texture on every face.
+/// [Luna] Ex.4 p.242 Construct the vertex and index list of a pyramid.
+/// </summary>
+void MeshBuilder::CreateSimplePyramid(TextureMeshData& data, std::string const& name)
+{
+    ASSERT(data.Meshes.find(name) == data.Meshes.end());
+
+    MeshInfo info;
+    info.BaseVertexLocation = (uint32_t)data.Vertices.size();
+    info.StartIndexLocation = (uint32_t)data.Indices.size();
+
+    auto i = info.BaseVertexLocation;
+    data.Vertices.resize(i + 5); // the pyramid has 5 vertices
+
+    // Define pyramid's vertices.
+    const float l = 0.5f;
+    float a = sqrt(2.0f);
+    data.Vertices[i++] = { XMFLOAT3(0.0f, l, 0.0f), XMFLOAT3(0.0f, 0.1f, 0.0f) };
+    data.Vertices[i++] = { XMFLOAT3( l, -l,  l), XMFLOAT3( a, -l,  a) };
+    data.Vertices[i++] = { XMFLOAT3( l, -l, -l), XMFLOAT3( a, -l, -a) };
+    data.Vertices[i++] = { XMFLOAT3(-l, -l, -l), XMFLOAT3(-a, -l, -a) };
+    data.Vertices[i++] = { XMFLOAT3(-l, -l,  l), XMFLOAT3(-a, -l,  a) };
+
+    ASSERT(data.Vertices.size() == i);
+
+    std::vector<uint32_t> indices =
+    {
+        0, 1, 2,
+        0, 2, 3,
+        0, 3, 4,
+        0, 4, 1,
+
+        2, 1, 3,
+        3, 1, 4,
+    };
+
+    info.IndexCount = (uint32_t)indices.size();
+    CopyIndices(data.Indices, indices, info.StartIndexLocation, info.IndexCount);
+
+    data.Meshes[name] = info;
+}
+
+void MeshBuilder::CopyIndices(std::vector<uint32_t>& target, std::vector<uint32_t> const& indices, uint32_t startIndexLocation, size_t indexCount)
+{
+    target.resize(startIndexLocation + indexCount);
+
+    for (size_t i = 0; i < indexCount; ++i)
+        target[startIndexLocation + i] = indices[i];
+}
+
+/// <summary>
+/// Based on [Luna]
+/// 
+/// Creates a cylinder centered at the origin and parallel to the y-axis. The cylinder is composed of
+/// stacks placed vertically one on another. The bottom stack has a cap as its base. Similarily,
+/// the top stack has a cap as its top. We build the cylinder starting from the bottom stack.
+/// 
+/// An example of a cylinder with 3 stacks:
+///    ____
+///   /    \
+///  /      \
+/// /________\
+///
+/// Note that in the above cylinder the radii of the top and bottom caps differ.
+/// </summary>
+/// <param name="bottomRadius">The radius of the bottom cap</param>
+/// <param name="topRadius">The radius of the top cap</param>
+/// <param name="cylinderHeight">The cylider's height</param>
+/// <param name="sliceCount">The number of slices. A slice is one triangle in the top or the bottom cap.</param>
+/// <param name="stackCount">The number of stacks. A stack is one vertical segment of the cylinder.</param>
+/// <param name="threadPool">The pool that builds the stacks in parallel, or nullptr to build them serially</param>
+void MeshBuilder::CreateCylinder(TextureMeshData& data, std::string const& name, float bottomRadius, float topRadius, float cylinderHeight, uint32_t sliceCount, uint32_t stackCount, ThreadPool* threadPool)
+{
+    ASSERT(data.Meshes.find(name) == data.Meshes.end());
+
+    MeshInfo info;
+    info.BaseVertexLocation = (uint32_t)data.Vertices.size();
+    info.StartIndexLocation = (uint32_t)data.Indices.size();
+
+    // Increase the number of vertices per stack by one because we duplicate the first vertex.
+    auto n = sliceCount + 1;
+
+    // The stacks share stackCount + 1 rings of vertices and have two triangles per slice. Each cap has its own
+    // ring, a center vertex and one triangle per slice.
+    uint32_t stackVertexCount = (stackCount + 1) * n;
+    uint32_t stackIndexCount = stackCount * sliceCount * 6;
+    uint32_t capVertexCount = n + 1;
+    uint32_t capIndexCount = sliceCount * 3;
+
+    data.Vertices.resize(info.BaseVertexLocation + stackVertexCount + 2 * capVertexCount);
+    data.Indices.resize(info.StartIndexLocation + stackIndexCount + 2 * capIndexCount);
+    VertexPositionNormalTexture* vertices = data.Vertices.data() + info.BaseVertexLocation;
+    uint32_t* indices = data.Indices.data() + info.StartIndexLocation;
+
+    float stackHeight = cylinderHeight / stackCount;
+
+    // Calculate the "top" angle of a single slice triangle.
+    float theta = XM_2PI / sliceCount;
+
+    // Calculate the difference between the radii of two consecutive stacks.
+    // This difference may be positive, negative, or zero depending on the relative
+    // sizes of the top and bottom caps.
+    float radiusDelta = (topRadius - bottomRadius) / stackCount;
+
+    // The angles and normals are the same in every stack, so compute them once per slice.
+    std::vector<float> cosines(n);
+    std::vector<float> sines(n);
+    std::vector<XMFLOAT3> normals(n);
+
+    for (uint32_t j = 0; j <= sliceCount; ++j)
+    {
+        float c = cosf(j * theta);
+        float s = sinf(j * theta);
+
+        // Computing Tangent Space Basis Vectors for an Arbitrary Mesh 
+        // "Foundations of Game Engine Development, Volume 2: Rendering"
+
+        // Cylinder can be parameterized as follows, where v [0,1] parameter 
+        // goes in the same direction as the v tex-coord so that 
+        // the bitangent goes in the same direction as the v tex-coord.
+        //
+        // Let r0 be the bottom radius and let r1 be the top radius.
+        //
+        //  y(v) = h - hv             (from top to bottom: y(v) [h,0])
+        //  r(v) = r1 + (r0-r1)v      (from top radius to bottom radius: r(v) [r1,r0])
+        //
+        //  x(t, v) = r(v)*cos(t)
+        //  y(t, v) = h - hv
+        //  z(t, v) = r(v)*sin(t)
+        // 
+        //  tangent
+        //  -------
+        //  dx/dt = -r(v)*sin(t)
+        //  dy/dt = 0
+        //  dz/dt = +r(v)*cos(t)
+        //
+        //  bitangent
+        //  ---------
+        //  dx/dv = (r0-r1)*cos(t)
+        //  dy/dv = -h
+        //  dz/dv = (r0-r1)*sin(t)
+
+        // Calculate a unit length tangent.
+        XMFLOAT3 tangent = XMFLOAT3(-s, 0.0f, c);
+
+        // Calculate a bitangent.
+        float dr = bottomRadius - topRadius;
+        XMFLOAT3 bitangent(dr * c, -cylinderHeight, dr * s);
+
+        // Vectors t, b, n are mutually perpendicular. Use cross product to find normal: n = t x b
+        XMVECTOR t = XMLoadFloat3(&tangent);
+        XMVECTOR b = XMLoadFloat3(&bitangent);
+        XMVECTOR normal = XMVector3Normalize(XMVector3Cross(t, b));
+        XMStoreFloat3(&normals[j], normal);
+
+        cosines[j] = c;
+        sines[j] = s;
+    }
+
+    // Generate vertices for each stack starting at the bottom stack. We use <= rater than <
+    // because we want to generate vertices for the top of the last (top) stack.
+    ParallelFor(threadPool, stackCount + 1, n, [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                // Calculate the y-coordinate of the i-th stack base (or the top of the last stack).
+                float y = -0.5f * cylinderHeight + i * stackHeight;
+
+                // Calculate the radius of the i-th stack base (or the radius of the top of the last stack).
+                float r = bottomRadius + i * radiusDelta;
+
+                // Create vertices for the i-th stack. Note that we duplicate the first vertex as 
+                // the last one by using <= rather than < 
+                // This is necessary for correct texture rendering.
+                for (uint32_t j = 0; j <= sliceCount; ++j)
+                {
+                    VertexPositionNormalTexture& vertex = vertices[i * n + j];
+                    vertex.Position = XMFLOAT3(r * cosines[j], y, r * sines[j]);
+                    vertex.Normal = normals[j];
+
+                    // Compute texture coordinates for the cylider mesh.
+                    vertex.Texture.x = (float)j / sliceCount;
+                    vertex.Texture.y = 1.0f - (float)i / stackCount;
+                }
+            }
+        });
+
+    BuildStackIndices(indices, sliceCount, stackCount, false, threadPool);
+
+    BuildCylinderTopCap(vertices + stackVertexCount, indices + stackIndexCount,
+        stackVertexCount, topRadius, cylinderHeight, sliceCount);
+    BuildCylinderBottomCap(vertices + stackVertexCount + capVertexCount, indices + stackIndexCount + capIndexCount,
+        stackVertexCount + capVertexCount, bottomRadius, cylinderHeight, sliceCount);
+
+    info.IndexCount = (uint32_t)data.Indices.size() - info.StartIndexLocation;
+
+    data.Meshes[name] = info;
+}
+
+// Writes the sliceCount + 2 vertices and sliceCount triangles of the top cap. The first cap vertex has the given index.
+void MeshBuilder::BuildCylinderTopCap(VertexPositionNormalTexture* vertices, uint32_t* indices, uint32_t baseIndex, float topRadius, float cylinderHeight, uint32_t sliceCount)
+{
+    float y = 0.5f * cylinderHeight; // the y-coordinate of the top cap
+    float theta = XM_2PI / sliceCount;
+
+    VertexPositionNormalTexture vertex;
+
+    // Duplicate top cap vertices because the texture coordinates and normals differ.
+    for (uint32_t i = 0; i <= sliceCount; ++i)
+    {
+        float x = topRadius * cosf(i * theta);
+        float z = topRadius * sinf(i * theta);
+
+        // Scale down by the height to make the top cap texture proportional to the base.
+        float u = x / cylinderHeight + 0.5f;
+        float v = z / cylinderHeight + 0.5f;
+
+        vertex.Position = XMFLOAT3(x, y, z);
+        vertex.Normal = XMFLOAT3(0.0f, 1.0f, 0.0f);
+        vertex.Texture = XMFLOAT2(u, v);
+        vertices[i] = vertex;
+    }
+
+    // The center vertex of the top cap.
+    vertex.Position = XMFLOAT3(0.0f, y, 0.0f);
+    vertex.Normal = XMFLOAT3(0.0f, 1.0f, 0.0f);
+    vertex.Texture = XMFLOAT2(0.5f, 0.5f);
+    vertices[sliceCount + 1] = vertex;
+
+    // The index of the center vertex.
+    uint32_t centerIndex = baseIndex + sliceCount + 1;
+
+    for (uint32_t i = 0; i < sliceCount; ++i)
+    {
+        indices[i * 3] = centerIndex;
+        indices[i * 3 + 1] = baseIndex + i + 1;
+        indices[i * 3 + 2] = baseIndex + i;
+    }
+}
+
+// Writes the sliceCount + 2 vertices and sliceCount triangles of the bottom cap. The first cap vertex has the given index.
+void MeshBuilder::BuildCylinderBottomCap(VertexPositionNormalTexture* vertices, uint32_t* indices, uint32_t baseIndex, float bottomRadius, float cylinderHeight, uint32_t sliceCount)
+{
+    float y = -0.5f * cylinderHeight; // the y-coordinate of the bottom cap
+    float theta = XM_2PI / sliceCount;
+
+    VertexPositionNormalTexture vertex;
+
+    // Duplicate top cap vertices because the texture coordinates and normals differ.
+    for (uint32_t i = 0; i <= sliceCount; ++i)
+    {
+        float x = bottomRadius * cosf(i * theta);
+        float z = bottomRadius * sinf(i * theta);
+
+        // Scale down by the height to make the top cap texture proportional to the base.
+        float u = x / cylinderHeight + 0.5f;
+        float v = z / cylinderHeight + 0.5f;
+
+        vertex.Position = XMFLOAT3(x, y, z);
+        vertex.Normal = XMFLOAT3(0.0f, -1.0f, 0.0f);
+        vertex.Texture = XMFLOAT2(u, v);
+        vertices[i] = vertex;
+    }
+
+    // The center vertex of the bottom cap.
+    vertex.Position = XMFLOAT3(0.0f, y, 0.0f);
+    vertex.Normal = XMFLOAT3(0.0f, -1.0f, 0.0f);
+    vertex.Texture = XMFLOAT2(0.5f, 0.5f);
+    vertices[sliceCount + 1] = vertex;
+
+    // The index of the center vertex.
+    uint32_t centerIndex = baseIndex + sliceCount + 1;
+
+    for (uint32_t i = 0; i < sliceCount; ++i)
+    {
+        indices[i * 3] = centerIndex;
+        indices[i * 3 + 1] = baseIndex + i;
+        indices[i * 3 + 2] = baseIndex + i + 1;
+    }
+}
+
+/// <summary>
+/// Based on [Luna]
+/// 
+/// Creates a sphere using an approach similar to creating a cylinder.
+/// We use trigonometric functions to calculate the radius per stack.
+/// Note that the triangles of the sphere do not have equal areas.
+/// </summary>
+/// <param name="radius">The sphere's radius</param>
+/// <param name="sliceCount">The number of slices</param>
+/// <param name="stackCount">The number of stacks</param>
+/// <param name="threadPool">The pool that builds the stacks in parallel, or nullptr to build them serially</param>
+void MeshBuilder::CreateSphere(TextureMeshData& data, std::string const& name, float radius, uint32_t sliceCount, uint32_t stackCount, ThreadPool* threadPool)
+{
+    ASSERT(data.Meshes.find(name) == data.Meshes.end());
+    ASSERT(stackCount >= 2);
+
+    MeshInfo info;
+    info.BaseVertexLocation = (uint32_t)data.Vertices.size();
+    info.StartIndexLocation = (uint32_t)data.Indices.size();
+
+    auto n = sliceCount + 1; // the number of vertices in a stack
+
+    // The poles and stackCount + 1 rings of vertices. The two polar stacks have one triangle per slice and
+    // the inner stacks two.
+    uint32_t vertexCount = (stackCount + 1) * n + 2;
+    uint32_t indexCount = (stackCount - 1) * sliceCount * 6;
+
+    data.Vertices.resize(info.BaseVertexLocation + vertexCount);
+    data.Indices.resize(info.StartIndexLocation + indexCount);
+    VertexPositionNormalTexture* vertices = data.Vertices.data() + info.BaseVertexLocation;
+    uint32_t* indices = data.Indices.data() + info.StartIndexLocation;
+
+    // Create the sphere's poles.
+    VertexPositionNormalTexture topVertex{ { 0.0f, radius, 0.0f }, { 0.0f, 1.0f, 0.0f } };
+    VertexPositionNormalTexture bottomVertex{ { 0.0f, -radius, 0.0f }, {0.0f, -1.0f, 0.0f } };
+
+    // Add the north pole as the first vertex and the south pole as the last vertex.
+    vertices[0] = topVertex;
+    vertices[vertexCount - 1] = bottomVertex;
+
+    float phiStep = XM_PI / stackCount;
+    float thetaStep = XM_2PI / sliceCount;
+
+    // The slice angles are the same in every stack, so compute their sines and cosines once.
+    std::vector<float> thetas(n);
+    std::vector<float> cosines(n);
+    std::vector<float> sines(n);
+
+    for (uint32_t j = 0; j <= sliceCount; ++j)
+    {
+        float theta = j * thetaStep;
+        thetas[j] = theta;
+        cosines[j] = cosf(theta);
+        sines[j] = sinf(theta);
+    }
+
+    // Compute vertices for each stack.
+    ParallelFor(threadPool, stackCount + 1, n, [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                float phi = (i+1) * phiStep;
+                float sinPhi = sinf(phi);
+                float cosPhi = cosf(phi);
+
+                for (uint32_t j = 0; j <= sliceCount; ++j)
+                {
+                    VertexPositionNormalTexture& v = vertices[1 + i * n + j];
+
+                    // Convert spherical coordinates to Cartesian coordinates.
+                    v.Position.x = radius * sinPhi * cosines[j];
+                    v.Position.y = radius * cosPhi;
+                    v.Position.z = radius * sinPhi * sines[j];
+
+                    // Compute normal vector.
+                    XMVECTOR p = XMLoadFloat3(&v.Position);
+                    XMStoreFloat3(&v.Normal, XMVector3Normalize(p));
+
+                    // Compute texture coordinates.
+                    v.Texture.x = thetas[j] / XM_2PI;
+                    v.Texture.y = phi / XM_PI;
+                }
+            }
+        });
+
+    BuildSphereIndices(indices, sliceCount, stackCount, threadPool);
+
+    info.IndexCount = indexCount;
+
+    data.Meshes[name] = info;
+}
+
+/// <summary>
+/// The code to create a geosphere comes from DirectXTK
+/// https://github.com/microsoft/DirectXTK/blob/main/Src/Geometry.cpp
+/// 
+/// Creates a geosphere - a sphere in which each triangle has the same area and equal side lengths.
+/// The geosphere generator starts with an octahedron (a polyhedron with 8 faces) and subdivides
+/// its sides (the triangles) into smaller triangles. Then, it projects the new vertices onto
+/// a sphere. The process is repeated to improve tessellation.
+/// 
+/// This is how a single triangle is subdivided into four equal sized triangles:
+/// 
+///            v1
+///             *
+///            / \
+///           /   \
+///       m0 *-----*m1
+///         / \   / \
+///        /   \ /   \
+///       *-----*-----*
+///      v0    m2     v2
+///
+/// The midpoints are looked up in a flat hash table and the seam and poles are fixed up in a single pass
+/// over the triangles, so the time taken is linear in the number of triangles.
+/// </summary>
+/// <param name="radius">The sphere's radius</param>
+/// <param name="subdivisionCount">The number of subdivisions between 0 and MAX_TEXTURE_GEOSPHERE_SUBDIVISION_COUNT</param>
+void MeshBuilder::CreateGeosphere(TextureMeshData& data, std::string const& name, float radius, uint16_t subdivisionCount)
+{
+    ASSERT(data.Meshes.find(name) == data.Meshes.end());
+    ASSERT(subdivisionCount >= 0);
+
+    MeshInfo info;
+    info.BaseVertexLocation = (uint32_t)data.Vertices.size(); // initial vertex count
+    info.StartIndexLocation = (uint32_t)data.Indices.size(); // initial index count
+
+    subdivisionCount = std::min(subdivisionCount, MAX_TEXTURE_GEOSPHERE_SUBDIVISION_COUNT);
+
+    static const XMFLOAT3 OctahedronVertices[] =
+    {
+        XMFLOAT3(0,  1,  0),
+        XMFLOAT3(0,  0, -1),
+        XMFLOAT3(1,  0,  0),
+        XMFLOAT3(0,  0,  1),
+        XMFLOAT3(-1,  0,  0),
+        XMFLOAT3(0, -1,  0),
+    };
+    static const uint16_t OctahedronIndices[] =
+    {
+        0, 1, 2,
+        0, 2, 3,
+        0, 3, 4,
+        0, 4, 1,
+        5, 1, 4,
+        5, 4, 3,
+        5, 3, 2,
+        5, 2, 1
+    };
+
+    constexpr uint32_t northPoleIndex = 0;
+    constexpr uint32_t southPoleIndex = 5;
+
+    // Each subdivision turns a triangle into four and adds a vertex per edge, so the final counts are known
+    // up front: 8 * 4^n triangles and, by Euler's formula, half as many vertices plus two.
+    const size_t finalTriangleCount = size_t{ 8 } << (2 * subdivisionCount);
+    const size_t finalPositionCount = finalTriangleCount / 2 + 2;
+
+    // Start with an octahedron; copy the data into the vertex/index collection.
+    std::vector<XMFLOAT3> vertexPositions;
+    vertexPositions.reserve(finalPositionCount);
+    vertexPositions.assign(std::begin(OctahedronVertices), std::end(OctahedronVertices));
+
+    std::vector<uint32_t> indices;
+    std::vector<uint32_t> newIndices;
+    indices.reserve(finalTriangleCount * 3);
+    newIndices.reserve(finalTriangleCount * 3);
+    indices.assign(std::begin(OctahedronIndices), std::end(OctahedronIndices));
+
+    EdgeTable subdividedEdges;
+
+    for (size_t subdivision = 0; subdivision < subdivisionCount; ++subdivision)
+    {
+        ASSERT(indices.size() % 3 == 0);
+
+        // A closed triangle mesh has one and a half edges per triangle.
+        const size_t triangleCount = indices.size() / 3;
+        subdividedEdges.Reset(triangleCount * 3 / 2);
+        newIndices.clear();
+
+        auto const divideEdge = [&](uint32_t i0, uint32_t i1)
+        {
+            auto const [index, isNew] = subdividedEdges.Insert(i0, i1, static_cast<uint32_t>(vertexPositions.size()));
+            if (isNew)
+            {
+                XMFLOAT3 midpoint;
+                XMStoreFloat3(
+                    &midpoint,
+                    XMVectorScale(
+                        XMVectorAdd(XMLoadFloat3(&vertexPositions[i0]), XMLoadFloat3(&vertexPositions[i1])),
+                        0.5f));
+
+                vertexPositions.push_back(midpoint);
+            }
+
+            return index;
+        };
+
+        for (size_t iTriangle = 0; iTriangle < triangleCount; ++iTriangle)
+        {
+            const uint32_t iv0 = indices[iTriangle * 3 + 0];
+            const uint32_t iv1 = indices[iTriangle * 3 + 1];
+            const uint32_t iv2 = indices[iTriangle * 3 + 2];
+
+            const uint32_t iv01 = divideEdge(iv0, iv1);
+            const uint32_t iv12 = divideEdge(iv1, iv2);
+            const uint32_t iv20 = divideEdge(iv0, iv2);
+
+            // Add the new indices.
+            //        v0
+            //        o
+            //       /a\
+            //  v20 o---o v01
+            //     /b\c/d\
+            // v2 o---o---o v1
+            //       v12
+            const uint32_t indicesToAdd[] =
+            {
+                 iv0, iv01, iv20,
+                iv20, iv12,  iv2,
+                iv20, iv01, iv12,
+                iv01,  iv1, iv12,
+            };
+            newIndices.insert(newIndices.end(), std::begin(indicesToAdd), std::end(indicesToAdd));
+        }
+
+        indices.swap(newIndices);
+    }
+
+    ASSERT(vertexPositions.size() == finalPositionCount);
+
+    // Now that we've completed subdivision, fill in the final vertex collection. The fixups below add a copy
+    // of each vertex on the prime meridian, one more than the edges from pole to pole along it, and a copy for
+    // each but the first of the four triangles at a pole.
+    std::vector<VertexPositionNormalTexture> vertices;
+    vertices.reserve(finalPositionCount + (size_t{ 1 } << subdivisionCount) + 1 + 6);
+    for (const auto& it : vertexPositions)
+    {
+        auto const normal = XMVector3Normalize(XMLoadFloat3(&it));
+        auto const pos = XMVectorScale(normal, radius);
+
+        XMFLOAT3 normalFloat3;
+        XMStoreFloat3(&normalFloat3, normal);
+
+        const float longitude = atan2f(normalFloat3.x, -normalFloat3.z);
+        const float latitude = acosf(normalFloat3.y);
+
+        const float u = longitude / XM_2PI + 0.5f;
+        const float v = latitude / XM_PI;
+
+        auto const texcoord = XMVectorSet(1.0f - u, v, 0.0f, 0.0f);
+        VertexPositionNormalTexture vertex;
+        XMStoreFloat3(&vertex.Position, pos);
+        XMStoreFloat3(&vertex.Normal, normal);
+        XMStoreFloat2(&vertex.Texture, texcoord);
+        vertices.push_back(vertex);
+    }
+
+    // A texture coordinate wraparound fixup. Each vertex on the prime meridian gets a copy with u = 1 for the
+    // triangles that reach it from the other side of the texture.
+    constexpr uint32_t noCopy = UINT32_MAX;
+    const size_t preFixupVertexCount = vertices.size();
+    std::vector<uint32_t> seamCopies(preFixupVertexCount, noCopy);
+    for (size_t i = 0; i < preFixupVertexCount; ++i)
+    {
+        const bool isOnPrimeMeridian = XMVector2NearEqual(
+            XMVectorSet(vertices[i].Position.x, vertices[i].Texture.x, 0.0f, 0.0f),
+            XMVectorZero(),
+            XMVectorSplatEpsilon());
+
+        if (isOnPrimeMeridian)
+        {
+            seamCopies[i] = static_cast<uint32_t>(vertices.size());
+
+            VertexPositionNormalTexture v = vertices[i];
+            v.Texture.x = 1.0f;
+            vertices.push_back(v);
+        }
+    }
+
+    // One pass over the triangles moves their corners on the prime meridian to the copies and collects their
+    // corners at the poles. A corner is moved if another corner is more than half the texture away from it.
+    // The corners are taken in vertex order and see the corners moved before them, the same as if each
+    // vertex on the meridian were fixed up over all the triangles in turn.
+    std::vector<size_t> northPoleCorners;
+    std::vector<size_t> southPoleCorners;
+
+    for (size_t j = 0; j < indices.size(); j += 3)
+    {
+        uint32_t* triangle = &indices[j];
+
+        size_t seamCorners[3];
+        size_t seamCornerCount = 0;
+        for (size_t k = 0; k < 3; ++k)
+        {
+            if (seamCopies[triangle[k]] != noCopy)
+                seamCorners[seamCornerCount++] = k;
+        }
+
+        std::sort(seamCorners, seamCorners + seamCornerCount,
+            [triangle](size_t a, size_t b) { return triangle[a] < triangle[b]; });
+
+        for (size_t c = 0; c < seamCornerCount; ++c)
+        {
+            const size_t k = seamCorners[c];
+
+            const VertexPositionNormalTexture& v0 = vertices[triangle[k]];
+            const VertexPositionNormalTexture& v1 = vertices[triangle[(k + 1) % 3]];
+            const VertexPositionNormalTexture& v2 = vertices[triangle[(k + 2) % 3]];
+
+            if (std::abs(v0.Texture.x - v1.Texture.x) > 0.5f ||
+                std::abs(v0.Texture.x - v2.Texture.x) > 0.5f)
+            {
+                triangle[k] = seamCopies[triangle[k]];
+            }
+        }
+
+        for (size_t k = 0; k < 3; ++k)
+        {
+            if (triangle[k] == northPoleIndex)
+                northPoleCorners.push_back(j + k);
+            else if (triangle[k] == southPoleIndex)
+                southPoleCorners.push_back(j + k);
+        }
+    }
+
+    // Fix the poles. Each triangle at a pole gets a pole vertex of its own with u halfway between its other
+    // two corners; the first one reuses the original pole vertex.
+    auto const fixPole = [&](uint32_t poleIndex, std::vector<size_t> const& poleCorners)
+    {
+        const VertexPositionNormalTexture poleVertex = vertices[poleIndex];
+
+        for (size_t c = 0; c < poleCorners.size(); ++c)
+        {
+            const size_t corner = poleCorners[c];
+            const size_t first = corner - corner % 3;
+
+            const auto& otherVertex0 = vertices[indices[first + (corner + 1) % 3]];
+            const auto& otherVertex1 = vertices[indices[first + (corner + 2) % 3]];
+
+            VertexPositionNormalTexture newPoleVertex = poleVertex;
+            newPoleVertex.Texture.x = (otherVertex0.Texture.x + otherVertex1.Texture.x) / 2;
+
+            if (c == 0)
+            {
+                vertices[poleIndex] = newPoleVertex;
+            }
+            else
+            {
+                indices[corner] = static_cast<uint32_t>(vertices.size());
+                vertices.push_back(newPoleVertex);
+            }
+        }
+    };
+
+    fixPole(northPoleIndex, northPoleCorners);
+    fixPole(southPoleIndex, southPoleCorners);
+
+    // Reverse winding.
+    for (auto it = indices.begin(); it != indices.end(); it += 3)
+        std::swap(*it, *(it + 2));
+    for (auto& it : vertices)
+        it.Texture.x = (1.f - it.Texture.x);
+
+    // Add the geosphere vertices and indices to the buffers.
+    data.Indices.insert(data.Indices.end(), indices.begin(), indices.end());
+    data.Vertices.insert(data.Vertices.end(), vertices.begin(), vertices.end());
+
+    info.IndexCount = (uint32_t)data.Indices.size() - info.StartIndexLocation;
+
+    data.Meshes[name] = info;
+}
+
+/// <summary>
+/// Builds a grid mesh in the xz-plane procedurally.
+/// </summary>
+/// <param name="gridWidth">Grid width. It determines the relative size of the grid.</param>
+/// <param name="gridDepth">Grid depth. It determines the relative size of the grid.</param>
+/// <param name="quadCountHoriz">The number of quads in the grid in the horizontal dimension (x-axis)</param>
+/// <param name="quadCountDepth">The number of quads in the grid in the depth dimension (z-axis)</param>
+/// <param name="threadPool">The pool that builds the rows in parallel, or nullptr to build them serially</param>
+void MeshBuilder::CreateGrid(TextureMeshData& data, std::string const& name, float gridWidth, float gridDepth, uint32_t quadCountHoriz, uint32_t quadCountDepth, ThreadPool* threadPool)
+{
+    ASSERT(data.Meshes.find(name) == data.Meshes.end());
+
+    MeshInfo info;
+    info.BaseVertexLocation = (uint32_t)data.Vertices.size(); // initial vertex count
+    info.StartIndexLocation = (uint32_t)data.Indices.size(); // initial index count
+
+    // The grid is built from an M x N matrix of vertices. 
+    uint32_t m = quadCountDepth + 1;
+    uint32_t n = quadCountHoriz + 1;
+
+    // Calculate increments for texture coordinates.
+    float du = 1.0f / quadCountHoriz;
+    float dv = 1.0f / quadCountDepth;
+
+    // Create vertices.
+    uint32_t vertexCount = m * n;
+    data.Vertices.resize(info.BaseVertexLocation + vertexCount);
+    VertexPositionNormalTexture* vertices = data.Vertices.data() + info.BaseVertexLocation;
+
+    // An example of a 2 x 4 grid mesh:
+    // - quadCountHoriz = 4
+    // - quadCountDepth = 2
+    // - quadCount = 4 * 2 = 8
+    // - triangleCount = quadCount * 2 = 16
+    // - m = 3 (the depth number of vertices)
+    // - n = 5 (the horizontal number of vertices)
+    // - vertexCount = 15
+    // 
+    //  0--1--2--3--4
+    //  |\ |\ |\ |\ | 
+    //  | \| \| \| \|
+    //  5--6--7--8--9
+    //  |\ |\ |\ |\ | 
+    //  | \| \| \| \|
+    // 10-11-12-13-14
+
+    std::vector<float> xs;
+    std::vector<float> zs;
+    ComputeGridCoordinates(gridWidth, gridDepth, quadCountHoriz, quadCountDepth, xs, zs);
+
+    ParallelFor(threadPool, m, n, [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                for (uint32_t j = 0; j < n; ++j)
+                {
+                    VertexPositionNormalTexture& vertex = vertices[i * n + j];
+                    vertex.Position = XMFLOAT3(xs[j], 0, zs[i]);
+                    vertex.Normal = XMFLOAT3(0.0f, 1.0f, 0.0f);
+
+                    // Stretch the texture over grid.
+                    vertex.Texture.x = j * du;
+                    vertex.Texture.y = i * dv;
+                }
+            }
+        });
+
+    // Create indices: 
+    // - each quad has two triangles
+    // - each triangle has three vertices
+    // - each quad is duplicated for the top and the bottom face of the grid
+    uint32_t indexCount = 2 * quadCountHoriz * quadCountDepth * 2 * 3;
+    data.Indices.resize(info.StartIndexLocation + indexCount);
+    BuildGridIndices(data.Indices.data() + info.StartIndexLocation, quadCountHoriz, quadCountDepth, threadPool);
+
+    info.IndexCount = indexCount;
+
+    data.Meshes[name] = info;
+}
+
+/// <summary>
+/// Creates a pipe - a cylinder without caps.
+/// </summary>
+/// <param name="radius">The radius of the pipe</param>
+/// <param name="height">The pipe's height</param>
+/// <param name="sliceCount">The number of slices. A slice is one triangle in the top or the bottom of the pipe.</param>
+/// <param name="stackCount">The number of stacks. A stack is one vertical segment of the pipe.</param>
+/// <param name="threadPool">The pool that builds the stacks in parallel, or nullptr to build them serially</param>
+void MeshBuilder::CreatePipe(TextureMeshData& data, std::string const& name, float radius, float height, uint32_t sliceCount, uint32_t stackCount, bool createInterior, ThreadPool* threadPool)
+{
+    ASSERT(data.Meshes.find(name) == data.Meshes.end());
+
+    MeshInfo info;
+    info.BaseVertexLocation = (uint32_t)data.Vertices.size(); // initial vertex count
+    info.StartIndexLocation = (uint32_t)data.Indices.size(); // initial index count
+
+    // Increase the number of vertices per stack by one because we duplicate the first vertex.
+    auto n = sliceCount + 1;
+
+    // Each surface has stackCount + 1 rings of vertices and two triangles per slice of a stack.
+    uint32_t surfaceCount = createInterior ? 2 : 1;
+    uint32_t surfaceVertexCount = (stackCount + 1) * n;
+    uint32_t surfaceIndexCount = stackCount * sliceCount * 6;
+
+    data.Vertices.resize(info.BaseVertexLocation + surfaceCount * surfaceVertexCount);
+    data.Indices.resize(info.StartIndexLocation + surfaceCount * surfaceIndexCount);
+    VertexPositionNormalTexture* vertices = data.Vertices.data() + info.BaseVertexLocation;
+    uint32_t* indices = data.Indices.data() + info.StartIndexLocation;
+
+    float stackHeight = height / stackCount;
+
+    // Calculate the angle of a single slice triangle.
+    float theta = XM_2PI / sliceCount;
+
+    // The angles and normals are the same in every stack, so compute them once per slice.
+    std::vector<float> cosines(n);
+    std::vector<float> sines(n);
+    std::vector<XMFLOAT3> normals(n);
+
+    for (uint32_t j = 0; j <= sliceCount; ++j)
+    {
+        float c = cosf(j * theta);
+        float s = sinf(j * theta);
+
+        cosines[j] = c;
+        sines[j] = s;
+        XMStoreFloat3(&normals[j], XMVector3Normalize(XMVectorSet(c, 0, s, 0)));
+    }
+
+    auto CreateVertices = [&](VertexPositionNormalTexture* surface, bool invertNormal)
+    {
+        // Generate vertices for each stack starting at the bottom stack. We use <= rater than <
+        // because we want to generate vertices for the top of the last (top) stack.
+        ParallelFor(threadPool, stackCount + 1, n, [&](uint32_t begin, uint32_t end)
+            {
+                for (uint32_t i = begin; i < end; ++i)
+                {
+                    // Calculate the y-coordinate of the i-th stack base (or the top of the last stack).
+                    float y = -0.5f * height + i * stackHeight;
+
+                    // Create vertices for the i-th stack. Note that we duplicate the first vertex as 
+                    // the last one by using <= rather than < 
+                    // This is necessary for correct texture rendering.
+                    for (uint32_t j = 0; j <= sliceCount; ++j)
+                    {
+                        VertexPositionNormalTexture& vertex = surface[i * n + j];
+                        vertex.Position = XMFLOAT3(radius * cosines[j], y, radius * sines[j]);
+
+                        // Compute texture coordinates.
+                        vertex.Texture.x = (float)j / sliceCount;
+                        vertex.Texture.y = 1.0f - (float)i / stackCount;
+
+                        // Determine normal's sign.
+                        float sign = (invertNormal ? -1.f : 1.f);
+
+                        // Calculate vertex normal.
+                        XMVECTOR normal = sign * XMLoadFloat3(&normals[j]);
+                        XMStoreFloat3(&vertex.Normal, normal);
+                    }
+                }
+            });
+    };
+
+    CreateVertices(vertices, false); // exterior
+    if (createInterior)
+        CreateVertices(vertices + surfaceVertexCount, true); // interior
+
+    BuildStackIndices(indices, sliceCount, stackCount, false, threadPool); // exterior
+    if (createInterior)
+        BuildStackIndices(indices + surfaceIndexCount, sliceCount, stackCount, true, threadPool); // interior
+
+    info.IndexCount = (uint32_t)data.Indices.size() - info.StartIndexLocation;
+
+    data.Meshes[name] = info;
+}
+
+void MeshBuilder::CreateQuad(TextureMeshData& data, std::string const& name)
+{
+    ASSERT(data.Meshes.find(name) == data.Meshes.end());
+
+    MeshInfo info;
+    info.BaseVertexLocation = (uint32_t)data.Vertices.size(); // initial vertex count
+    info.StartIndexLocation = (uint32_t)data.Indices.size(); // initial index count
+
+    auto i = info.BaseVertexLocation;
+    data.Vertices.resize(i + 4);
+
+    float l = 0.5f, n = 1.0f;
+
+    data.Vertices[i++] = { XMFLOAT3(-l,  0, -l), XMFLOAT3(0, n, 0), XMFLOAT2(0.0f, 1.0f) };
+    data.Vertices[i++] = { XMFLOAT3(-l,  0,  l), XMFLOAT3(0, n, 0), XMFLOAT2(0.0f, 0.0f) };
+    data.Vertices[i++] = { XMFLOAT3( l,  0,  l), XMFLOAT3(0, n, 0), XMFLOAT2(1.0f, 0.0f) };
+    data.Vertices[i++] = { XMFLOAT3( l,  0, -l), XMFLOAT3(0, n, 0), XMFLOAT2(1.0f, 1.0f) };
+
+    ASSERT(data.Vertices.size() == i);
+
+    std::vector<uint32_t> indices =
+    {
+        0, 1, 2,
+        0, 2, 3
+    };
+
+    info.IndexCount = (uint32_t)indices.size();
+    CopyIndices(data.Indices, indices, info.StartIndexLocation, info.IndexCount);
+
+    data.Meshes[name] = info;
+}
+
+void MeshBuilder::CreateStar(TextureMeshData& data, std::string const& name, uint32_t armCount, float radiusShort, float radiusLong, float thickness)
+{
+    ASSERT(data.Meshes.find(name) == data.Meshes.end());
+
+    MeshInfo info;
+    info.BaseVertexLocation = (uint32_t)data.Vertices.size(); // initial vertex count
+    info.StartIndexLocation = (uint32_t)data.Indices.size(); // initial index count
+
+    // Calculate the number of vertices and indices.
+    const uint32_t VertexCount = 12 * armCount; // 12 vertices per arm
+    const uint32_t IndexCount = 12 * armCount; // 12 indices per arm
+
+    // Resize buffers.
+    data.Vertices.resize(data.Vertices.size() + VertexCount);
+    data.Indices.resize(data.Indices.size() + IndexCount);
+
+    uint32_t v = info.BaseVertexLocation;
+    uint32_t i = info.StartIndexLocation;
+
+    // Prepare temporary values to calculate positions of the star's verticies and normals.
+    float r1 = radiusShort, r2 = radiusLong, h = thickness / 2.0f; // short and long radius, and half of the star thickness (shorter variable names)
+    float theta = 2.0f * XM_PI / (float)armCount; // an angle of the tip of the star's arm
+    float x = tan(theta / 2.0f) * radiusShort; // a helper distance within the star's arm
+
+    // Define geometry in the model space
+    XMFLOAT3 A0, B0, C0, D0, E0;
+    A0 = XMFLOAT3(0, -r2, 0);
+    B0 = XMFLOAT3(x, -r1, 0);
+    C0 = XMFLOAT3(-x, -r1, 0);
+    D0 = XMFLOAT3(0, 0, -h);
+    E0 = XMFLOAT3(0, 0, h);
+
+    for (uint32_t n = 0; n < armCount; ++n)
+    {
+        float sint = sin((float)n * theta);
+        float cost = cos((float)n * theta);
+
+        XMFLOAT3 A, B, C, D, E;
+
+        // rotate counterclockwise around the angle theta
+        // x' = x*cos(a) - y*sin(a);
+        // y' = x*sin(a) + y*cos(a);
+        A.x = A0.x * cost - A0.y * sint;
+        A.y = A0.x * sint + A0.y * cost;
+        A.z = 0;
+
+        B.x = B0.x * cost - B0.y * sint;
+        B.y = B0.x * sint + B0.y * cost;
+        B.z = 0;
+
+        C.x = C0.x * cost - C0.y * sint;
+        C.y = C0.x * sint + C0.y * cost;
+        C.z = 0;
+
+        // not rotated
+        D = D0;
+        E = E0;
+
+        /*
+
+                front
+                  D
+                 /|\       D(0,0)________ B(1,0)
+                / | \           |        |
+               /  |  \          |        |
+            C /   |   \ B       |        |
+              \   |   /         |________|
+               \  |  /     C(0,1)         A(1,1)
+                \ | /
+                 \|/
+                  A
+
+
+        back
+                  E
+                 /|\       E(0,0)________ C(1,0)
+                / | \           |        |
+               /  |  \          |        |
+            B /   |   \ C       |        |
+              \   |   /         |________|
+               \  |  /     B(0,1)         A(1,1)
+                \ | /
+                 \|/
+                  A
+        */
+
+        XMFLOAT3 nv1; XMStoreFloat3(&nv1, ComputeNormal(A, C, D));
+        data.Vertices[v++] = { A, nv1, XMFLOAT2(1.0f, 1.0f) };
+        data.Vertices[v++] = { C, nv1, XMFLOAT2(0.0f, 1.0f) };
+        data.Vertices[v++] = { D, nv1, XMFLOAT2(0.0f, 0.0f) };
+
+        XMFLOAT3 nv2; XMStoreFloat3(&nv2, ComputeNormal(A, D, B));
+        data.Vertices[v++] = { A, nv2, XMFLOAT2(1.0f, 1.0f) };
+        data.Vertices[v++] = { D, nv2, XMFLOAT2(0.0f, 0.0f) };
+        data.Vertices[v++] = { B, nv2, XMFLOAT2(1.0f, 0.0f) };
+
+        XMFLOAT3 nv3; XMStoreFloat3(&nv3, ComputeNormal(A, E, C));
+        data.Vertices[v++] = { A, nv3, XMFLOAT2(1.0f, 1.0f) };
+        data.Vertices[v++] = { E, nv3, XMFLOAT2(0.0f, 0.0f) };
+        data.Vertices[v++] = { C, nv3, XMFLOAT2(1.0f, 0.0f) };
+
+        XMFLOAT3 nv4; XMStoreFloat3(&nv4, ComputeNormal(A, B, E));
+        data.Vertices[v++] = { A, nv4, XMFLOAT2(1.0f, 1.0f) };
+        data.Vertices[v++] = { B, nv4, XMFLOAT2(0.0f, 1.0f) };
+        data.Vertices[v++] = { E, nv4, XMFLOAT2(0.0f, 0.0f) };
+
+        for (int j = 0; j < 12; ++j)
+        {
+            data.Indices[i] = i - info.StartIndexLocation;
+            ++i;
+        }
+    }
+
+    // Each arm has 12 vertices and indices.
+    // The last index in the vertex/index buffer must be equal the total number of vertices/indices. 
+    ASSERT(v - info.BaseVertexLocation == armCount * 12);
+    ASSERT(i - info.StartIndexLocation == armCount * 12);
+
+    info.IndexCount = (uint32_t)data.Indices.size() - info.StartIndexLocation;
+
+    data.Meshes[name] = info;
+}
+
+// Assumptions (for performance reasons): 
+// - 250 - max characters per line
+// - 10 - max tokens per line
+static int const MAX_CHARS_PER_LINE = 250;
+static int const MAX_TOKENS_PER_LINE = 10;
+
+/// <summary>
+/// Creates a mesh from the lines of a model file. The file lists the vertex and triangle counts followed by
+/// a VertexList of positions, normals, and optionally texture coordinates, and a TriangleList of indices.
+/// </summary>
+/// <param name="lines">The lines of the model file</param>
+/// <param name="hasTexture">True if the vertices have texture coordinates</param>
+void MeshBuilder::CreateModel(TextureMeshData& data, std::string const& name, std::vector<std::wstring> const& lines, bool hasTexture)
+{
+    ASSERT(data.Meshes.find(name) == data.Meshes.end());
+
+    MeshInfo info;
+    info.BaseVertexLocation = (uint32_t)data.Vertices.size(); // initial vertex count
+    info.StartIndexLocation = (uint32_t)data.Indices.size(); // initial index count
+
+    bool readVertices = false, readIndices = false;
+    uint32_t baseVertex = info.BaseVertexLocation;
+    uint32_t baseIndex = info.StartIndexLocation;
+
+    std::vector<std::wstring> tokens;
+    tokens.resize(MAX_TOKENS_PER_LINE);
+
+    for (auto const& line : lines)
+    {
+        GetTokes(line.c_str(), tokens);
+
+        if (tokens[0] == L"VertexCount:")
+        {
+            int vertexCount = std::stoi(tokens[1]);
+            data.Vertices.resize((uint32_t)data.Vertices.size() + vertexCount);
+        }
+
+        if (tokens[0] == L"TriangleCount:")
+        {
+            int triangleCount = std::stoi(tokens[1]);
+            data.Indices.resize((uint32_t)data.Indices.size() + triangleCount * 3);
+        }
+
+        if (tokens[0] == L"VertexList") readVertices = true;
+        if (tokens[0] == L"}" && readVertices) readVertices = false;
+        if (tokens[0] == L"TriangleList") readIndices = true;
+        if (tokens[0] == L"}" && readIndices) readIndices = false;
+
+        if (readVertices)
+        {
+            if (tokens[0] != L"{" && tokens[0] != L"}" && tokens[0] != L"VertexList" && tokens[0] != L"")
+            {
+                float px = std::stof(tokens[0]);
+                float py = std::stof(tokens[1]);
+                float pz = std::stof(tokens[2]);
+                float nx = std::stof(tokens[3]);
+                float ny = std::stof(tokens[4]);
+                float nz = std::stof(tokens[5]);
+
+                if (hasTexture)
+                {
+                    float tx = std::stof(tokens[6]);
+                    float ty = std::stof(tokens[7]);
+
+                    data.Vertices[baseVertex++] = { XMFLOAT3(px, py, pz), XMFLOAT3(nx, ny, nz), XMFLOAT2(tx, ty) };
+                }
+                else
+                {
+                    data.Vertices[baseVertex++] = { XMFLOAT3(px, py, pz), XMFLOAT3(nx, ny, nz), XMFLOAT2(0.f, 0.f) }; // dummy texture coordinates just to fill the buffer
+                }
+            }
+        }
+
+        if (readIndices)
+        {
+            if (tokens[0] != L"{" && tokens[0] != L"}" && tokens[0] != L"TriangleList")
+            {
+                uint32_t x = std::stoi(tokens[0]);
+                uint32_t y = std::stoi(tokens[1]);
+                uint32_t z = std::stoi(tokens[2]);
+
+                data.Indices[baseIndex++] = x;
+                data.Indices[baseIndex++] = y;
+                data.Indices[baseIndex++] = z;
+            }
+        }
+    }
+
+    info.IndexCount = (uint32_t)data.Indices.size() - info.StartIndexLocation;
+
+    data.Meshes[name] = info;
+}
+
+// Splits a string into tokens.
+void MeshBuilder::GetTokes(const wchar_t* ps, std::vector<std::wstring>& tokens)
+{
+    static wchar_t p[MAX_CHARS_PER_LINE];
+    unsigned l = 0;
+    int k = 0;
+
+    for (unsigned j = 0; ps[j] != 0; ++j)
+    {
+        if (ps[j] != ' ')
+        {
+            if (ps[j] != '\t')
+            {
+                p[k] = ps[j];
+                ++k;
+            }
+        }
+        else
+        {
+            p[k] = 0;
+            tokens[l] = p;
+            ++l;
+            k = 0;
+        }
+    }
+
+    p[k] = 0;
+    tokens[l] = p;
+    l = 0;
+}
+
+/// <summary>
+/// Creates a unit cube i.e., a cube whose sides are 1 unit long.
+/// </summary>
+void MeshBuilder::CreateCube(ColorMeshData& data, std::string const& name)
+{
+    ASSERT(data.Meshes.find(name) == data.Meshes.end());
+
+    MeshInfo info;
+    info.BaseVertexLocation = (uint32_t)data.Vertices.size();
+    info.StartIndexLocation = (uint32_t)data.Indices.size();
+
+    auto i = info.BaseVertexLocation;
+    data.Vertices.resize(i + 8); // the cube has 8 vertices
+
+    data.Vertices[i++] = { XMFLOAT3(-0.5f, -0.5f, -0.5f), XMFLOAT3(0.0f, 0.0f, 0.0f) };
+    data.Vertices[i++] = { XMFLOAT3(-0.5f, -0.5f,  0.5f), XMFLOAT3(0.0f, 0.0f, 1.0f) };
+    data.Vertices[i++] = { XMFLOAT3(-0.5f,  0.5f, -0.5f), XMFLOAT3(0.0f, 1.0f, 0.0f) };
+    data.Vertices[i++] = { XMFLOAT3(-0.5f,  0.5f,  0.5f), XMFLOAT3(0.0f, 1.0f, 1.0f) };
+    data.Vertices[i++] = { XMFLOAT3( 0.5f, -0.5f, -0.5f), XMFLOAT3(1.0f, 0.0f, 0.0f) };
+    data.Vertices[i++] = { XMFLOAT3( 0.5f, -0.5f,  0.5f), XMFLOAT3(1.0f, 0.0f, 1.0f) };
+    data.Vertices[i++] = { XMFLOAT3( 0.5f,  0.5f, -0.5f), XMFLOAT3(1.0f, 1.0f, 0.0f) };
+    data.Vertices[i++] = { XMFLOAT3( 0.5f,  0.5f,  0.5f), XMFLOAT3(1.0f, 1.0f, 1.0f) };
+
+    ASSERT(data.Vertices.size() == i);
+
+    std::vector<uint32_t> indices =
+    {
+        0, 1, 2, // -x
+        1, 3, 2,
+
+        4, 6, 5, // +x
+        5, 6, 7,
+
+        0, 5, 1, // -y
+        0, 4, 5,
+
+        2, 7, 6, // +y
+        2, 3, 7,
+
+        0, 6, 4, // -z
+        0, 2, 6,
+
+        1, 7, 3, // +z
+        1, 5, 7,
+    };
+
+    info.IndexCount = (uint32_t)indices.size();
+    CopyIndices(data.Indices, indices, info.StartIndexLocation, info.IndexCount);
+
+    data.Meshes[name] = info;
+}
+
+/// <summary>
+/// Creates a pyramid. The pyramid's base is a unit square.
+/// 
+/// [Luna] Ex.4 p.242 Construct the vertex and index list of a pyramid.
+/// </summary>
+void MeshBuilder::CreatePyramid(ColorMeshData& data, std::string const& name)
+{
+    ASSERT(data.Meshes.find(name) == data.Meshes.end());
+
+    MeshInfo info;
+    info.BaseVertexLocation = (uint32_t)data.Vertices.size();
+    info.StartIndexLocation = (uint32_t)data.Indices.size();
+
+    auto i = info.BaseVertexLocation;
+    data.Vertices.resize(i + 5); // the pyramid has 5 vertices
+
+    const float l = 0.5f;
+    data.Vertices[i++] = { XMFLOAT3(0.0f, l, 0.0f), XMFLOAT3(1.0f, 0.0f, 0.0f) };
+    data.Vertices[i++] = { XMFLOAT3( l, -l,  l), XMFLOAT3(0.0f, 1.0f, 0.0f) };
+    data.Vertices[i++] = { XMFLOAT3( l, -l, -l), XMFLOAT3(0.0f, 1.0f, 0.0f) };
+    data.Vertices[i++] = { XMFLOAT3(-l, -l, -l), XMFLOAT3(0.0f, 1.0f, 0.0f) };
+    data.Vertices[i++] = { XMFLOAT3(-l, -l,  l), XMFLOAT3(0.0f, 1.0f, 0.0f) };
+
+    ASSERT(data.Vertices.size() == i);
+
+    std::vector<uint32_t> indices =
+    {
+        0, 1, 2,
+        0, 2, 3,
+        0, 3, 4,
+        0, 4, 1,
+
+        2, 1, 3,
+        3, 1, 4,
+    };
+
+    info.IndexCount = (uint32_t)indices.size();
+    CopyIndices(data.Indices, indices, info.StartIndexLocation, info.IndexCount);
+
+    data.Meshes[name] = info;
+}
+
+/// <summary>
+/// Based on [Luna]
+/// 
+/// Creates a cylinder centered at the origin and parallel to the y-axis. The cylinder is composed of
+/// stacks placed vertically one on another. The bottom stack has a cap as its base. Similarily,
+/// the top stack has a cap as its top. We build the cylinder starting from the bottom stack.
+/// 
+/// An example of a cylinder with 3 stacks:
+///    ____
+///   /    \
+///  /      \
+/// /________\
+///
+/// Note that in the above cylinder the radii of the top and bottom caps differ.
+/// </summary>
+/// <param name="bottomRadius">The radius of the bottom cap</param>
+/// <param name="topRadius">The radius of the top cap</param>
+/// <param name="cylinderHeight">The cylider's height</param>
+/// <param name="sliceCount">The number of slices. A slice is one triangle in the top or the bottom cap.</param>
+/// <param name="stackCount">The number of stacks. A stack is one vertical segment of the cylinder.</param>
+/// <param name="threadPool">The pool that builds the stacks in parallel, or nullptr to build them serially</param>
+void MeshBuilder::CreateCylinder(ColorMeshData& data, std::string const& name, float bottomRadius, float topRadius, float cylinderHeight, uint32_t sliceCount, uint32_t stackCount, ThreadPool* threadPool)
+{
+    ASSERT(data.Meshes.find(name) == data.Meshes.end());
+
+    MeshInfo info;
+    info.BaseVertexLocation = (uint32_t)data.Vertices.size();
+    info.StartIndexLocation = (uint32_t)data.Indices.size();
+
+    // Increase the number of vertices per stack by one because we duplicate the first vertex.
+    auto n = sliceCount + 1;
+
+    // The stacks share stackCount + 1 rings of vertices and have two triangles per slice. Each cap has its own
+    // ring, a center vertex and one triangle per slice.
+    uint32_t stackVertexCount = (stackCount + 1) * n;
+    uint32_t stackIndexCount = stackCount * sliceCount * 6;
+    uint32_t capVertexCount = n + 1;
+    uint32_t capIndexCount = sliceCount * 3;
+
+    data.Vertices.resize(info.BaseVertexLocation + stackVertexCount + 2 * capVertexCount);
+    data.Indices.resize(info.StartIndexLocation + stackIndexCount + 2 * capIndexCount);
+    VertexPositionColor* vertices = data.Vertices.data() + info.BaseVertexLocation;
+    uint32_t* indices = data.Indices.data() + info.StartIndexLocation;
+
+    float stackHeight = cylinderHeight / stackCount;
+
+    // Calculate the "top" angle of a single slice triangle.
+    float theta = XM_2PI / sliceCount;
+
+    // Calculate the difference between the radii of two consecutive stacks.
+    // This difference may be positive, negative, or zero depending on the relative
+    // sizes of the top and bottom caps.
+    float radiusDelta = (topRadius - bottomRadius) / stackCount;
+
+    // The angles are the same in every stack, so compute their sines and cosines once.
+    std::vector<float> cosines(n);
+    std::vector<float> sines(n);
+
+    for (uint32_t j = 0; j <= sliceCount; ++j)
+    {
+        cosines[j] = cosf(j * theta);
+        sines[j] = sinf(j * theta);
+    }
+
+    // Generate vertices for each stack starting at the bottom stack. We use <= rater than <
+    // because we want to generate vertices for the top of the last (top) stack.
+    ParallelFor(threadPool, stackCount + 1, n, [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                // Calculate the y-coordinate of the i-th stack base (or the top of the last stack).
+                float y = -0.5f * cylinderHeight + i * stackHeight;
+
+                // Calculate the radius of the i-th stack base (or the radius of the top of the last stack).
+                float r = bottomRadius + i * radiusDelta;
+
+                // Create vertices for the i-th stack. Note that we duplicate the first vertex as 
+                // the last one by using <= rather than < 
+                for (uint32_t j = 0; j <= sliceCount; ++j)
+                {
+                    VertexPositionColor& v = vertices[i * n + j];
+                    v.Position = XMFLOAT3(r * cosines[j], y, r * sines[j]);
+
+                    // Alternate color for each stack.
+                    if (i % 2)
+                        v.Color = XMFLOAT3(1.0f, 0.2f, 0.0f);
+                    else
+                        v.Color = XMFLOAT3(0.219f, 0.254f, 0.717f);
+                }
+            }
+        });
+
+    BuildStackIndices(indices, sliceCount, stackCount, false, threadPool);
+
+    BuildCylinderTopCap(vertices + stackVertexCount, indices + stackIndexCount,
+        stackVertexCount, topRadius, cylinderHeight, sliceCount);
+    BuildCylinderBottomCap(vertices + stackVertexCount + capVertexCount, indices + stackIndexCount + capIndexCount,
+        stackVertexCount + capVertexCount, bottomRadius, cylinderHeight, sliceCount);
+
+    info.IndexCount = (uint32_t)data.Indices.size() - info.StartIndexLocation;
+
+    data.Meshes[name] = info;
+}
+
+// Writes the sliceCount + 2 vertices and sliceCount triangles of the top cap. The first cap vertex has the given index.
+void MeshBuilder::BuildCylinderTopCap(VertexPositionColor* vertices, uint32_t* indices, uint32_t baseIndex, float topRadius, float cylinderHeight, uint32_t sliceCount)
+{
+    float y = 0.5f * cylinderHeight; // the y-coordinate of the top cap
+    float theta = XM_2PI / sliceCount;
+
+    VertexPositionColor v;
+    v.Color = XMFLOAT3(0.0f, 0.5f, 1.0f);
+
+    // Duplicate top cap vertices because the texture coordinates and normals differ.
+    for (uint32_t i = 0; i <= sliceCount; ++i)
+    {
+        float x = topRadius * cosf(i * theta);
+        float z = topRadius * sinf(i * theta);
+
+        v.Position = XMFLOAT3(x, y, z);
+        vertices[i] = v;
+    }
+
+    // The center vertex of the top cap.
+    v.Position = XMFLOAT3(0.0f, y, 0.0f);
+    v.Color = XMFLOAT3(1.0f, 1.0f, 1.0f);
+    vertices[sliceCount + 1] = v;
+
+    // The index of the center vertex.
+    uint32_t centerIndex = baseIndex + sliceCount + 1;
+
+    for (uint32_t i = 0; i < sliceCount; ++i)
+    {
+        indices[i * 3] = centerIndex;
+        indices[i * 3 + 1] = baseIndex + i + 1;
+        indices[i * 3 + 2] = baseIndex + i;
+    }
+}
+
+// Writes the sliceCount + 2 vertices and sliceCount triangles of the bottom cap. The first cap vertex has the given index.
+void MeshBuilder::BuildCylinderBottomCap(VertexPositionColor* vertices, uint32_t* indices, uint32_t baseIndex, float bottomRadius, float cylinderHeight, uint32_t sliceCount)
+{
+    float y = -0.5f * cylinderHeight; // the y-coordinate of the bottom cap
+    float theta = XM_2PI / sliceCount;
+
+    VertexPositionColor v;
+    v.Color = XMFLOAT3(0.0f, 0.5f, 1.0f);
+
+    // Duplicate top cap vertices because the texture coordinates and normals differ.
+    for (uint32_t i = 0; i <= sliceCount; ++i)
+    {
+        float x = bottomRadius * cosf(i * theta);
+        float z = bottomRadius * sinf(i * theta);
+
+        v.Position = XMFLOAT3(x, y, z);
+        vertices[i] = v;
+    }
+
+    // The center vertex of the bottom cap.
+    v.Position = XMFLOAT3(0.0f, y, 0.0f);
+    v.Color = XMFLOAT3(1.0f, 1.0f, 1.0f);
+    vertices[sliceCount + 1] = v;
+
+    // The index of the center vertex.
+    uint32_t centerIndex = baseIndex + sliceCount + 1;
+
+    for (uint32_t i = 0; i < sliceCount; ++i)
+    {
+        indices[i * 3] = centerIndex;
+        indices[i * 3 + 1] = baseIndex + i;
+        indices[i * 3 + 2] = baseIndex + i + 1;
+    }
+}
+
+/// <summary>
+/// Based on [Luna]
+/// 
+/// Creates a sphere using an approach similar to creating a cylinder.
+/// We use trigonometric functions to calculate the radius per stack.
+/// Note that the triangles of the sphere do not have equal areas.
+/// </summary>
+/// <param name="radius">The sphere's radius</param>
+/// <param name="sliceCount">The number of slices</param>
+/// <param name="stackCount">The number of stacks</param>
+/// <param name="threadPool">The pool that builds the stacks in parallel, or nullptr to build them serially</param>
+void MeshBuilder::CreateSphere(ColorMeshData& data, std::string const& name, float radius, uint32_t sliceCount, uint32_t stackCount, ThreadPool* threadPool)
+{
+    ASSERT(data.Meshes.find(name) == data.Meshes.end());
+    ASSERT(stackCount >= 2);
+
+    MeshInfo info;
+    info.BaseVertexLocation = (uint32_t)data.Vertices.size();
+    info.StartIndexLocation = (uint32_t)data.Indices.size();
+
+    auto n = sliceCount + 1; // the number of vertices in a stack
+
+    // The poles and stackCount + 1 rings of vertices. The two polar stacks have one triangle per slice and
+    // the inner stacks two.
+    uint32_t vertexCount = (stackCount + 1) * n + 2;
+    uint32_t indexCount = (stackCount - 1) * sliceCount * 6;
+
+    data.Vertices.resize(info.BaseVertexLocation + vertexCount);
+    data.Indices.resize(info.StartIndexLocation + indexCount);
+    VertexPositionColor* vertices = data.Vertices.data() + info.BaseVertexLocation;
+    uint32_t* indices = data.Indices.data() + info.StartIndexLocation;
+
+    // Create the sphere's poles.
+    VertexPositionColor topVertex{ { 0.0f, radius, 0.0f }, { 1.0f, 1.0f, 1.0f } };
+    VertexPositionColor bottomVertex{ { 0.0f, -radius, 0.0f }, { 1.0f, 1.0f, 1.0f } };
+
+    // Add the north pole as the first vertex and the south pole as the last vertex.
+    vertices[0] = topVertex;
+    vertices[vertexCount - 1] = bottomVertex;
+
+    float phiStep = XM_PI / stackCount;
+    float thetaStep = XM_2PI / sliceCount;
+
+    // The slice angles are the same in every stack, so compute their sines and cosines once.
+    std::vector<float> cosines(n);
+    std::vector<float> sines(n);
+
+    for (uint32_t j = 0; j <= sliceCount; ++j)
+    {
+        float theta = j * thetaStep;
+        cosines[j] = cosf(theta);
+        sines[j] = sinf(theta);
+    }
+
+    // Compute vertices for each stack.
+    ParallelFor(threadPool, stackCount + 1, n, [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                float phi = (i+1) * phiStep;
+                float sinPhi = sinf(phi);
+                float cosPhi = cosf(phi);
+
+                for (uint32_t j = 0; j <= sliceCount; ++j)
+                {
+                    VertexPositionColor& v = vertices[1 + i * n + j];
+
+                    // Convert spherical coordinates to Cartesian coordinates.
+                    v.Position.x = radius * sinPhi * cosines[j];
+                    v.Position.y = radius * cosPhi;
+                    v.Position.z = radius * sinPhi * sines[j];
+
+                    // Alternate color for each stack.
+                    if (i % 2)
+                        v.Color = XMFLOAT3(1.0f, 0.9f, 0.0f);
+                    else
+                        v.Color = XMFLOAT3(0.0f, 0.1f, 1.0f);
+                }
+            }
+        });
+
+    BuildSphereIndices(indices, sliceCount, stackCount, threadPool);
+
+    info.IndexCount = indexCount;
+
+    data.Meshes[name] = info;
+}
+
+/// <summary>
+/// Based on [Luna]
+/// 
+/// Creates a geosphere - a sphere in which each triangle has the same area and equal side lengths.
+/// The geosphere generator starts with an icosahedron (a polyhedron with 20 faces) and subdivides
+/// its sides (the triangles) into smaller triangles. Then, it projects the new vertices onto
+/// a sphere. The process is repeated to improve tessellation.
+/// 
+/// This is how a single triangle is subdivided into four equal sized triangles:
+/// 
+///            v1
+///             *
+///            / \
+///           /   \
+///       m0 *-----*m1
+///         / \   / \
+///        /   \ /   \
+///       *-----*-----*
+///      v0    m2     v2
+///
+/// </summary>
+/// <param name="radius">The sphere's radius</param>
+/// <param name="subdivisionCount">The number of subdivisions between 0 and MAX_COLOR_GEOSPHERE_SUBDIVISION_COUNT</param>
+/// <param name="weldVertices">Share the vertices between neighbouring triangles rather than give each triangle its own</param>
+void MeshBuilder::CreateGeosphere(ColorMeshData& data, std::string const& name, float radius, uint16_t subdivisionCount, bool weldVertices)
+{
+    ASSERT(data.Meshes.find(name) == data.Meshes.end());
+
+    MeshInfo info;
+    info.BaseVertexLocation = (uint32_t)data.Vertices.size(); // initial vertex count
+    info.StartIndexLocation = (uint32_t)data.Indices.size(); // initial index count
+
+    subdivisionCount = std::min(subdivisionCount, MAX_COLOR_GEOSPHERE_SUBDIVISION_COUNT);
+
+    // Each subdivision turns a triangle into four. Welded, the icosahedron's 12 vertices grow by one per edge to
+    // 10 * 4^n + 2; unwelded, each triangle of the level before gets 6 vertices of its own.
+    const size_t triangleCount = size_t{ 20 } << (2 * subdivisionCount);
+    const size_t vertexCount = weldVertices ? triangleCount / 2 + 2 : (subdivisionCount > 0 ? triangleCount / 4 * 6 : 12);
+
+    // The icosahedron is the starting point to generate the geosphere.
+    std::vector<VertexPositionColor> vertices;
+    std::vector<uint32_t> indices;
+    vertices.reserve(vertexCount);
+    indices.reserve(triangleCount * 3);
+    MeshSubdivision::CreateIcosahedron(vertices, indices);
+
+    // Tessellate the icosahedron.
+    EdgeTable midpoints;
+    for (auto i = 0; i < subdivisionCount; ++i)
+    {
+        if (weldVertices)
+            MeshSubdivision::Subdivide(vertices, indices, midpoints);
+        else
+            MeshSubdivision::SubdivideUnwelded(vertices, indices);
+    }
+
+    ASSERT(vertices.size() == vertexCount);
+
+    // Project vertices onto a unit sphere and scale.
+    for (uint32_t i = 0; i < vertices.size(); ++i)
+    {
+        XMVECTOR n = XMVector3Normalize(XMLoadFloat3(&vertices[i].Position));
+        XMVECTOR p = radius * n;
+
+        XMStoreFloat3(&vertices[i].Position, p);
+
+        if (i % 4)
+            vertices[i].Color = XMFLOAT3(0.0f, 0.0f, 1.0f);
+        else
+            vertices[i].Color = XMFLOAT3(1.0f, 0.0f, 0.0f);
+    }
+
+    // Add the geosphere vertices and indices to the buffers.
+    data.Vertices.insert(data.Vertices.end(), vertices.begin(), vertices.end());
+    data.Indices.insert(data.Indices.end(), indices.begin(), indices.end());
+
+    info.IndexCount = (uint32_t)data.Indices.size() - info.StartIndexLocation;
+
+    data.Meshes[name] = info;
+}
+
+/// <summary>
+/// Builds a grid mesh in the xz-plane procedurally.
+/// </summary>
+/// <param name="gridWidth">Grid width. It determines the relative size of the grid.</param>
+/// <param name="gridDepth">Grid depth. It determines the relative size of the grid.</param>
+/// <param name="quadCountHoriz">The number of quads in the grid in the horizontal dimension (x-axis)</param>
+/// <param name="quadCountDepth">The number of quads in the grid in the depth dimension (z-axis)</param>
+/// <param name="threadPool">The pool that builds the rows in parallel, or nullptr to build them serially</param>
+void MeshBuilder::CreateGrid(ColorMeshData& data, std::string const& name, float gridWidth, float gridDepth, uint32_t quadCountHoriz, uint32_t quadCountDepth, ThreadPool* threadPool)
+{
+    ASSERT(data.Meshes.find(name) == data.Meshes.end());
+
+    MeshInfo info;
+    info.BaseVertexLocation = (uint32_t)data.Vertices.size(); // initial vertex count
+    info.StartIndexLocation = (uint32_t)data.Indices.size(); // initial index count
+
+    // The grid is built from an M x N matrix of vertices. 
+    uint32_t m = quadCountDepth + 1;
+    uint32_t n = quadCountHoriz + 1;
+
+    // Create vertices.
+    uint32_t vertexCount = m * n;
+    data.Vertices.resize(info.BaseVertexLocation + vertexCount);
+    VertexPositionColor* vertices = data.Vertices.data() + info.BaseVertexLocation;
+
+    // An example of a 2 x 4 grid mesh:
+    // - quadCountHoriz = 4
+    // - quadCountDepth = 2
+    // - quadCount = 4 * 2 = 8
+    // - triangleCount = quadCount * 2 = 16
+    // - m = 3 (the depth number of vertices)
+    // - n = 5 (the horizontal number of vertices)
+    // - vertexCount = 15
+    // 
+    //  0--1--2--3--4
+    //  |\ |\ |\ |\ | 
+    //  | \| \| \| \|
+    //  5--6--7--8--9
+    //  |\ |\ |\ |\ | 
+    //  | \| \| \| \|
+    // 10-11-12-13-14
+
+    std::vector<float> xs;
+    std::vector<float> zs;
+    ComputeGridCoordinates(gridWidth, gridDepth, quadCountHoriz, quadCountDepth, xs, zs);
+
+    ParallelFor(threadPool, m, n, [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                for (uint32_t j = 0; j < n; ++j)
+                {
+                    VertexPositionColor& vertex = vertices[i * n + j];
+                    vertex.Position = XMFLOAT3(xs[j], 0, zs[i]);
+                    vertex.Color = XMFLOAT3(0.6f, 0.6f, 0.6f);
+                }
+            }
+        });
+
+    // Create indices: 
+    // - each quad has two triangles
+    // - each triangle has three vertices
+    // - each quad is duplicated for the top and the bottom face of the grid
+    uint32_t indexCount = 2 * quadCountHoriz * quadCountDepth * 2 * 3;
+    data.Indices.resize(info.StartIndexLocation + indexCount);
+    BuildGridIndices(data.Indices.data() + info.StartIndexLocation, quadCountHoriz, quadCountDepth, threadPool);
+
+    info.IndexCount = indexCount;
+
+    data.Meshes[name] = info;
+}
+
+// Calls the function for consecutive ranges of [0, rowCount) rows. The ranges run on the thread pool if there is one,
+// each with enough rows to make up about ELEMENTS_PER_TASK vertices or indices; a single range runs on this thread.
+void MeshBuilder::ParallelFor(ThreadPool* threadPool, uint32_t rowCount, uint32_t rowLength, std::function<void(uint32_t, uint32_t)> const& function)
+{
+    size_t rowsPerTask = std::max<size_t>(ELEMENTS_PER_TASK / std::max(rowLength, 1u), 1);
+    if (threadPool == nullptr || rowCount <= rowsPerTask)
+    {
+        function(0, rowCount);
+        return;
+    }
+
+    threadPool->ParallelFor(rowCount, rowsPerTask, [&function](size_t begin, size_t end, unsigned)
+        {
+            function((uint32_t)begin, (uint32_t)end);
+        });
+}
+
+// Writes the indices of stackCount stacks, each a band of sliceCount quads between two rings of sliceCount + 1
+// vertices. The rings are numbered from 0 at the bottom.
+void MeshBuilder::BuildStackIndices(uint32_t* indices, uint32_t sliceCount, uint32_t stackCount, bool invertWinding, ThreadPool* threadPool)
+{
+    // Increase the number of vertices per stack by one because we duplicated the first vertex.
+    auto n = sliceCount + 1;
+
+    // Calculate indices for each stack.
+    ParallelFor(threadPool, stackCount, sliceCount * 6, [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                uint32_t* quad = indices + i * sliceCount * 6;
+
+                for (uint32_t j = 0; j < sliceCount; ++j, quad += 6)
+                {
+                    auto A = i * n + j;
+                    auto B = (i + 1) * n + j;
+                    auto C = (i + 1) * n + j + 1;
+                    auto D = i * n + j + 1;
+
+                    if (invertWinding)
+                    {
+                        // Each quad is composed of two triangles: ACB and ADC
+                        quad[0] = A;
+                        quad[1] = C;
+                        quad[2] = B;
+
+                        quad[3] = A;
+                        quad[4] = D;
+                        quad[5] = C;
+                    }
+                    else
+                    {
+                        // Each quad is composed of two triangles: ABC and ACD
+                        quad[0] = A;
+                        quad[1] = B;
+                        quad[2] = C;
+
+                        quad[3] = A;
+                        quad[4] = C;
+                        quad[5] = D;
+                    }
+                }
+            }
+        });
+}
+
+// Writes the indices of a sphere whose north pole is vertex 0, followed by stackCount + 1 rings of sliceCount + 1
+// vertices and the south pole.
+void MeshBuilder::BuildSphereIndices(uint32_t* indices, uint32_t sliceCount, uint32_t stackCount, ThreadPool* threadPool)
+{
+    // Compute indices for the top stack which contains the north pole.
+    for (uint32_t i = 1; i <= sliceCount; ++i)
+    {
+        indices[(i - 1) * 3] = 0;
+        indices[(i - 1) * 3 + 1] = i + 1;
+        indices[(i - 1) * 3 + 2] = i;
+    }
+
+    // Compute indices for inner stacks.
+    uint32_t baseIndex = 1; // skip the north pole vertex
+    uint32_t n = sliceCount + 1; // the number of vertices in a stack
+    uint32_t* innerIndices = indices + sliceCount * 3;
+
+    ParallelFor(threadPool, stackCount - 2, sliceCount * 6, [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                uint32_t* quad = innerIndices + i * sliceCount * 6;
+
+                for (uint32_t j = 0; j < sliceCount; ++j, quad += 6)
+                {
+                    quad[0] = baseIndex + i * n + j;
+                    quad[1] = baseIndex + i * n + j + 1;
+                    quad[2] = baseIndex + (i + 1) * n + j;
+
+                    quad[3] = baseIndex + (i + 1) * n + j;
+                    quad[4] = baseIndex + i * n + j + 1;
+                    quad[5] = baseIndex + (i + 1) * n + j + 1;
+                }
+            }
+        });
+
+    // Compute indices for the bottom stack which contains the south pole.
+    uint32_t southPoleIndex = (stackCount + 1) * n + 1;
+    uint32_t* bottomIndices = innerIndices + (stackCount - 2) * sliceCount * 6;
+
+    // Offset the indices to the index of the first vertex in the last stack.
+    baseIndex = southPoleIndex - n;
+
+    for (uint32_t i = 0; i < sliceCount; ++i)
+    {
+        bottomIndices[i * 3] = southPoleIndex;
+        bottomIndices[i * 3 + 1] = baseIndex + i;
+        bottomIndices[i * 3 + 2] = baseIndex + i + 1;
+    }
+}
+
+// Computes the x-coordinates of the grid's columns and the z-coordinates of its rows. They are accumulated from the
+// upper-left corner of the grid, so each vertex row of a parallel build gets the same coordinates as a serial one.
+void MeshBuilder::ComputeGridCoordinates(float gridWidth, float gridDepth, uint32_t quadCountHoriz, uint32_t quadCountDepth, std::vector<float>& xs, std::vector<float>& zs)
+{
+    float dx = gridWidth / quadCountHoriz; // the quad spacing along the x-axis 
+    float dz = gridDepth / quadCountDepth; // the quad spacing along the z-axis
+    float halfWidth = 0.5f * gridWidth;
+    float halfDepth = 0.5f * gridDepth;
+
+    xs.resize(quadCountHoriz + 1);
+    zs.resize(quadCountDepth + 1);
+
+    float x = -halfWidth;
+    for (auto& column : xs)
+    {
+        column = x;
+        x += dx;
+    }
+
+    float z = halfDepth;
+    for (auto& row : zs)
+    {
+        row = z;
+        z -= dz;
+    }
+}
+
+// Writes the indices of a grid of quadCountHoriz x quadCountDepth quads, one row of quads after the other.
+void MeshBuilder::BuildGridIndices(uint32_t* indices, uint32_t quadCountHoriz, uint32_t quadCountDepth, ThreadPool* threadPool)
+{
+    uint32_t n = quadCountHoriz + 1;
+
+    ParallelFor(threadPool, quadCountDepth, quadCountHoriz * 12, [&](uint32_t begin, uint32_t end)
+        {
+            for (uint32_t i = begin; i < end; ++i)
+            {
+                uint32_t* k = indices + i * quadCountHoriz * 12;
+
+                for (uint32_t j = 0; j < quadCountHoriz; ++j)
+                {
+                    // Compute four indices of a single quad composed of two triangles: ABD and ADC. 
+                    // The bottom face of the grid has the same indices but in opposite order.
+                    //
+                    //     a----b
+                    //     |\   |
+                    //     | \  |
+                    //     |  \ |
+                    //     |   \|
+                    //     c----d
+                    //
+                    uint32_t a = j + i * n;
+                    uint32_t b = j + 1 + i * n;
+                    uint32_t c = j + (i + 1) * n;
+                    uint32_t d = j + 1 + (i + 1) * n;
+
+                    // top face
+                    k[0] = a;
+                    k[1] = b;
+                    k[2] = d;
+                    k[3] = a;
+                    k[4] = d;
+                    k[5] = c;
+                    k += 6;
+
+                    // bottom face
+                    k[0] = a;
+                    k[1] = d;
+                    k[2] = b;
+                    k[3] = a;
+                    k[4] = c;
+                    k[5] = d;
+                    k += 6;
+                }
+            }
+        });
+}
+
+XMVECTOR MeshBuilder::ComputeNormal(XMFLOAT3 const& p0, XMFLOAT3 const& p1, XMFLOAT3 const& p2)
+{
+    XMVECTOR u = XMLoadFloat3(&p1) - XMLoadFloat3(&p0);
+    XMVECTOR v = XMLoadFloat3(&p2) - XMLoadFloat3(&p0);
+    return XMVector3Normalize(XMVector3Cross(u, v));
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "MeshData.h"
+
+class ThreadPool;
+
+// Generates the geometry of the demos' meshes on the CPU. Each Create* method appends one named mesh to the
+// given MeshData, so the code builds and runs without Direct3D; TextureMeshGenerator and ColorMeshGenerator
+// only upload the result. The tessellated meshes size their vertices and indices up front and, given a thread
+// pool, fill their rows in parallel; the result is the same with or without the pool.
+class MeshBuilder
+{
+public:
+    // Meshes with normals and texture coordinates
+    static void CreateCube(TextureMeshData& data, std::string const& name);
+    static void CreateSimpleCube(TextureMeshData& data, std::string const& name);
+    static void CreatePyramid(TextureMeshData& data, std::string const& name);
+    static void CreateSimplePyramid(TextureMeshData& data, std::string const& name);
+    static void CreateCylinder(TextureMeshData& data, std::string const& name, float bottomRadius, float topRadius, float cylinderHeight, uint32_t sliceCount, uint32_t stackCount, ThreadPool* threadPool = nullptr);
+    static void CreateSphere(TextureMeshData& data, std::string const& name, float radius, uint32_t sliceCount, uint32_t stackCount, ThreadPool* threadPool = nullptr);
+    static void CreateGeosphere(TextureMeshData& data, std::string const& name, float radius, uint16_t subdivisionCount);
+    static void CreateGrid(TextureMeshData& data, std::string const& name, float gridWidth, float gridDepth, uint32_t quadCountHoriz, uint32_t quadCountDepth, ThreadPool* threadPool = nullptr);
+    static void CreatePipe(TextureMeshData& data, std::string const& name, float radius, float height, uint32_t sliceCount, uint32_t stackCount, bool createInterior = false, ThreadPool* threadPool = nullptr);
+    static void CreateQuad(TextureMeshData& data, std::string const& name);
+    static void CreateStar(TextureMeshData& data, std::string const& name, uint32_t armCount, float radiusShort, float radiusLong, float thickness);
+    static void CreateModel(TextureMeshData& data, std::string const& name, std::vector<std::wstring> const& lines, bool hasTexture = false);
+
+    // Meshes with vertex colors
+    static void CreateCube(ColorMeshData& data, std::string const& name);
+    static void CreatePyramid(ColorMeshData& data, std::string const& name);
+    static void CreateCylinder(ColorMeshData& data, std::string const& name, float bottomRadius, float topRadius, float cylinderHeight, uint32_t sliceCount, uint32_t stackCount, ThreadPool* threadPool = nullptr);
+    static void CreateSphere(ColorMeshData& data, std::string const& name, float radius, uint32_t sliceCount, uint32_t stackCount, ThreadPool* threadPool = nullptr);
+    static void CreateGeosphere(ColorMeshData& data, std::string const& name, float radius, uint16_t subdivisionCount, bool weldVertices = true);
+    static void CreateGrid(ColorMeshData& data, std::string const& name, float gridWidth, float gridDepth, uint32_t quadCountHoriz, uint32_t quadCountDepth, ThreadPool* threadPool = nullptr);
+
+    // The finest textured geosphere has 8 * 4^9 = 2M triangles.
+    static constexpr uint16_t MAX_TEXTURE_GEOSPHERE_SUBDIVISION_COUNT = 9;
+
+    // The finest colored geosphere has 20 * 4^8 = 1.3M triangles.
+    static constexpr uint16_t MAX_COLOR_GEOSPHERE_SUBDIVISION_COUNT = 8;
+
+    // A parallel task fills at least this many vertices or indices, so waking a thread pays off. Meshes no larger
+    // than this are built on the calling thread.
+    static constexpr uint32_t ELEMENTS_PER_TASK = 16384;
+
+private:
+    static void BuildCylinderTopCap(VertexPositionNormalTexture* vertices, uint32_t* indices, uint32_t baseIndex, float topRadius, float cylinderHeight, uint32_t sliceCount);
+    static void BuildCylinderBottomCap(VertexPositionNormalTexture* vertices, uint32_t* indices, uint32_t baseIndex, float bottomRadius, float cylinderHeight, uint32_t sliceCount);
+    static void BuildCylinderTopCap(VertexPositionColor* vertices, uint32_t* indices, uint32_t baseIndex, float topRadius, float cylinderHeight, uint32_t sliceCount);
+    static void BuildCylinderBottomCap(VertexPositionColor* vertices, uint32_t* indices, uint32_t baseIndex, float bottomRadius, float cylinderHeight, uint32_t sliceCount);
+    static void BuildStackIndices(uint32_t* indices, uint32_t sliceCount, uint32_t stackCount, bool invertWinding, ThreadPool* threadPool);
+    static void BuildSphereIndices(uint32_t* indices, uint32_t sliceCount, uint32_t stackCount, ThreadPool* threadPool);
+    static void ComputeGridCoordinates(float gridWidth, float gridDepth, uint32_t quadCountHoriz, uint32_t quadCountDepth, std::vector<float>& xs, std::vector<float>& zs);
+    static void BuildGridIndices(uint32_t* indices, uint32_t quadCountHoriz, uint32_t quadCountDepth, ThreadPool* threadPool);
+    static void ParallelFor(ThreadPool* threadPool, uint32_t rowCount, uint32_t rowLength, std::function<void(uint32_t, uint32_t)> const& function);
+    static void CopyIndices(std::vector<uint32_t>& target, std::vector<uint32_t> const& indices, uint32_t startIndexLocation, size_t indexCount);
+    static void GetTokes(const wchar_t* ps, std::vector<std::wstring>& tokens);
+
+    // Computes a face normal of a triangle P1P2P3.
+    static DirectX::XMVECTOR ComputeNormal(DirectX::XMFLOAT3 const& p0, DirectX::XMFLOAT3 const& p1, DirectX::XMFLOAT3 const& p2);
+};
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "VertexStructures.h"
+
+// The location of one mesh in the shared vertex and index buffers. The indices are relative to the base vertex.
+struct MeshInfo
+{
+    uint32_t IndexCount;
+    uint32_t StartIndexLocation;
+    uint32_t BaseVertexLocation;
+};
+
+// The geometry of a set of named meshes that share one vertex and one index buffer. MeshBuilder fills it on
+// the CPU, and the mesh generators upload it to Direct3D buffers.
+template<typename Vertex>
+struct MeshData
+{
+    std::vector<Vertex>                 Vertices;
+    std::vector<uint32_t>               Indices;
+    std::map<std::string, MeshInfo>     Meshes;
+
+    void Clear()
+    {
+        Vertices.clear();
+        Indices.clear();
+        Meshes.clear();
+    }
+};
+
+using ColorMeshData = MeshData<VertexPositionColor>;
+using TextureMeshData = MeshData<VertexPositionNormalTexture>;
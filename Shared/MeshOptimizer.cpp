@@ -0,0 +1,369 @@
+#include "pch.h"
+#include "MeshOptimizer.h"
+
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+    // Forsyth's scoring model: an LRU cache of SCORE_CACHE_SIZE vertices, where the three vertices of the last
+    // triangle score a little lower than the next ones, so the next triangle does not reuse all of them, and
+    // vertices with few triangles left get a boost, so no lone triangles are left behind.
+    const uint32_t SCORE_CACHE_SIZE = 32;
+    const float CACHE_DECAY_POWER = 1.5f;
+    const float LAST_TRIANGLE_SCORE = 0.75f;
+    const float VALENCE_BOOST_SCALE = 2.0f;
+    const float VALENCE_BOOST_POWER = 0.5f;
+
+    // Vertices with more live triangles than this share the boost of the last one, which is nearly zero.
+    const uint32_t MAX_VALENCE = 64;
+
+    const uint32_t NO_TRIANGLE = UINT32_MAX;
+    const uint32_t NOT_CACHED = UINT32_MAX;
+
+    // Looks up the score of a vertex by its position in the cache and its number of live triangles.
+    class VertexScores
+    {
+    public:
+        VertexScores()
+        {
+            for (uint32_t i = 0; i < SCORE_CACHE_SIZE; ++i)
+            {
+                if (i < 3)
+                {
+                    m_cacheScores[i] = LAST_TRIANGLE_SCORE;
+                }
+                else
+                {
+                    float scale = 1.0f / (SCORE_CACHE_SIZE - 3);
+                    m_cacheScores[i] = std::pow(1.0f - (i - 3) * scale, CACHE_DECAY_POWER);
+                }
+            }
+
+            m_valenceScores[0] = 0.0f;
+            for (uint32_t i = 1; i <= MAX_VALENCE; ++i)
+                m_valenceScores[i] = VALENCE_BOOST_SCALE * std::pow(static_cast<float>(i), -VALENCE_BOOST_POWER);
+        }
+
+        float Get(uint32_t cachePosition, uint32_t liveTriangleCount) const
+        {
+            // A vertex that no triangle needs any more must not attract the search.
+            if (liveTriangleCount == 0)
+                return -1.0f;
+
+            float score = m_valenceScores[std::min(liveTriangleCount, MAX_VALENCE)];
+            if (cachePosition != NOT_CACHED)
+                score += m_cacheScores[cachePosition];
+
+            return score;
+        }
+
+    private:
+        float   m_cacheScores[SCORE_CACHE_SIZE];
+        float   m_valenceScores[MAX_VALENCE + 1];
+    };
+
+    // Runs the FIFO cache over the triangles and returns the number of misses. A vertex is cached while fewer
+    // than FIFO_CACHE_SIZE misses have happened since it was loaded at cacheTimes[vertex]; adding
+    // FIFO_CACHE_SIZE + 1 to the time empties the cache. The misses of each triangle go to triangleMisses if
+    // it is not null.
+    uint32_t CountCacheMisses(uint32_t const* indices, size_t indexCount, std::vector<uint32_t>& cacheTimes, uint32_t& time, uint32_t* triangleMisses)
+    {
+        uint32_t missCount = 0;
+
+        for (size_t i = 0; i < indexCount; i += 3)
+        {
+            uint32_t triangleMissCount = 0;
+
+            for (size_t j = i; j < i + 3; ++j)
+            {
+                uint32_t vertex = indices[j];
+                if (time - cacheTimes[vertex] >= MeshOptimizer::FIFO_CACHE_SIZE)
+                {
+                    cacheTimes[vertex] = time++;
+                    ++triangleMissCount;
+                }
+            }
+
+            if (triangleMisses != nullptr)
+                triangleMisses[i / 3] = triangleMissCount;
+
+            missCount += triangleMissCount;
+        }
+
+        return missCount;
+    }
+}
+
+VertexCacheStatistics MeshOptimizer::AnalyzeVertexCache(uint32_t const* indices, size_t indexCount, uint32_t vertexCount)
+{
+    VertexCacheStatistics statistics;
+    if (indexCount == 0)
+        return statistics;
+
+    std::vector<uint32_t> cacheTimes(vertexCount, 0);
+    uint32_t time = FIFO_CACHE_SIZE + 1;
+
+    statistics.TransformCount = CountCacheMisses(indices, indexCount, cacheTimes, time, nullptr);
+    statistics.Acmr = static_cast<float>(statistics.TransformCount) / (indexCount / 3);
+    statistics.Atvr = static_cast<float>(statistics.TransformCount) / vertexCount;
+
+    return statistics;
+}
+
+// Each step emits the triangle with the highest score, the sum of the scores of its vertices, and moves its vertices
+// to the front of the cache. Only the triangles of the vertices in the cache change their scores, so the next best
+// triangle is searched among them. When none of them is left, the search continues with the first triangle not
+// emitted yet.
+void MeshOptimizer::OptimizeVertexCache(uint32_t* indices, size_t indexCount, uint32_t vertexCount)
+{
+    static const VertexScores scores;
+
+    const size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0)
+        return;
+
+    // List the triangles of each vertex. The live triangles of vertex v, those not emitted yet, are the first
+    // liveTriangleCounts[v] entries of its list.
+    std::vector<uint32_t> liveTriangleCounts(vertexCount, 0);
+    for (size_t i = 0; i < indexCount; ++i)
+        ++liveTriangleCounts[indices[i]];
+
+    std::vector<uint32_t> triangleListOffsets(vertexCount + 1, 0);
+    for (uint32_t v = 0; v < vertexCount; ++v)
+        triangleListOffsets[v + 1] = triangleListOffsets[v] + liveTriangleCounts[v];
+
+    std::vector<uint32_t> triangleLists(indexCount);
+    std::vector<uint32_t> listEnds(triangleListOffsets.begin(), triangleListOffsets.end() - 1);
+    for (size_t i = 0; i < indexCount; ++i)
+        triangleLists[listEnds[indices[i]]++] = static_cast<uint32_t>(i / 3);
+
+    std::vector<float> vertexScores(vertexCount);
+    for (uint32_t v = 0; v < vertexCount; ++v)
+        vertexScores[v] = scores.Get(NOT_CACHED, liveTriangleCounts[v]);
+
+    auto const getTriangleScore = [&](uint32_t triangle)
+    {
+        uint32_t const* corners = indices + triangle * 3;
+        return vertexScores[corners[0]] + vertexScores[corners[1]] + vertexScores[corners[2]];
+    };
+
+    // Start with the best triangle of the whole mesh.
+    uint32_t bestTriangle = 0;
+    float bestScore = getTriangleScore(0);
+    for (uint32_t t = 1; t < triangleCount; ++t)
+    {
+        float score = getTriangleScore(t);
+        if (score > bestScore)
+        {
+            bestTriangle = t;
+            bestScore = score;
+        }
+    }
+
+    std::vector<uint32_t> newIndices(indexCount);
+    std::vector<bool> isEmitted(triangleCount, false);
+    size_t nextTriangle = 0;
+
+    // The cache holds up to three more vertices between the steps, those pushed out by the last triangle.
+    uint32_t cache[SCORE_CACHE_SIZE + 3];
+    uint32_t newCache[SCORE_CACHE_SIZE + 3];
+    uint32_t cacheSize = 0;
+
+    for (size_t i = 0; i < triangleCount; ++i)
+    {
+        if (bestTriangle == NO_TRIANGLE)
+        {
+            while (isEmitted[nextTriangle])
+                ++nextTriangle;
+
+            bestTriangle = static_cast<uint32_t>(nextTriangle);
+        }
+
+        uint32_t const* corners = indices + bestTriangle * 3;
+        std::copy(corners, corners + 3, newIndices.data() + i * 3);
+        isEmitted[bestTriangle] = true;
+
+        // Take the triangle off the live lists of its vertices.
+        uint32_t newCacheSize = 0;
+        for (uint32_t k = 0; k < 3; ++k)
+        {
+            uint32_t vertex = corners[k];
+            uint32_t* triangles = triangleLists.data() + triangleListOffsets[vertex];
+            uint32_t& liveCount = liveTriangleCounts[vertex];
+
+            uint32_t* triangle = std::find(triangles, triangles + liveCount, bestTriangle);
+            std::swap(*triangle, triangles[liveCount - 1]);
+            --liveCount;
+
+            if (std::find(newCache, newCache + newCacheSize, vertex) == newCache + newCacheSize)
+                newCache[newCacheSize++] = vertex;
+        }
+
+        // The vertices of the triangle move to the front of the cache and push back the others.
+        for (uint32_t k = 0; k < cacheSize; ++k)
+        {
+            uint32_t vertex = cache[k];
+            if (vertex != corners[0] && vertex != corners[1] && vertex != corners[2])
+                newCache[newCacheSize++] = vertex;
+        }
+
+        for (uint32_t k = 0; k < newCacheSize; ++k)
+        {
+            uint32_t vertex = newCache[k];
+            vertexScores[vertex] = scores.Get(k < SCORE_CACHE_SIZE ? k : NOT_CACHED, liveTriangleCounts[vertex]);
+        }
+
+        // Rescore the live triangles of the vertices that moved, including those that left the cache, and pick
+        // the best of them.
+        bestTriangle = NO_TRIANGLE;
+        bestScore = -1.0f;
+        for (uint32_t k = 0; k < newCacheSize; ++k)
+        {
+            uint32_t vertex = newCache[k];
+            uint32_t const* triangles = triangleLists.data() + triangleListOffsets[vertex];
+
+            for (uint32_t j = 0; j < liveTriangleCounts[vertex]; ++j)
+            {
+                float score = getTriangleScore(triangles[j]);
+                if (score > bestScore)
+                {
+                    bestTriangle = triangles[j];
+                    bestScore = score;
+                }
+            }
+        }
+
+        cacheSize = std::min(newCacheSize, SCORE_CACHE_SIZE);
+        std::copy(newCache, newCache + cacheSize, cache);
+    }
+
+    std::copy(newIndices.begin(), newIndices.end(), indices);
+}
+
+// The cache-optimized order falls apart into runs where the cache starts over, at the triangles that miss all three
+// vertices. Each run is cut further wherever the ACMR of the part so far is within the threshold of the whole run,
+// so restarting the cache there costs little. The clusters are then drawn in the order of how far their centers
+// lie out along their normals from the center of the mesh; outward facing clusters on the hull go first.
+void MeshOptimizer::OptimizeOverdraw(uint32_t* indices, size_t indexCount, XMFLOAT3 const* positions, uint32_t vertexCount, float threshold)
+{
+    const size_t triangleCount = indexCount / 3;
+    if (triangleCount == 0)
+        return;
+
+    std::vector<uint32_t> cacheTimes(vertexCount, 0);
+    uint32_t time = FIFO_CACHE_SIZE + 1;
+
+    std::vector<uint32_t> triangleMisses(triangleCount);
+    CountCacheMisses(indices, indexCount, cacheTimes, time, triangleMisses.data());
+
+    std::vector<size_t> runStarts;
+    for (size_t t = 0; t < triangleCount; ++t)
+    {
+        if (t == 0 || triangleMisses[t] == 3)
+            runStarts.push_back(t);
+    }
+    runStarts.push_back(triangleCount);
+
+    std::vector<size_t> clusterStarts;
+    for (size_t r = 0; r + 1 < runStarts.size(); ++r)
+    {
+        const size_t begin = runStarts[r];
+        const size_t end = runStarts[r + 1];
+
+        time += FIFO_CACHE_SIZE + 1;
+        uint32_t runMissCount = CountCacheMisses(indices + begin * 3, (end - begin) * 3, cacheTimes, time, nullptr);
+        float clusterThreshold = threshold * runMissCount / (end - begin);
+
+        time += FIFO_CACHE_SIZE + 1;
+        clusterStarts.push_back(begin);
+        uint32_t missCount = 0;
+        uint32_t clusterTriangleCount = 0;
+
+        for (size_t t = begin; t < end; ++t)
+        {
+            missCount += CountCacheMisses(indices + t * 3, 3, cacheTimes, time, nullptr);
+            ++clusterTriangleCount;
+
+            if (t + 1 < end && missCount <= clusterThreshold * clusterTriangleCount)
+            {
+                clusterStarts.push_back(t + 1);
+                time += FIFO_CACHE_SIZE + 1;
+                missCount = 0;
+                clusterTriangleCount = 0;
+            }
+        }
+    }
+    clusterStarts.push_back(triangleCount);
+
+    XMVECTOR meshCenter = XMVectorZero();
+    for (size_t i = 0; i < indexCount; ++i)
+        meshCenter += XMLoadFloat3(&positions[indices[i]]);
+    meshCenter = XMVectorScale(meshCenter, 1.0f / indexCount);
+
+    const size_t clusterCount = clusterStarts.size() - 1;
+    std::vector<float> clusterKeys(clusterCount);
+    for (size_t c = 0; c < clusterCount; ++c)
+    {
+        // The cross product of two edges is twice the area of the triangle, so it weighs each normal and center.
+        XMVECTOR normal = XMVectorZero();
+        XMVECTOR center = XMVectorZero();
+        float area = 0.0f;
+
+        for (size_t t = clusterStarts[c]; t < clusterStarts[c + 1]; ++t)
+        {
+            XMVECTOR p0 = XMLoadFloat3(&positions[indices[t * 3 + 0]]);
+            XMVECTOR p1 = XMLoadFloat3(&positions[indices[t * 3 + 1]]);
+            XMVECTOR p2 = XMLoadFloat3(&positions[indices[t * 3 + 2]]);
+
+            XMVECTOR triangleNormal = XMVector3Cross(p1 - p0, p2 - p0);
+            float triangleArea = XMVectorGetX(XMVector3Length(triangleNormal));
+
+            normal += triangleNormal;
+            center += (p0 + p1 + p2) * (triangleArea / 3.0f);
+            area += triangleArea;
+        }
+
+        if (area > 0.0f)
+            clusterKeys[c] = XMVectorGetX(XMVector3Dot(XMVectorScale(center, 1.0f / area) - meshCenter, XMVector3Normalize(normal)));
+        else
+            clusterKeys[c] = 0.0f;
+    }
+
+    std::vector<uint32_t> clusterOrder(clusterCount);
+    for (size_t c = 0; c < clusterCount; ++c)
+        clusterOrder[c] = static_cast<uint32_t>(c);
+
+    std::stable_sort(clusterOrder.begin(), clusterOrder.end(),
+        [&clusterKeys](uint32_t a, uint32_t b) { return clusterKeys[a] > clusterKeys[b]; });
+
+    std::vector<uint32_t> newIndices;
+    newIndices.reserve(indexCount);
+    for (uint32_t c : clusterOrder)
+        newIndices.insert(newIndices.end(), indices + clusterStarts[c] * 3, indices + clusterStarts[c + 1] * 3);
+
+    std::copy(newIndices.begin(), newIndices.end(), indices);
+}
+
+void MeshOptimizer::OptimizeVertexFetch(uint32_t* indices, size_t indexCount, uint32_t vertexCount, std::vector<uint32_t>& remap)
+{
+    const uint32_t UNUSED = UINT32_MAX;
+    remap.assign(vertexCount, UNUSED);
+
+    uint32_t nextVertex = 0;
+    for (size_t i = 0; i < indexCount; ++i)
+    {
+        uint32_t& newVertex = remap[indices[i]];
+        if (newVertex == UNUSED)
+            newVertex = nextVertex++;
+
+        indices[i] = newVertex;
+    }
+
+    for (uint32_t& newVertex : remap)
+    {
+        if (newVertex == UNUSED)
+            newVertex = nextVertex++;
+    }
+}
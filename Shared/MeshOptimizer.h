@@ -0,0 +1,108 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "MeshData.h"
+
+// How well the GPU's post-transform vertex cache serves an index buffer, as measured by a FIFO cache of
+// FIFO_CACHE_SIZE entries. A vertex is transformed again each time it has dropped out of the cache.
+struct VertexCacheStatistics
+{
+    uint32_t    TransformCount = 0;
+    float       Acmr = 0.0f;    // average cache miss ratio: transforms per triangle, from vertices per triangle up to 3
+    float       Atvr = 0.0f;    // average transform to vertex ratio: transforms per vertex, 1.0 at best
+};
+
+// The statistics of one mesh before and after MeshOptimizer::Optimize.
+struct MeshOptimizationResult
+{
+    VertexCacheStatistics   Before;
+    VertexCacheStatistics   After;
+};
+
+// Reorders the triangles and vertices of generated meshes so the GPU transforms and fetches fewer vertices. It
+// runs on the CPU between building the meshes and uploading them, and leaves the geometry itself unchanged:
+// every triangle keeps its vertices and winding, and every vertex keeps its data.
+//
+// The passes run in this order:
+//  - OptimizeVertexCache sorts the triangles with Tom Forsyth's linear-speed vertex cache optimisation, which
+//    greedily picks the next triangle by how recently its vertices were used and how few triangles still need
+//    them.
+//  - OptimizeOverdraw optionally cuts that order into clusters where the cache starts over and draws the
+//    clusters that face outwards first, so they hide more of the rest (Sander, Nehab and Barczak, "Fast
+//    Triangle Reordering for Vertex Locality and Reduced Overdraw"). The threshold bounds the ACMR it may lose.
+//  - OptimizeVertexFetch numbers the vertices in the order the triangles first use them, so the vertex buffer
+//    is read front to back.
+class MeshOptimizer
+{
+public:
+    // Reorders one mesh of the data, which must not share vertices with the other meshes, and returns its vertex
+    // cache statistics before and after. An overdraw threshold of zero skips the overdraw pass; 1.05 allows the
+    // ACMR of each cluster, and of the whole mesh, to grow by 5%.
+    template<typename Vertex>
+    static MeshOptimizationResult Optimize(MeshData<Vertex>& data, MeshInfo const& info, float overdrawThreshold = 0.0f)
+    {
+        uint32_t* indices = data.Indices.data() + info.StartIndexLocation;
+        Vertex* vertices = data.Vertices.data() + info.BaseVertexLocation;
+        const uint32_t vertexCount = GetVertexCount(indices, info.IndexCount);
+
+        MeshOptimizationResult result;
+        result.Before = AnalyzeVertexCache(indices, info.IndexCount, vertexCount);
+
+        // Meshes that are small or already well ordered can come out a little worse; they keep their order.
+        std::vector<uint32_t> oldIndices(indices, indices + info.IndexCount);
+        OptimizeVertexCache(indices, info.IndexCount, vertexCount);
+        if (AnalyzeVertexCache(indices, info.IndexCount, vertexCount).TransformCount > result.Before.TransformCount)
+            std::copy(oldIndices.begin(), oldIndices.end(), indices);
+
+        if (overdrawThreshold > 0.0f)
+        {
+            std::vector<DirectX::XMFLOAT3> positions(vertexCount);
+            for (uint32_t i = 0; i < vertexCount; ++i)
+                positions[i] = vertices[i].Position;
+
+            // The threshold bounds each cluster, but small meshes cut into few clusters can lose more as a whole; they
+            // keep the cache order.
+            const float cacheAcmr = AnalyzeVertexCache(indices, info.IndexCount, vertexCount).Acmr;
+            oldIndices.assign(indices, indices + info.IndexCount);
+            OptimizeOverdraw(indices, info.IndexCount, positions.data(), vertexCount, overdrawThreshold);
+            if (AnalyzeVertexCache(indices, info.IndexCount, vertexCount).Acmr > overdrawThreshold * cacheAcmr)
+                std::copy(oldIndices.begin(), oldIndices.end(), indices);
+        }
+
+        std::vector<uint32_t> remap;
+        OptimizeVertexFetch(indices, info.IndexCount, vertexCount, remap);
+
+        std::vector<Vertex> oldVertices(vertices, vertices + vertexCount);
+        for (uint32_t i = 0; i < vertexCount; ++i)
+            vertices[remap[i]] = oldVertices[i];
+
+        result.After = AnalyzeVertexCache(indices, info.IndexCount, vertexCount);
+        return result;
+    }
+
+    // Simulates the vertex cache for an index buffer that references vertexCount vertices.
+    static VertexCacheStatistics AnalyzeVertexCache(uint32_t const* indices, size_t indexCount, uint32_t vertexCount);
+
+    // Sorts the triangles for the vertex cache.
+    static void OptimizeVertexCache(uint32_t* indices, size_t indexCount, uint32_t vertexCount);
+
+    // Sorts clusters of the cache-optimized triangles so the outward facing ones are drawn first.
+    static void OptimizeOverdraw(uint32_t* indices, size_t indexCount, DirectX::XMFLOAT3 const* positions, uint32_t vertexCount, float threshold);
+
+    // Renumbers the vertices in the order of their first use and fills remap with the new index of each old
+    // vertex. Vertices that no triangle uses move to the end.
+    static void OptimizeVertexFetch(uint32_t* indices, size_t indexCount, uint32_t vertexCount, std::vector<uint32_t>& remap);
+
+    // The cache the statistics simulate. Most GPUs reuse at least this many recent vertices.
+    static constexpr uint32_t FIFO_CACHE_SIZE = 16;
+
+private:
+    // The vertices of a mesh run from its base vertex to the highest index it uses.
+    static uint32_t GetVertexCount(uint32_t const* indices, size_t indexCount)
+    {
+        return indexCount == 0 ? 0 : *std::max_element(indices, indices + indexCount) + 1;
+    }
+};
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+#include "EdgeTable.h"
+
+// Splits every triangle of a mesh into four, the step the geosphere generators repeat to refine an
+// icosahedron. Only the positions of the new vertices are set, so the vertex type just needs a
+// DirectX::XMFLOAT3 Position; the caller fills in the rest once the mesh is complete.
+//
+//       v1
+//        *
+//       / \       m0, m1 and m2 are the midpoints
+//      /   \      of the edges. The triangles
+//   m0*-----*m1   v0 m0 m2, m0 m1 m2, m2 m1 v2 and
+//    / \   / \    m0 v1 m1 replace v0 v1 v2, in that
+//   /   \ /   \   order and with the same winding.
+//  *-----*-----*
+// v0    m2     v2
+class MeshSubdivision
+{
+public:
+    // Appends the 12 vertices and 20 triangles of an icosahedron with its vertices on the unit sphere.
+    template<typename Vertex>
+    static void CreateIcosahedron(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+    {
+        const float X = 0.525731f;
+        const float Z = 0.850651f;
+
+        static const DirectX::XMFLOAT3 Positions[12] =
+        {
+            DirectX::XMFLOAT3(-X, 0.0f, Z), DirectX::XMFLOAT3(X, 0.0f, Z),
+            DirectX::XMFLOAT3(-X, 0.0f, -Z), DirectX::XMFLOAT3(X, 0.0f, -Z),
+            DirectX::XMFLOAT3(0.0f, Z, X), DirectX::XMFLOAT3(0.0f, Z, -X),
+            DirectX::XMFLOAT3(0.0f, -Z, X), DirectX::XMFLOAT3(0.0f, -Z, -X),
+            DirectX::XMFLOAT3(Z, X, 0.0f), DirectX::XMFLOAT3(-Z, X, 0.0f),
+            DirectX::XMFLOAT3(Z, -X, 0.0f), DirectX::XMFLOAT3(-Z, -X, 0.0f)
+        };
+
+        static const uint32_t Indices[60] =
+        {
+            1, 4, 0, 4, 9, 0, 4, 5, 9, 8, 5, 4, 1, 8, 4,
+            1, 10, 8, 10, 3, 8, 8, 3, 5, 3, 2, 5, 3, 7, 2,
+            3, 10, 7, 10, 6, 7, 6, 11, 7, 6, 0, 11, 6, 1, 0,
+            10, 1, 6, 11, 0, 9, 2, 11, 9, 5, 2, 9, 11, 2, 7
+        };
+
+        const uint32_t baseIndex = static_cast<uint32_t>(vertices.size());
+
+        for (auto const& position : Positions)
+        {
+            Vertex vertex{};
+            vertex.Position = position;
+            vertices.push_back(vertex);
+        }
+
+        for (uint32_t index : Indices)
+            indices.push_back(baseIndex + index);
+    }
+
+    // Adds one vertex at the midpoint of each edge, shared by the triangles on both sides, so a closed mesh
+    // gains about three vertices for every four triangles. The midpoints table is only scratch space; pass the
+    // same one to each level to reuse its memory.
+    template<typename Vertex>
+    static void Subdivide(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, EdgeTable& midpoints)
+    {
+        // A closed triangle mesh has one and a half edges per triangle.
+        const size_t triangleCount = indices.size() / 3;
+        const size_t edgeCount = triangleCount * 3 / 2;
+
+        midpoints.Reset(edgeCount);
+        vertices.reserve(vertices.size() + edgeCount);
+
+        std::vector<uint32_t> newIndices;
+        newIndices.reserve(indices.size() * 4);
+
+        auto const divideEdge = [&](uint32_t i0, uint32_t i1)
+        {
+            auto const [index, isNew] = midpoints.Insert(i0, i1, static_cast<uint32_t>(vertices.size()));
+            if (isNew)
+                vertices.push_back(GetMidpoint(vertices[i0], vertices[i1]));
+
+            return index;
+        };
+
+        for (size_t i = 0; i < triangleCount; ++i)
+        {
+            const uint32_t v0 = indices[i * 3 + 0];
+            const uint32_t v1 = indices[i * 3 + 1];
+            const uint32_t v2 = indices[i * 3 + 2];
+
+            const uint32_t m0 = divideEdge(v0, v1);
+            const uint32_t m1 = divideEdge(v1, v2);
+            const uint32_t m2 = divideEdge(v0, v2);
+
+            const uint32_t indicesToAdd[] =
+            {
+                v0, m0, m2,
+                m0, m1, m2,
+                m2, m1, v2,
+                m0, v1, m1,
+            };
+            newIndices.insert(newIndices.end(), std::begin(indicesToAdd), std::end(indicesToAdd));
+        }
+
+        indices.swap(newIndices);
+    }
+
+    // Gives each of the four new triangles of a triangle its own copies of the six vertices, so no vertex is
+    // shared between the triangles of the input. The vertex count grows sixfold with each level.
+    template<typename Vertex>
+    static void SubdivideUnwelded(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices)
+    {
+        std::vector<Vertex> oldVertices;
+        std::vector<uint32_t> oldIndices;
+        oldVertices.swap(vertices);
+        oldIndices.swap(indices);
+
+        const uint32_t triangleCount = static_cast<uint32_t>(oldIndices.size() / 3);
+        vertices.reserve(size_t{ triangleCount } * 6);
+        indices.reserve(size_t{ triangleCount } * 12);
+
+        for (uint32_t i = 0; i < triangleCount; ++i)
+        {
+            Vertex const& v0 = oldVertices[oldIndices[i * 3 + 0]];
+            Vertex const& v1 = oldVertices[oldIndices[i * 3 + 1]];
+            Vertex const& v2 = oldVertices[oldIndices[i * 3 + 2]];
+
+            vertices.push_back(v0); // 0
+            vertices.push_back(v1); // 1
+            vertices.push_back(v2); // 2
+            vertices.push_back(GetMidpoint(v0, v1)); // 3
+            vertices.push_back(GetMidpoint(v1, v2)); // 4
+            vertices.push_back(GetMidpoint(v0, v2)); // 5
+
+            const uint32_t indicesToAdd[] =
+            {
+                0, 3, 5,
+                3, 4, 5,
+                5, 4, 2,
+                3, 1, 4,
+            };
+
+            for (uint32_t index : indicesToAdd)
+                indices.push_back(i * 6 + index);
+        }
+    }
+
+private:
+    template<typename Vertex>
+    static Vertex GetMidpoint(Vertex const& v0, Vertex const& v1)
+    {
+        Vertex m{};
+        m.Position = DirectX::XMFLOAT3(
+            0.5f * (v0.Position.x + v1.Position.x),
+            0.5f * (v0.Position.y + v1.Position.y),
+            0.5f * (v0.Position.z + v1.Position.z));
+
+        return m;
+    }
+};
@@ -2,6 +2,7 @@
 #include "RandomNumberHelper.h"
 
 #include <chrono>
+#include <sstream>
 
 RandomNumberHelper::RandomNumberHelper()
 {
@@ -10,7 +11,37 @@ RandomNumberHelper::RandomNumberHelper()
     m_randomNumberEngine = std::make_unique<std::mt19937>(seed);
 }
 
+RandomNumberHelper::RandomNumberHelper(unsigned int seed)
+{
+    m_randomNumberEngine = std::make_unique<std::mt19937>(seed);
+}
+
+void RandomNumberHelper::Seed(unsigned int seed)
+{
+    m_randomNumberEngine->seed(seed);
+    m_distribution.reset();
+}
+
 float RandomNumberHelper::GetFloat(float min, float max)
 {
     return m_distribution(*m_randomNumberEngine.get()) * (max - min) + min;
 }
+
+std::string RandomNumberHelper::SaveState() const
+{
+    std::ostringstream stream;
+    stream << *m_randomNumberEngine;
+    return stream.str();
+}
+
+bool RandomNumberHelper::LoadState(std::string_view state)
+{
+    std::istringstream stream{ std::string(state) };
+    std::mt19937 engine;
+    if (!(stream >> engine))
+        return false;
+
+    *m_randomNumberEngine = engine;
+    m_distribution.reset();
+    return true;
+}
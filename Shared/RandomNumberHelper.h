@@ -1,13 +1,30 @@
 #pragma once
 
 #include <random> // mt19937, uniform_real_distribution
+#include <string>
+#include <string_view>
 
 class RandomNumberHelper
 {
 public:
+    // Seeds the engine from the clock, so every run gives a different sequence.
     RandomNumberHelper();
+
+    // Seeds the engine with a fixed value, so runs with the same seed give the same sequence.
+    explicit RandomNumberHelper(unsigned int seed);
+
+    // Restarts the sequence from the given seed.
+    void Seed(unsigned int seed);
+
     float GetFloat(float min, float max);
 
+    // Returns the position in the sequence as text, so that it can be saved and the sequence continued later.
+    std::string SaveState() const;
+
+    // Continues the sequence from a saved position. Returns false and leaves the sequence unchanged if the
+    // state is not valid.
+    bool LoadState(std::string_view state);
+
 private:
     std::unique_ptr<std::mt19937> m_randomNumberEngine;
     std::uniform_real_distribution<float> m_distribution;
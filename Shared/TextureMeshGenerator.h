@@ -3,7 +3,8 @@
 #include <string>
 
 #include "DeviceResources.h"
-#include "VertexStructures.h"
+#include "MeshData.h"
+#include "ThreadPool.h"
 
 class TextureMeshGenerator
 {
@@ -23,31 +24,22 @@ public:
     void CreateStar(std::string const& name, uint32_t armCount, float radiusShort, float radiusLong, float thickness);
     winrt::Windows::Foundation::IAsyncAction CreateModelAsync(std::string name, winrt::hstring filename, bool hasTexture = false);
 
+    void OptimizeMeshes(float overdrawThreshold = 0.0f);
     void CreateBuffers();
     void SetBuffers();
     void DrawMesh(std::string const& name);
+    void DrawMeshInstanced(std::string const& name, uint32_t instanceCount);
     void Clear();
 
 private:
-    struct MeshInfo
-    {
-        uint32_t IndexCount;
-        uint32_t StartIndexLocation;
-        uint32_t BaseVertexLocation;
-    };
-
     std::shared_ptr<DX::DeviceResources>    m_deviceResources;
 
     winrt::com_ptr<ID3D11Buffer>            m_vertexBuffer;
     winrt::com_ptr<ID3D11Buffer>            m_indexBuffer;
 
-    std::vector<VertexPositionNormalTexture> m_vertices;
-    std::vector<uint32_t>                   m_indices;
-    std::map<std::string, MeshInfo>         m_meshes;
+    TextureMeshData                         m_meshData;
+    std::unique_ptr<ThreadPool>             m_threadPool;   // builds large meshes in parallel; released once they are uploaded
 
-    void BuildCylinderTopCap(uint32_t baseVertexLocation, float topRadius, float cylinderHeight, uint32_t sliceCount);
-    void BuildCylinderBottomCap(uint32_t baseVertexLocation, float bottomRadius, float cylinderHeight, uint32_t sliceCount);
-    void CopyIndices(std::vector<uint32_t> const& indices, uint32_t startIndexLocation, size_t indexCount);
-    void GetTokes(const wchar_t* ps, std::vector<std::wstring>& tokens);
+    ThreadPool* GetThreadPool(size_t indexCount);
 };
 
@@ -0,0 +1,147 @@
+#include "pch.h"
+#include "ThreadPool.h"
+
+ThreadPool::ThreadPool(unsigned threadCount) :
+    m_function(nullptr),
+    m_pendingRanges(0),
+    m_generation(0),
+    m_stop(false)
+{
+    if (threadCount == 0)
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+
+    for (unsigned i = 0; i < threadCount; ++i)
+        m_queues.emplace_back(std::make_unique<TaskQueue>());
+
+    // Participant 0 is the thread that calls ParallelFor.
+    for (unsigned i = 1; i < threadCount; ++i)
+        m_workers.emplace_back(&ThreadPool::WorkerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+
+    m_workAvailable.notify_all();
+
+    for (auto& worker : m_workers)
+        worker.join();
+}
+
+void ThreadPool::ParallelFor(size_t count, size_t grainSize, std::function<void(size_t, size_t, unsigned)> const& function)
+{
+    if (count == 0)
+        return;
+
+    grainSize = std::max<size_t>(grainSize, 1);
+
+    // Run small loops on the calling thread; waking the workers would cost more than it saves.
+    if (m_workers.empty() || count <= grainSize)
+    {
+        function(0, count, 0);
+        return;
+    }
+
+    std::lock_guard<std::mutex> parallelForLock(m_parallelForMutex);
+
+    // Deal the chunks out round-robin so that each participant starts with a similar amount of work.
+    size_t rangeCount = (count + grainSize - 1) / grainSize;
+    m_function = &function;
+    m_pendingRanges = rangeCount;
+
+    for (size_t i = 0; i < rangeCount; ++i)
+    {
+        Range range{ i * grainSize, std::min(count, (i + 1) * grainSize) };
+        auto& queue = *m_queues[i % m_queues.size()];
+
+        std::lock_guard<std::mutex> lock(queue.Mutex);
+        queue.Ranges.push_back(range);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        ++m_generation;
+    }
+
+    m_workAvailable.notify_all();
+
+    // The calling thread takes part in the loop too.
+    RunRanges(0);
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_workDone.wait(lock, [this]() { return m_pendingRanges == 0; });
+    m_function = nullptr;
+}
+
+void ThreadPool::WorkerLoop(unsigned participant)
+{
+    uint64_t generation = 0;
+
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_workAvailable.wait(lock, [this, generation]() { return m_stop || m_generation != generation; });
+
+            if (m_stop)
+                return;
+
+            generation = m_generation;
+        }
+
+        RunRanges(participant);
+    }
+}
+
+void ThreadPool::RunRanges(unsigned participant)
+{
+    Range range;
+
+    while (PopRange(participant, range) || StealRange(participant, range))
+    {
+        (*m_function)(range.Begin, range.End, participant);
+
+        if (--m_pendingRanges == 0)
+        {
+            // Take the lock so the notification cannot slip in between the waiter's check and its wait.
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_workDone.notify_all();
+        }
+    }
+}
+
+// Takes the next range from the front of the participant's own queue.
+bool ThreadPool::PopRange(unsigned participant, Range& range)
+{
+    auto& queue = *m_queues[participant];
+    std::lock_guard<std::mutex> lock(queue.Mutex);
+
+    if (queue.Ranges.empty())
+        return false;
+
+    range = queue.Ranges.front();
+    queue.Ranges.pop_front();
+    return true;
+}
+
+// Takes a range from the back of another participant's queue.
+bool ThreadPool::StealRange(unsigned participant, Range& range)
+{
+    for (size_t i = 1; i < m_queues.size(); ++i)
+    {
+        auto& queue = *m_queues[(participant + i) % m_queues.size()];
+        std::lock_guard<std::mutex> lock(queue.Mutex);
+
+        if (!queue.Ranges.empty())
+        {
+            range = queue.Ranges.back();
+            queue.Ranges.pop_back();
+            return true;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Runs parallel loops on a fixed set of worker threads. Every participant, including the thread
+// that calls ParallelFor, owns a queue of index ranges. A participant that runs out of work steals
+// ranges from the other queues, so uneven chunks do not leave threads idle.
+class ThreadPool
+{
+public:
+    // Creates a pool with the given number of participants. Zero selects the number of hardware threads.
+    explicit ThreadPool(unsigned threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(ThreadPool const&) = delete;
+    ThreadPool& operator=(ThreadPool const&) = delete;
+
+    // Calls the function for consecutive chunks of [0, count) and waits until all of them finish. The function
+    // receives the chunk and the index of the participant that runs it, which is less than GetThreadCount().
+    // The function must not throw or call ParallelFor on the same pool.
+    void ParallelFor(size_t count, size_t grainSize, std::function<void(size_t, size_t, unsigned)> const& function);
+
+    // Returns the number of participants including the calling thread.
+    unsigned GetThreadCount() const { return static_cast<unsigned>(m_queues.size()); }
+
+private:
+    struct Range
+    {
+        size_t Begin;
+        size_t End;
+    };
+
+    struct TaskQueue
+    {
+        std::mutex          Mutex;
+        std::deque<Range>   Ranges;
+    };
+
+    std::vector<std::thread>                                m_workers;
+    std::vector<std::unique_ptr<TaskQueue>>                 m_queues;
+    std::function<void(size_t, size_t, unsigned)> const*    m_function;
+    std::atomic<size_t>                                     m_pendingRanges;
+    std::mutex                                              m_parallelForMutex;
+    std::mutex                                              m_mutex;
+    std::condition_variable                                 m_workAvailable;
+    std::condition_variable                                 m_workDone;
+    uint64_t                                                m_generation;
+    bool                                                    m_stop;
+
+    void WorkerLoop(unsigned participant);
+    void RunRanges(unsigned participant);
+    bool PopRange(unsigned participant, Range& range);
+    bool StealRange(unsigned participant, Range& range);
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+
+// Passes values from one writer thread to one reader thread without locks. The writer fills the write
+// buffer and publishes it; the reader picks up the latest published buffer and keeps reading it until it
+// asks for a newer one. Neither side ever waits for the other, and values the reader never picked up are
+// simply overwritten.
+template<typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() :
+        m_writeIndex(0),
+        m_readIndex(1),
+        m_middle(2)
+    {
+    }
+
+    TripleBuffer(TripleBuffer const&) = delete;
+    TripleBuffer& operator=(TripleBuffer const&) = delete;
+
+    // Writer: the buffer to fill before the next Publish.
+    T& GetWriteBuffer() { return m_buffers[m_writeIndex]; }
+
+    // Writer: makes the write buffer the latest value and takes over the buffer it replaces.
+    void Publish()
+    {
+        unsigned previous = m_middle.exchange(m_writeIndex | FRESH_BIT, std::memory_order_acq_rel);
+        m_writeIndex = previous & INDEX_MASK;
+    }
+
+    // Reader: switches to the latest published value, if there is a new one. Returns true if it switched.
+    bool Update()
+    {
+        if ((m_middle.load(std::memory_order_relaxed) & FRESH_BIT) == 0)
+            return false;
+
+        unsigned previous = m_middle.exchange(m_readIndex, std::memory_order_acq_rel);
+        m_readIndex = previous & INDEX_MASK;
+        return true;
+    }
+
+    // Reader: the value picked up by the last Update.
+    T const& GetReadBuffer() const { return m_buffers[m_readIndex]; }
+
+private:
+    static const unsigned INDEX_MASK = 3;
+    static const unsigned FRESH_BIT = 4;    // set while the middle buffer holds a value the reader has not seen
+
+    std::array<T, 3>        m_buffers;
+    unsigned                m_writeIndex;   // owned by the writer
+    unsigned                m_readIndex;    // owned by the reader
+    std::atomic<unsigned>   m_middle;       // the buffer passed between them
+};
@@ -44,15 +44,6 @@ ID3D11Buffer* Utilities::CreateImmutableBuffer(ID3D11Device3* device, D3D11_BIND
     return pBuffer;
 }
 
-DirectX::XMVECTOR Utilities::ComputeNormal(DirectX::XMFLOAT3 const& p0, DirectX::XMFLOAT3 const& p1, DirectX::XMFLOAT3 const& p2)
-{
-    using namespace DirectX;
-
-    XMVECTOR u = XMLoadFloat3(&p1) - XMLoadFloat3(&p0);
-    XMVECTOR v = XMLoadFloat3(&p2) - XMLoadFloat3(&p0);
-    return XMVector3Normalize(XMVector3Cross(u, v));
-}
-
 DirectX::XMMATRIX Utilities::CalculateInverseTranspose(DirectX::CXMMATRIX M)
 {
     using namespace DirectX;
@@ -14,6 +14,8 @@ const float DemoMain::BOID_TURN_FACTOR = 0.5f;
 const float DemoMain::BOID_VISUAL_RANGE = 3.0f;
 const float DemoMain::BOID_MOVE_TO_CENTER_FACTOR = 0.01f;
 
+const double DemoMain::SIMULATION_TIME_STEP = 1.0 / 60.0;
+
 const float DemoMain::BOX_EDGE_LENGTH = 45.0f;
 const float DemoMain::BOX_EDGE_THICKNESS = 2.f;
 
@@ -25,7 +27,9 @@ const float DemoMain::INPUT_STEP = 0.15f;
 
 DemoMain::DemoMain() :
     m_hasFocus(false),
-    m_boidShapeIndex(0)
+    m_boidShapeIndex(0),
+    m_isReplayEnabled(false),
+    m_replayStepCount(0)
 {
     m_deviceResources = std::make_shared<DX::DeviceResources>();
     m_deviceResources->RegisterDeviceNotify(this);
@@ -55,6 +59,22 @@ DemoMain::DemoMain() :
         BOX_EDGE_LENGTH);
     m_swarm->AddBoids(INITIAL_BOID_COUNT);
 
+    // The swarm is stepped on its own thread; the render loop only draws the latest published state.
+    m_simulation = std::make_unique<SwarmSimulation>(*m_swarm, SIMULATION_TIME_STEP);
+    m_simulation->SetStepCallback([this](Swarm& swarm, uint64_t)
+        {
+            if (!m_isReplayEnabled)
+                return;
+
+            ++m_replayStepCount;
+
+#if defined(_DEBUG)
+            // Compare the traces of two builds to find the first step at which they diverge.
+            if (m_replayStepCount % REPLAY_CHECKSUM_INTERVAL == 0)
+                DebugTrace(L"Replay step %u: checksum %016llx\n", m_replayStepCount, swarm.ComputeChecksum());
+#endif
+        });
+
     Initialize();
 }
 
@@ -133,6 +153,8 @@ void DemoMain::StartRenderLoop()
     using namespace winrt::Windows::Foundation;
     using namespace winrt::Windows::System::Threading;
 
+    m_simulation->Start();
+
     // Do not start another thread if the render loop is already running.
     if (m_renderLoopWorker != nullptr && m_renderLoopWorker.Status() == AsyncStatus::Started)
         return;
@@ -159,14 +181,16 @@ void DemoMain::StartRenderLoop()
             }
         });
 
-    // Run task on a dedicated high priority background thread.
-    m_renderLoopWorker = ThreadPool::RunAsync(workItemHandler, WorkItemPriority::High, WorkItemOptions::TimeSliced);
+    // Run task on a dedicated high priority background thread of the WinRT thread pool.
+    m_renderLoopWorker = winrt::Windows::System::Threading::ThreadPool::RunAsync(workItemHandler, WorkItemPriority::High, WorkItemOptions::TimeSliced);
 }
 
 void DemoMain::StopRenderLoop()
 {
     if (m_renderLoopWorker != nullptr)
         m_renderLoopWorker.Cancel();
+
+    m_simulation->Stop();
 }
 
 void DemoMain::FocusChanged(bool hasFocus)
@@ -272,8 +296,6 @@ void DemoMain::Update()
 
             float timeDelta{ static_cast<float>(m_timer.GetElapsedSeconds()) };
 
-            m_swarm->Update(timeDelta);
-
             //
             // Animate water texture coordinates.
             //
@@ -346,11 +368,9 @@ void DemoMain::DrawScene()
         break;
     }
 
-    m_swarm->Iterate([this, &meshName](XMMATRIX worldMatrix)
-        {
-            m_sceneRenderer->SetWorldMatrix(worldMatrix);
-            m_sceneRenderer->RenderMesh(meshName);
-        });
+    size_t boidCount = m_simulation->WriteInstanceTransforms(m_boidTransforms);
+
+    m_sceneRenderer->RenderMeshInstanced(meshName, std::span(m_boidTransforms.data(), boidCount));
 
     // Draw sky.
     m_skyRenderer->Render();
@@ -374,6 +394,12 @@ void DemoMain::DrawCube(DirectX::FXMMATRIX worldMatrix)
 
 void DemoMain::RestartSimulation()
 {
+    if (m_isReplayEnabled)
+    {
+        SetIsReplayEnabled(true);
+        return;
+    }
+
     m_swarm->ResetBoids();
 }
 
@@ -386,3 +412,22 @@ void DemoMain::RemoveBoids()
 {
     m_swarm->RemoveBoids(BOID_COUNT_TO_REMOVE);
 }
+
+// In the replay mode, the swarm restarts from a fixed seed. The simulation runs with fixed time steps, so
+// every replay produces the same states as long as the boid parameters are not changed.
+void DemoMain::SetIsReplayEnabled(bool enabled)
+{
+    // Restart between two steps, so no step sees a partly restarted swarm.
+    m_simulation->Invoke([this, enabled](Swarm& swarm)
+        {
+            m_isReplayEnabled = enabled;
+            m_replayStepCount = 0;
+
+            if (enabled)
+            {
+                swarm.Seed(REPLAY_SEED);
+                swarm.RemoveBoids(static_cast<int>(swarm.Size()));
+                swarm.AddBoids(INITIAL_BOID_COUNT);
+            }
+        });
+}
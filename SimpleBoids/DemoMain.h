@@ -1,5 +1,7 @@
 #pragma once
 
+#include <atomic>
+
 #include "BoidParameter.h"
 #include "CommonRenderer.h"
 #include "DeviceResources.h"
@@ -8,6 +10,7 @@
 #include "SkyRenderer.h"
 #include "StepTimer.h"
 #include "Swarm.h"
+#include "SwarmSimulation.h"
 
 class DemoMain : public winrt::implements<DemoMain, winrt::Windows::Foundation::IInspectable>, public DX::IDeviceNotify
 {
@@ -32,11 +35,15 @@ public:
     size_t GetSwarmSize() const { return m_swarm->Size(); }
     float GetBoidParameter(BoidParameter parameter) const { return m_swarm->GetBoidParameter(parameter); }
     bool GetIsVisualRangeEnabled() const { return m_swarm->IsVisualRangeEnabled(); }
+    bool GetIsTopologicalEnabled() const { return m_swarm->IsTopologicalEnabled(); }
+    bool GetIsReplayEnabled() const { return m_isReplayEnabled; }
 
     // Setters
     void SetBoidShape(int32_t boidShapeIndex) { m_boidShapeIndex = boidShapeIndex; }
     void SetBoidParameter(BoidParameter parameter, float value) { m_swarm->SetBoidParameter(parameter, value); }
     void SetIsVisualRangeEnabled(bool enabled) { m_swarm->IsVisualRangeEnabled(enabled); }
+    void SetIsTopologicalEnabled(bool enabled) { m_swarm->IsTopologicalEnabled(enabled); }
+    void SetIsReplayEnabled(bool enabled);
 
     // App-specific methods.
     void RestartSimulation();
@@ -62,6 +69,11 @@ private:
     static const float BOID_VISUAL_RANGE;           // used in calculating boid's velocity while taking into account only boids in a certain range
     static const float BOID_MOVE_TO_CENTER_FACTOR;  // determines how to move a boid towards the center (percentage)
 
+    // Simulation constants.
+    static const double SIMULATION_TIME_STEP;       // the fixed simulation step in seconds
+    static const uint32_t REPLAY_SEED = 1;
+    static const uint32_t REPLAY_CHECKSUM_INTERVAL = 60;
+
     // Boundary box constants.
     static const float BOX_EDGE_LENGTH;
     static const float BOX_EDGE_THICKNESS; 
@@ -83,8 +95,12 @@ private:
     std::unique_ptr<IndependentInput>           m_input;
     bool                                        m_hasFocus;
     std::unique_ptr<Swarm>                      m_swarm;
+    std::unique_ptr<SwarmSimulation>            m_simulation;
     int32_t                                     m_boidShapeIndex;
     DirectX::XMFLOAT4X4                         m_waterTextureTransform;
+    std::vector<DirectX::XMFLOAT4X4>            m_boidTransforms;
+    std::atomic<bool>                           m_isReplayEnabled;  // set by the simulation thread between two steps, read by the UI
+    uint32_t                                    m_replayStepCount;  // changed only by the simulation thread
 
     // Private helper methods.
     void StartRenderLoop();
@@ -60,6 +60,7 @@ namespace winrt::SimpleBoids::implementation
         TurnFactorSlider().Value(m_main->GetBoidParameter(BoidParameter::TurnFactor)); 
         VisualRangeSlider().Value(m_main->GetBoidParameter(BoidParameter::VisualRange));
         VisualRangeSlider().IsEnabled(m_main->GetIsVisualRangeEnabled());
+        TopologicalToggle().IsOn(m_main->GetIsTopologicalEnabled());
     }
 
     /// <summary>
@@ -217,6 +218,28 @@ namespace winrt::SimpleBoids::implementation
         m_main->SetIsVisualRangeEnabled(isVisualRangeEnabled);
         VisualRangeSlider().IsEnabled(isVisualRangeEnabled);
     }
+
+    void MainPage::TopologicalToggle_Toggled([[maybe_unused]] winrt::Windows::Foundation::IInspectable const& sender, [[maybe_unused]] winrt::Windows::UI::Xaml::RoutedEventArgs const& args)
+    {
+        if (!TopologicalToggle().IsLoaded())
+            return;
+
+        // The nearest neighbours take precedence over the visual range.
+        bool isTopologicalEnabled = TopologicalToggle().IsOn();
+        m_main->SetIsTopologicalEnabled(isTopologicalEnabled);
+        VisualRangeToggle().IsEnabled(!isTopologicalEnabled);
+        VisualRangeSlider().IsEnabled(!isTopologicalEnabled && VisualRangeToggle().IsOn());
+    }
+
+    void MainPage::ReplayToggle_Toggled([[maybe_unused]] winrt::Windows::Foundation::IInspectable const& sender, [[maybe_unused]] winrt::Windows::UI::Xaml::RoutedEventArgs const& args)
+    {
+        if (!ReplayToggle().IsLoaded())
+            return;
+
+        // Turning the replay on restarts the swarm with the initial number of boids.
+        m_main->SetIsReplayEnabled(ReplayToggle().IsOn());
+        BoidCountTextBlock().Text(std::to_wstring(m_main->GetSwarmSize()));
+    }
 }
 
 
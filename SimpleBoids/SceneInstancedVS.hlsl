@@ -0,0 +1,44 @@
+#include "ConstantBuffers.hlsli"
+
+// Per-vertex data and per-instance world matrix used as input to the vertex shader.
+struct VertexShaderInput
+{
+    float3 PosL    : POSITION;
+    float3 NormalL : NORMAL;
+    float2 Tex     : TEXCOORD;
+    float4 World0  : WORLD0;    // the first three columns of the instance's affine world matrix
+    float4 World1  : WORLD1;
+    float4 World2  : WORLD2;
+};
+
+// Per-pixel color data passed through the pixel shader.
+struct VertexShaderOutput // = PixelShaderInput
+{
+    float4 PosH    : SV_POSITION;
+    float3 PosW    : POSITION;
+    float3 NormalW : NORMAL;
+    float2 Tex     : TEXCOORD;
+};
+
+VertexShaderOutput main(VertexShaderInput input)
+{
+    VertexShaderOutput output;
+    float4 pos = float4(input.PosL, 1.0f);
+
+    // Transform the vertex position to world space. We need that for specular light calculations.
+    output.PosW = float3(dot(pos, input.World0), dot(pos, input.World1), dot(pos, input.World2));
+
+    // Transform the vertex position into projected space.
+    output.PosH = mul(mul(float4(output.PosW, 1.0f), View), Projection);
+
+    // Transform the normal to world space. Instances are only rotated, translated and uniformly scaled,
+    // so the world matrix transforms normals the same way as its inverse transpose up to the length.
+    // Note that by setting w=0 we don't apply translation to the normals.
+    float4 normal = float4(input.NormalL, 0.0f);
+    output.NormalW = normalize(float3(dot(normal, input.World0), dot(normal, input.World1), dot(normal, input.World2)));
+
+    // Transform the input texture coordinates.
+    output.Tex = mul(float4(input.Tex, 0.0f, 1.0f), TextureTransform).xy;
+
+    return output;
+}
\ No newline at end of file
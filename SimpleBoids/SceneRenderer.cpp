@@ -14,9 +14,13 @@ SceneRenderer::SceneRenderer(std::shared_ptr<DX::DeviceResources> const& deviceR
     m_vertexShader(nullptr),
     m_inputLayout(nullptr),
     m_pixelShader(nullptr),
+    m_instancedVertexShader(nullptr),
+    m_instancedInputLayout(nullptr),
+    m_instanceBuffer(nullptr),
     m_cbufferPerObject(nullptr),
     m_cbufferPerObjectData(),
-    m_transparentBlendState(nullptr)
+    m_transparentBlendState(nullptr),
+    m_instanceBatcher(INSTANCE_BUFFER_CAPACITY)
 {
     m_meshGenerator = std::make_unique<TextureMeshGenerator>(m_deviceResources);
 }
@@ -34,6 +38,7 @@ winrt::Windows::Foundation::IAsyncAction SceneRenderer::CreateDeviceResourcesAsy
     // Load shader bytecode.
     auto vertexShaderBytecode = co_await Utilities::ReadDataAsync(L"SceneVS.cso");
     auto pixelShaderBytecode = co_await Utilities::ReadDataAsync(L"ScenePS.cso");
+    auto instancedVertexShaderBytecode = co_await Utilities::ReadDataAsync(L"SceneInstancedVS.cso");
 
     // Create vertex shader.
     winrt::check_hresult(
@@ -68,6 +73,42 @@ winrt::Windows::Foundation::IAsyncAction SceneRenderer::CreateDeviceResourcesAsy
             nullptr,
             m_pixelShader.put()));
 
+    // Create the instanced vertex shader.
+    winrt::check_hresult(
+        device->CreateVertexShader(
+            instancedVertexShaderBytecode.data(),
+            instancedVertexShaderBytecode.Length(),
+            nullptr,
+            m_instancedVertexShader.put()));
+
+    // Create the instanced vertex description. Slot 0 holds the mesh vertices and slot 1 the instance transforms.
+    static const D3D11_INPUT_ELEMENT_DESC instancedVertexDesc[] =
+    {
+        { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 0, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        { "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, 12, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 24, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+        { "WORLD", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 0, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+        { "WORLD", 1, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 16, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+        { "WORLD", 2, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, 32, D3D11_INPUT_PER_INSTANCE_DATA, 1 }
+    };
+
+    winrt::check_hresult(
+        device->CreateInputLayout(
+            instancedVertexDesc,
+            ARRAYSIZE(instancedVertexDesc),
+            instancedVertexShaderBytecode.data(),
+            instancedVertexShaderBytecode.Length(),
+            m_instancedInputLayout.put()));
+
+    // Create the instance buffer. It is rewritten for every batch, so the CPU needs write access.
+    CD3D11_BUFFER_DESC instanceBufferDesc(
+        INSTANCE_BUFFER_CAPACITY * sizeof(InstanceTransform),
+        D3D11_BIND_VERTEX_BUFFER,
+        D3D11_USAGE_DYNAMIC,
+        D3D11_CPU_ACCESS_WRITE);
+    winrt::check_hresult(
+        device->CreateBuffer(&instanceBufferDesc, nullptr, m_instanceBuffer.put()));
+
     // Create constant buffers.
     uint32_t byteWidth = (sizeof(CBufferPerObject) + 15) / 16 * 16;
     CD3D11_BUFFER_DESC cbPerObjectDesc(byteWidth, D3D11_BIND_CONSTANT_BUFFER);
@@ -130,6 +171,9 @@ void SceneRenderer::ReleaseDeviceDependentResources()
     m_vertexShader = nullptr;
     m_inputLayout = nullptr;
     m_pixelShader = nullptr;
+    m_instancedVertexShader = nullptr;
+    m_instancedInputLayout = nullptr;
+    m_instanceBuffer = nullptr;
     m_cbufferPerObject = nullptr;
     m_transparentBlendState = nullptr;
 }
@@ -169,6 +213,44 @@ void SceneRenderer::RenderMesh(std::string const& name)
     m_meshGenerator->DrawMesh(name);
 }
 
+void SceneRenderer::RenderMeshInstanced(std::string const& name, std::span<DirectX::XMFLOAT4X4 const> worldMatrices)
+{
+    if (!m_initialized || worldMatrices.empty())
+        return;
+
+    auto context{ m_deviceResources->GetD3DDeviceContext() };
+
+    // The material and the texture transform are shared by all instances.
+    context->UpdateSubresource(m_cbufferPerObject.get(), 0, nullptr, &m_cbufferPerObjectData, 0, 0);
+
+    context->IASetInputLayout(m_instancedInputLayout.get());
+    context->VSSetShader(m_instancedVertexShader.get(), nullptr, 0);
+
+    UINT stride = sizeof(InstanceTransform);
+    UINT offset = 0;
+    ID3D11Buffer* pInstanceBuffer{ m_instanceBuffer.get() };
+    context->IASetVertexBuffers(1, 1, &pInstanceBuffer, &stride, &offset);
+
+    m_instanceBatcher.Pack(worldMatrices);
+
+    for (auto const& batch : m_instanceBatcher.GetBatches())
+    {
+        // Discarding the previous contents lets the GPU keep drawing the previous batch from its own copy.
+        auto instances = m_instanceBatcher.GetInstances(batch);
+        D3D11_MAPPED_SUBRESOURCE mappedResource;
+        winrt::check_hresult(
+            context->Map(m_instanceBuffer.get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mappedResource));
+        memcpy(mappedResource.pData, instances.data(), instances.size_bytes());
+        context->Unmap(m_instanceBuffer.get(), 0);
+
+        m_meshGenerator->DrawMeshInstanced(name, batch.InstanceCount);
+    }
+
+    // Restore the per-object pipeline state.
+    context->IASetInputLayout(m_inputLayout.get());
+    context->VSSetShader(m_vertexShader.get(), nullptr, 0);
+}
+
 void SceneRenderer::SetWorldMatrix(DirectX::FXMMATRIX worldMatrix)
 {
     // Calculate the world inverse transpose matrix in order to properly transform normals in case there are any non-uniform or shear transformations.
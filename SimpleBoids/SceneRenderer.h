@@ -2,6 +2,7 @@
 
 #include "ConstantBuffers.h"
 #include "DeviceResources.h"
+#include "InstanceBatcher.h"
 #include "TextureMeshGenerator.h"
 
 class SceneRenderer
@@ -24,6 +25,10 @@ public:
     // Rendering methods.
     void RenderMesh(std::string const& name);
 
+    // Draws a copy of the mesh for each world matrix with as few draw calls as the instance buffer allows.
+    // The world matrices must be affine without non-uniform scaling or shear.
+    void RenderMeshInstanced(std::string const& name, std::span<DirectX::XMFLOAT4X4 const> worldMatrices);
+
     // World matrix methods.
     void SetWorldMatrix(DirectX::FXMMATRIX worldMatrix);
 
@@ -41,6 +46,9 @@ public:
     void ClearTransparentBlendState();
 
 private:
+    // The number of instances drawn by one instanced draw call.
+    static const uint32_t INSTANCE_BUFFER_CAPACITY = 4096;
+
     std::shared_ptr<DX::DeviceResources>    m_deviceResources;
     bool                                    m_initialized;
     std::unique_ptr<TextureMeshGenerator>   m_meshGenerator;
@@ -49,6 +57,9 @@ private:
     winrt::com_ptr<ID3D11VertexShader>      m_vertexShader;
     winrt::com_ptr<ID3D11InputLayout>       m_inputLayout;
     winrt::com_ptr<ID3D11PixelShader>       m_pixelShader;
+    winrt::com_ptr<ID3D11VertexShader>      m_instancedVertexShader;
+    winrt::com_ptr<ID3D11InputLayout>       m_instancedInputLayout;
+    winrt::com_ptr<ID3D11Buffer>            m_instanceBuffer;
     winrt::com_ptr<ID3D11Buffer>            m_cbufferPerObject;
     std::map<std::string, winrt::com_ptr<ID3D11ShaderResourceView>> m_textures;
     winrt::com_ptr<ID3D11BlendState>        m_transparentBlendState;
@@ -56,5 +67,6 @@ private:
     // Data structures.
     CBufferPerObject                        m_cbufferPerObjectData;
     std::map<std::string, MaterialDesc>     m_materials;
+    InstanceBatcher                         m_instanceBatcher;
 };
 
@@ -0,0 +1,111 @@
+#include "pch.h"
+
+#include "Boid.h"
+
+using namespace DirectX;
+
+Boid::Boid(BoidStore& store, size_t index) :
+    m_store(store),
+    m_index(index)
+{
+}
+
+void Boid::Update(DirectX::FXMVECTOR velocityDelta)
+{
+    Integrate(m_store, m_store, m_index, velocityDelta);
+}
+
+void Boid::Integrate(BoidStore const& source, BoidStore& target, size_t index, DirectX::FXMVECTOR velocityDelta)
+{
+    Integrate(source, target, index, velocityDelta, source.GetMaxSpeed(), Integrator::Legacy, REFERENCE_TIME_STEP);
+}
+
+void Boid::Integrate(
+    BoidStore const& source,
+    BoidStore& target,
+    size_t index,
+    DirectX::FXMVECTOR velocityDelta,
+    float maxSpeed,
+    Integrator integrator,
+    float timeDelta)
+{
+    XMVECTOR velocity = source.GetVelocity(index);
+    XMVECTOR newVelocity = XMVectorAdd(velocity, velocityDelta);
+
+    // Limit the boid's speed i.e., limit the magnitude of the boid's velocity.
+    float speed = XMVectorGetX(XMVector3Length(newVelocity));
+    if (speed > maxSpeed)
+        newVelocity = (newVelocity / speed) * maxSpeed;
+    target.SetVelocity(index, newVelocity);
+
+    // The velocity changes once per step, as the rules are evaluated once per step. Verlet therefore holds the
+    // acceleration over the step: the displacement v dt + a dt^2 / 2 is the average velocity times dt.
+    XMVECTOR displacement;
+    switch (integrator)
+    {
+    case Integrator::SemiImplicitEuler:
+        displacement = newVelocity * (timeDelta / REFERENCE_TIME_STEP);
+        break;
+    case Integrator::Verlet:
+        displacement = (velocity + newVelocity) * (0.5f * timeDelta / REFERENCE_TIME_STEP);
+        break;
+    default:
+        displacement = newVelocity;
+        break;
+    }
+
+    XMVECTOR newPosition = XMVectorAdd(source.GetPosition(index), displacement);
+    target.SetPosition(index, newPosition);
+}
+
+DirectX::XMVECTOR Boid::GetPosition() const
+{
+    return m_store.GetPosition(m_index);
+}
+
+DirectX::XMVECTOR Boid::GetVelocity() const
+{
+    return m_store.GetVelocity(m_index);
+}
+
+DirectX::XMMATRIX Boid::GetWorldMatrix() const
+{
+    return ComputeWorldMatrix(GetPosition(), GetVelocity());
+}
+
+DirectX::XMMATRIX Boid::ComputeWorldMatrix(DirectX::FXMVECTOR position, DirectX::FXMVECTOR velocity)
+{
+    // The initial boid orientation: a quarter turn about the x-axis.
+    static const XMVECTORF32 initialOrientation = { 0.70710678f, 0.f, 0.f, 0.70710678f };
+
+    // Adjust the boid orientation. The shortest rotation from the boid's initial direction v0 = (0,0,1) to the
+    // direction of flight v1 is the quaternion (v0 x v1, 1 + v0.v1) normalized, which needs no trigonometry.
+    XMVECTOR rotation = XMQuaternionIdentity();
+
+    if (XMVectorGetX(XMVector3LengthSq(velocity)) > 0.f)
+    {
+        XMFLOAT3 v1;
+        XMStoreFloat3(&v1, XMVector3Normalize(velocity));
+
+        float w = 1.f + v1.z;
+        if (w > 1e-6f)
+            rotation = XMQuaternionNormalize(XMVectorSet(-v1.y, v1.x, 0.f, w));
+        else
+            rotation = XMVectorSet(1.f, 0.f, 0.f, 0.f); // v1 is opposite to v0: half a turn about the x-axis
+    }
+
+    XMMATRIX worldMatrix = XMMatrixRotationQuaternion(XMQuaternionMultiply(initialOrientation, rotation));
+    worldMatrix.r[3] = XMVectorSetW(position, 1.f);
+
+    return worldMatrix;
+}
+
+void Boid::SetPosition(DirectX::FXMVECTOR position)
+{
+    m_store.SetPosition(m_index, position);
+}
+
+void Boid::SetVelocity(DirectX::FXMVECTOR velocity)
+{
+    m_store.SetVelocity(m_index, velocity);
+}
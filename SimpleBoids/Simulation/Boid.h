@@ -0,0 +1,53 @@
+#pragma once
+
+#include "BoidStore.h"
+
+// How Boid::Integrate moves a boid over a time step. Velocities are in units per reference step of
+// Boid::REFERENCE_TIME_STEP seconds, so the time-correct integrators move the boids as far as Legacy
+// does at that step and keep the tuning of the speeds and factors.
+enum class Integrator
+{
+    Legacy,             // explicit Euler that moves the boid by its velocity once per step, however long the step is
+    SemiImplicitEuler,  // moves the boid by its new velocity for the length of the step
+    Verlet,             // moves the boid by the average of its old and new velocity, i.e. velocity Verlet
+};
+
+// A lightweight view of a single boid in a BoidStore. Views are cheap to create and
+// must not outlive the store or be used after the store is resized.
+class Boid
+{
+public:
+    Boid(BoidStore& store, size_t index);
+    void Update(DirectX::FXMVECTOR velocityDelta);
+
+    // Applies the velocity change to the boid at the index in the source store and writes the result
+    // to the same index in the target store. The stores may be the same.
+    static void Integrate(BoidStore const& source, BoidStore& target, size_t index, DirectX::FXMVECTOR velocityDelta);
+
+    // Same as above with the given max speed instead of the max speed of the source store, and the given
+    // integrator over a step of timeDelta seconds.
+    static void Integrate(
+        BoidStore const& source,
+        BoidStore& target,
+        size_t index,
+        DirectX::FXMVECTOR velocityDelta,
+        float maxSpeed,
+        Integrator integrator,
+        float timeDelta);
+
+    // Returns the world matrix of a boid at the position that flies in the direction of the velocity.
+    static DirectX::XMMATRIX ComputeWorldMatrix(DirectX::FXMVECTOR position, DirectX::FXMVECTOR velocity);
+
+    DirectX::XMVECTOR GetPosition() const;
+    DirectX::XMVECTOR GetVelocity() const;
+    DirectX::XMMATRIX GetWorldMatrix() const;
+    void SetPosition(DirectX::FXMVECTOR position);
+    void SetVelocity(DirectX::FXMVECTOR velocity);
+
+    // The time step the velocities are measured in, the frame time the demo was tuned at.
+    static constexpr float REFERENCE_TIME_STEP = 1.f / 60.f;
+
+private:
+    BoidStore& m_store;
+    size_t m_index;
+};
@@ -0,0 +1,261 @@
+#include "pch.h"
+#include "BoidKernel.h"
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__i386__) || defined(__x86_64__)
+#define BOID_KERNEL_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define BOID_KERNEL_AVX2
+#else
+#define BOID_KERNEL_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+namespace
+{
+    // Holds pointers to the boid component arrays.
+    struct BoidArrays
+    {
+        float const* PositionX;
+        float const* PositionY;
+        float const* PositionZ;
+        float const* VelocityX;
+        float const* VelocityY;
+        float const* VelocityZ;
+
+        BoidArrays(BoidStore const& boids) :
+            PositionX(boids.GetPositionsX().data()),
+            PositionY(boids.GetPositionsY().data()),
+            PositionZ(boids.GetPositionsZ().data()),
+            VelocityX(boids.GetVelocitiesX().data()),
+            VelocityY(boids.GetVelocitiesY().data()),
+            VelocityZ(boids.GetVelocitiesZ().data())
+        {
+        }
+    };
+
+    void AccumulateScalar(BoidArrays const& a, NeighborQuery const& q, uint32_t const* candidates, size_t begin, size_t end, NeighborSums& sums)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            uint32_t j = candidates[i];
+
+            float dx = a.PositionX[j] - q.Position.x;
+            float dy = a.PositionY[j] - q.Position.y;
+            float dz = a.PositionZ[j] - q.Position.z;
+            float distanceSq = dx * dx + dy * dy + dz * dz;
+
+            if (distanceSq < q.SeparationDistanceSq)
+            {
+                sums.Separation.x -= dx;
+                sums.Separation.y -= dy;
+                sums.Separation.z -= dz;
+            }
+
+            if (distanceSq < q.RangeDistanceSq)
+            {
+                sums.Alignment.x += a.VelocityX[j];
+                sums.Alignment.y += a.VelocityY[j];
+                sums.Alignment.z += a.VelocityZ[j];
+                ++sums.RangeCount;
+            }
+        }
+    }
+
+#if defined(BOID_KERNEL_X86)
+    inline __m128 Load4(float const* data, uint32_t const* indices, size_t i)
+    {
+        return _mm_setr_ps(data[indices[i]], data[indices[i + 1]], data[indices[i + 2]], data[indices[i + 3]]);
+    }
+
+    inline float HorizontalSum(__m128 v)
+    {
+        alignas(16) float lanes[4];
+        _mm_store_ps(lanes, v);
+        return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    }
+
+    inline uint32_t HorizontalSum(__m128i v)
+    {
+        alignas(16) uint32_t lanes[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(lanes), v);
+        return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    }
+
+    void AccumulateSSE(BoidArrays const& a, NeighborQuery const& q, uint32_t const* candidates, size_t count, NeighborSums& sums)
+    {
+        __m128 px = _mm_set1_ps(q.Position.x);
+        __m128 py = _mm_set1_ps(q.Position.y);
+        __m128 pz = _mm_set1_ps(q.Position.z);
+        __m128 separationDistanceSq = _mm_set1_ps(q.SeparationDistanceSq);
+        __m128 rangeDistanceSq = _mm_set1_ps(q.RangeDistanceSq);
+
+        __m128 separationX = _mm_setzero_ps(), separationY = _mm_setzero_ps(), separationZ = _mm_setzero_ps();
+        __m128 alignmentX = _mm_setzero_ps(), alignmentY = _mm_setzero_ps(), alignmentZ = _mm_setzero_ps();
+        __m128i rangeCount = _mm_setzero_si128();
+
+        size_t i = 0;
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 qx = Load4(a.PositionX, candidates, i);
+            __m128 qy = Load4(a.PositionY, candidates, i);
+            __m128 qz = Load4(a.PositionZ, candidates, i);
+
+            __m128 dx = _mm_sub_ps(qx, px);
+            __m128 dy = _mm_sub_ps(qy, py);
+            __m128 dz = _mm_sub_ps(qz, pz);
+            __m128 distanceSq = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz));
+
+            __m128 isSeparated = _mm_cmplt_ps(distanceSq, separationDistanceSq);
+            separationX = _mm_sub_ps(separationX, _mm_and_ps(isSeparated, dx));
+            separationY = _mm_sub_ps(separationY, _mm_and_ps(isSeparated, dy));
+            separationZ = _mm_sub_ps(separationZ, _mm_and_ps(isSeparated, dz));
+
+            __m128 isInRange = _mm_cmplt_ps(distanceSq, rangeDistanceSq);
+            alignmentX = _mm_add_ps(alignmentX, _mm_and_ps(isInRange, Load4(a.VelocityX, candidates, i)));
+            alignmentY = _mm_add_ps(alignmentY, _mm_and_ps(isInRange, Load4(a.VelocityY, candidates, i)));
+            alignmentZ = _mm_add_ps(alignmentZ, _mm_and_ps(isInRange, Load4(a.VelocityZ, candidates, i)));
+
+            // A set mask lane is -1 as an integer.
+            rangeCount = _mm_sub_epi32(rangeCount, _mm_castps_si128(isInRange));
+        }
+
+        sums.Separation.x += HorizontalSum(separationX);
+        sums.Separation.y += HorizontalSum(separationY);
+        sums.Separation.z += HorizontalSum(separationZ);
+        sums.Alignment.x += HorizontalSum(alignmentX);
+        sums.Alignment.y += HorizontalSum(alignmentY);
+        sums.Alignment.z += HorizontalSum(alignmentZ);
+        sums.RangeCount += HorizontalSum(rangeCount);
+
+        AccumulateScalar(a, q, candidates, i, count, sums);
+    }
+
+    BOID_KERNEL_AVX2 inline __m256 Load8(float const* data, uint32_t const* indices, size_t i)
+    {
+        __m256i index = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(indices + i));
+        return _mm256_i32gather_ps(data, index, sizeof(float));
+    }
+
+    BOID_KERNEL_AVX2 inline float HorizontalSum(__m256 v)
+    {
+        return HorizontalSum(_mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1)));
+    }
+
+    BOID_KERNEL_AVX2 inline uint32_t HorizontalSum(__m256i v)
+    {
+        return HorizontalSum(_mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1)));
+    }
+
+    BOID_KERNEL_AVX2 void AccumulateAVX2(BoidArrays const& a, NeighborQuery const& q, uint32_t const* candidates, size_t count, NeighborSums& sums)
+    {
+        __m256 px = _mm256_set1_ps(q.Position.x);
+        __m256 py = _mm256_set1_ps(q.Position.y);
+        __m256 pz = _mm256_set1_ps(q.Position.z);
+        __m256 separationDistanceSq = _mm256_set1_ps(q.SeparationDistanceSq);
+        __m256 rangeDistanceSq = _mm256_set1_ps(q.RangeDistanceSq);
+
+        __m256 separationX = _mm256_setzero_ps(), separationY = _mm256_setzero_ps(), separationZ = _mm256_setzero_ps();
+        __m256 alignmentX = _mm256_setzero_ps(), alignmentY = _mm256_setzero_ps(), alignmentZ = _mm256_setzero_ps();
+        __m256i rangeCount = _mm256_setzero_si256();
+
+        size_t i = 0;
+        for (; i + 8 <= count; i += 8)
+        {
+            __m256 qx = Load8(a.PositionX, candidates, i);
+            __m256 qy = Load8(a.PositionY, candidates, i);
+            __m256 qz = Load8(a.PositionZ, candidates, i);
+
+            __m256 dx = _mm256_sub_ps(qx, px);
+            __m256 dy = _mm256_sub_ps(qy, py);
+            __m256 dz = _mm256_sub_ps(qz, pz);
+            __m256 distanceSq = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy)), _mm256_mul_ps(dz, dz));
+
+            __m256 isSeparated = _mm256_cmp_ps(distanceSq, separationDistanceSq, _CMP_LT_OQ);
+            separationX = _mm256_sub_ps(separationX, _mm256_and_ps(isSeparated, dx));
+            separationY = _mm256_sub_ps(separationY, _mm256_and_ps(isSeparated, dy));
+            separationZ = _mm256_sub_ps(separationZ, _mm256_and_ps(isSeparated, dz));
+
+            __m256 isInRange = _mm256_cmp_ps(distanceSq, rangeDistanceSq, _CMP_LT_OQ);
+            alignmentX = _mm256_add_ps(alignmentX, _mm256_and_ps(isInRange, Load8(a.VelocityX, candidates, i)));
+            alignmentY = _mm256_add_ps(alignmentY, _mm256_and_ps(isInRange, Load8(a.VelocityY, candidates, i)));
+            alignmentZ = _mm256_add_ps(alignmentZ, _mm256_and_ps(isInRange, Load8(a.VelocityZ, candidates, i)));
+
+            rangeCount = _mm256_sub_epi32(rangeCount, _mm256_castps_si256(isInRange));
+        }
+
+        sums.Separation.x += HorizontalSum(separationX);
+        sums.Separation.y += HorizontalSum(separationY);
+        sums.Separation.z += HorizontalSum(separationZ);
+        sums.Alignment.x += HorizontalSum(alignmentX);
+        sums.Alignment.y += HorizontalSum(alignmentY);
+        sums.Alignment.z += HorizontalSum(alignmentZ);
+        sums.RangeCount += HorizontalSum(rangeCount);
+
+        AccumulateScalar(a, q, candidates, i, count, sums);
+    }
+#endif
+
+    void Accumulate(KernelWidth width, BoidStore const& boids, NeighborQuery const& query, uint32_t const* candidates, size_t count, NeighborSums& sums)
+    {
+        BoidArrays arrays(boids);
+
+        switch (width)
+        {
+#if defined(BOID_KERNEL_X86)
+        case KernelWidth::AVX2:
+            AccumulateAVX2(arrays, query, candidates, count, sums);
+            break;
+        case KernelWidth::SSE:
+            AccumulateSSE(arrays, query, candidates, count, sums);
+            break;
+#endif
+        default:
+            AccumulateScalar(arrays, query, candidates, 0, count, sums);
+            break;
+        }
+    }
+}
+
+KernelWidth GetSupportedKernelWidth()
+{
+#if defined(BOID_KERNEL_X86) && defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    int maxFunction = info[0];
+
+    // AVX2 needs the CPU flag and the OS saving the YMM registers (OSXSAVE and XCR0 bits 1 and 2).
+    __cpuid(info, 1);
+    bool hasOsAvx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && ((_xgetbv(0) & 0x6) == 0x6);
+
+    if (hasOsAvx && maxFunction >= 7)
+    {
+        __cpuidex(info, 7, 0);
+        if (info[1] & (1 << 5))
+            return KernelWidth::AVX2;
+    }
+
+    // SSE2 is part of every x64 CPU and is required by DirectXMath on x86.
+    return KernelWidth::SSE;
+#elif defined(BOID_KERNEL_X86)
+    // __builtin_cpu_supports checks the OS support for the YMM registers too.
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return KernelWidth::AVX2;
+
+    return KernelWidth::SSE;
+#else
+    return KernelWidth::Scalar;
+#endif
+}
+
+void AccumulateNeighbors(
+    KernelWidth width,
+    BoidStore const& boids,
+    NeighborQuery const& query,
+    std::span<uint32_t const> candidates,
+    NeighborSums& sums)
+{
+    Accumulate(width, boids, query, candidates.data(), candidates.size(), sums);
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <span>
+
+#include "BoidStore.h"
+
+// The number of neighbours the kernel processes per instruction.
+enum class KernelWidth
+{
+    Scalar = 1,
+    SSE = 4,    // SSE2
+    AVX2 = 8,   // AVX2
+};
+
+// Describes the boid whose neighbours are being accumulated.
+struct NeighborQuery
+{
+    DirectX::XMFLOAT3 Position;
+    float SeparationDistanceSq;     // neighbours closer than this push the boid away
+    float RangeDistanceSq;          // neighbours closer than this count towards alignment
+};
+
+// Sums accumulated over the neighbours of a boid in a single pass.
+struct NeighborSums
+{
+    DirectX::XMFLOAT3 Separation;   // sum of (boid - neighbour) over the neighbours within the separation distance
+    DirectX::XMFLOAT3 Alignment;    // sum of neighbour velocities within the range
+    uint32_t RangeCount;            // the number of neighbours within the range
+};
+
+// Returns the widest kernel the CPU supports. Non-x86 builds always use the scalar kernel.
+KernelWidth GetSupportedKernelWidth();
+
+// Adds the contributions of the given neighbours to the sums. The candidates must not contain the queried boid.
+//
+// Tolerance: all widths compare squared distances instead of distances, and the SSE and AVX2 kernels add
+// the neighbours in per-lane partial sums. The scalar kernel adds in candidate order and reproduces the
+// original per-rule loops except for neighbours whose distance is within an ulp of a threshold. The SIMD
+// kernels differ from the scalar kernel by reordered float summation only: each component of a sum agrees
+// within n * 2^-24 of the sum of the absolute contributions, where n is the number of neighbours.
+void AccumulateNeighbors(
+    KernelWidth width,
+    BoidStore const& boids,
+    NeighborQuery const& query,
+    std::span<uint32_t const> candidates,
+    NeighborSums& sums);
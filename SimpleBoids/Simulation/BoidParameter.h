@@ -9,4 +9,9 @@ enum class BoidParameter
     TurnFactor,         // encourages boids to fly in a particular direction
     VisualRange,        // used in calculating boid's velocity while taking into account only boids in a certain range
     MatchingFactor,     // adjustment of average velocity as % (boid matching factor)
+    ObstacleDistance,   // the distance at which boids start to steer away from obstacles
+    ObstacleFactor,     // scales the vectors that push boids away from obstacles
+    PredatorDistance,   // the distance at which boids start to flee from a predator
+    PredatorFactor,     // scales the vectors that make boids flee from predators
+    Count,              // the number of parameters
 };
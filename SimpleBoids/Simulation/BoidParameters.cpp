@@ -0,0 +1,74 @@
+#include "pch.h"
+#include "BoidParameters.h"
+
+#include <thread>
+
+BoidParameters::BoidParameters() :
+    m_sequence(0)
+{
+    for (auto& value : m_values)
+        value.store(0.f, std::memory_order_relaxed);
+}
+
+BoidParameterValues BoidParameters::Read() const
+{
+    BoidParameterValues values;
+
+    for (;;)
+    {
+        uint32_t sequence = m_sequence.load(std::memory_order_acquire);
+
+        if ((sequence & 1) == 0)
+        {
+            for (size_t i = 0; i < m_values.size(); ++i)
+                values[static_cast<BoidParameter>(i)] = m_values[i].load(std::memory_order_relaxed);
+
+            // Order the loads of the values before the second load of the sequence.
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if (m_sequence.load(std::memory_order_relaxed) == sequence)
+                return values;
+        }
+
+        std::this_thread::yield();
+    }
+}
+
+float BoidParameters::Get(BoidParameter parameter) const
+{
+    return m_values[static_cast<size_t>(parameter)].load(std::memory_order_relaxed);
+}
+
+// Runs the function, which stores the new values, inside the sequence lock.
+template<typename TFunction>
+void BoidParameters::Write(TFunction const& function)
+{
+    std::lock_guard<std::mutex> lock(m_writeMutex);
+
+    uint32_t sequence = m_sequence.load(std::memory_order_relaxed);
+    m_sequence.store(sequence + 1, std::memory_order_relaxed);
+
+    // Order the odd sequence before the stores of the values.
+    std::atomic_thread_fence(std::memory_order_release);
+
+    function();
+
+    m_sequence.store(sequence + 2, std::memory_order_release);
+}
+
+void BoidParameters::Set(BoidParameter parameter, float value)
+{
+    Write([this, parameter, value]()
+        {
+            m_values[static_cast<size_t>(parameter)].store(value, std::memory_order_relaxed);
+        });
+}
+
+void BoidParameters::Set(BoidParameterValues const& values)
+{
+    Write([this, &values]()
+        {
+            for (size_t i = 0; i < m_values.size(); ++i)
+                m_values[i].store(values[static_cast<BoidParameter>(i)], std::memory_order_relaxed);
+        });
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <mutex>
+
+#include "BoidParameter.h"
+
+// The values of all boid parameters, indexed by BoidParameter.
+class BoidParameterValues
+{
+public:
+    float operator[](BoidParameter parameter) const { return m_values[static_cast<size_t>(parameter)]; }
+    float& operator[](BoidParameter parameter) { return m_values[static_cast<size_t>(parameter)]; }
+
+private:
+    std::array<float, static_cast<size_t>(BoidParameter::Count)> m_values{};
+};
+
+// Holds the boid parameters shared by the UI thread, which changes them while the simulation runs, and the
+// simulation, which reads them once per step. Updates are published with a sequence lock: Read copies all
+// values without locking and retries if a Set happened in the meantime, so a step never sees a torn update.
+class alignas(64) BoidParameters
+{
+public:
+    BoidParameters();
+
+    // Returns a consistent copy of all values.
+    BoidParameterValues Read() const;
+
+    // Returns the current value of a single parameter.
+    float Get(BoidParameter parameter) const;
+
+    // Changes one parameter or all of them at once.
+    void Set(BoidParameter parameter, float value);
+    void Set(BoidParameterValues const& values);
+
+private:
+    using Values = std::array<std::atomic<float>, static_cast<size_t>(BoidParameter::Count)>;
+
+    std::atomic<uint32_t>   m_sequence;     // odd while a Set is in progress
+    Values                  m_values;
+    std::mutex              m_writeMutex;   // serializes writers; readers never take it
+
+    template<typename TFunction>
+    void Write(TFunction const& function);
+};
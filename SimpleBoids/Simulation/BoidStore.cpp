@@ -0,0 +1,154 @@
+#include "pch.h"
+#include "BoidStore.h"
+
+#include <cstring>
+
+using namespace DirectX;
+
+namespace
+{
+    const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ull;
+    const uint64_t FNV_PRIME = 1099511628211ull;
+
+    uint64_t HashFloats(uint64_t hash, std::vector<float> const& values)
+    {
+        for (float value : values)
+        {
+            uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+
+            for (int i = 0; i < 4; ++i)
+            {
+                hash ^= (bits >> (8 * i)) & 0xff;
+                hash *= FNV_PRIME;
+            }
+        }
+
+        return hash;
+    }
+
+    size_t RoundUpToChunk(size_t count)
+    {
+        return (count + BoidStore::BOIDS_PER_CHUNK - 1) / BoidStore::BOIDS_PER_CHUNK * BoidStore::BOIDS_PER_CHUNK;
+    }
+
+    // Moves the values to an allocation of exactly the given capacity.
+    void Reallocate(std::vector<float>& values, size_t capacity)
+    {
+        std::vector<float> reallocated;
+        reallocated.reserve(capacity);
+        reallocated.assign(values.begin(), values.end());
+        values.swap(reallocated);
+    }
+}
+
+BoidStore::BoidStore(float maxSpeed) :
+    m_maxSpeed(maxSpeed)
+{
+}
+
+void BoidStore::Add(DirectX::FXMVECTOR position, DirectX::FXMVECTOR velocity)
+{
+    XMFLOAT3 p, v;
+    XMStoreFloat3(&p, position);
+    XMStoreFloat3(&v, velocity);
+
+    if (Size() == GetCapacity())
+        Reserve(Size() + Size() / 8 + 1);
+
+    m_positionX.push_back(p.x);
+    m_positionY.push_back(p.y);
+    m_positionZ.push_back(p.z);
+    m_velocityX.push_back(v.x);
+    m_velocityY.push_back(v.y);
+    m_velocityZ.push_back(v.z);
+}
+
+void BoidStore::Copy(size_t targetIndex, BoidStore const& source, size_t sourceIndex, size_t count)
+{
+    auto copy = [=](std::vector<float> const& from, std::vector<float>& to)
+        {
+            std::copy_n(from.begin() + sourceIndex, count, to.begin() + targetIndex);
+        };
+
+    copy(source.m_positionX, m_positionX);
+    copy(source.m_positionY, m_positionY);
+    copy(source.m_positionZ, m_positionZ);
+    copy(source.m_velocityX, m_velocityX);
+    copy(source.m_velocityY, m_velocityY);
+    copy(source.m_velocityZ, m_velocityZ);
+}
+
+void BoidStore::Resize(size_t count)
+{
+    Reserve(count);
+
+    m_positionX.resize(count);
+    m_positionY.resize(count);
+    m_positionZ.resize(count);
+    m_velocityX.resize(count);
+    m_velocityY.resize(count);
+    m_velocityZ.resize(count);
+
+    // Give the memory back after a large removal.
+    if (GetCapacity() > 2 * RoundUpToChunk(count))
+        SetCapacity(RoundUpToChunk(count));
+}
+
+void BoidStore::Reserve(size_t count)
+{
+    if (count > GetCapacity())
+        SetCapacity(RoundUpToChunk(count));
+}
+
+void BoidStore::SetCapacity(size_t capacity)
+{
+    Reallocate(m_positionX, capacity);
+    Reallocate(m_positionY, capacity);
+    Reallocate(m_positionZ, capacity);
+    Reallocate(m_velocityX, capacity);
+    Reallocate(m_velocityY, capacity);
+    Reallocate(m_velocityZ, capacity);
+}
+
+DirectX::XMVECTOR BoidStore::GetPosition(size_t index) const
+{
+    return XMVectorSet(m_positionX[index], m_positionY[index], m_positionZ[index], 0.f);
+}
+
+DirectX::XMVECTOR BoidStore::GetVelocity(size_t index) const
+{
+    return XMVectorSet(m_velocityX[index], m_velocityY[index], m_velocityZ[index], 0.f);
+}
+
+void BoidStore::SetPosition(size_t index, DirectX::FXMVECTOR position)
+{
+    XMFLOAT3 p;
+    XMStoreFloat3(&p, position);
+
+    m_positionX[index] = p.x;
+    m_positionY[index] = p.y;
+    m_positionZ[index] = p.z;
+}
+
+void BoidStore::SetVelocity(size_t index, DirectX::FXMVECTOR velocity)
+{
+    XMFLOAT3 v;
+    XMStoreFloat3(&v, velocity);
+
+    m_velocityX[index] = v.x;
+    m_velocityY[index] = v.y;
+    m_velocityZ[index] = v.z;
+}
+
+uint64_t BoidStore::ComputeChecksum() const
+{
+    uint64_t hash = FNV_OFFSET_BASIS;
+    hash = HashFloats(hash, m_positionX);
+    hash = HashFloats(hash, m_positionY);
+    hash = HashFloats(hash, m_positionZ);
+    hash = HashFloats(hash, m_velocityX);
+    hash = HashFloats(hash, m_velocityY);
+    hash = HashFloats(hash, m_velocityZ);
+    return hash;
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <span>
+#include <vector>
+
+// Stores the state of all boids in a swarm as a structure of arrays. Each component of the
+// position and the velocity lives in its own contiguous array, so loops over the boids walk
+// memory linearly. All boids in a store share the same max speed.
+//
+// Memory is allocated in whole chunks of boids rather than doubled, so a large swarm does not
+// carry up to twice the memory it needs. Shrinking the store to less than half its capacity gives
+// the memory back.
+class BoidStore
+{
+public:
+    // The number of boids memory is allocated for at a time.
+    static const size_t BOIDS_PER_CHUNK = 4096;
+
+    BoidStore(float maxSpeed);
+
+    // Appends a boid to the end of the store. When the store is full, it grows by an eighth.
+    void Add(DirectX::FXMVECTOR position, DirectX::FXMVECTOR velocity);
+
+    // Copies count boids of another store, starting at the source index, over the boids starting at the target index.
+    void Copy(size_t targetIndex, BoidStore const& source, size_t sourceIndex, size_t count);
+
+    // Shrinks or grows the store. New boids are placed at the origin and do not move.
+    void Resize(size_t count);
+    void Clear() { Resize(0); }
+
+    // Makes room for the given number of boids, rounded up to whole chunks.
+    void Reserve(size_t count);
+
+    // Accessors
+    size_t Size() const { return m_positionX.size(); }
+    size_t GetCapacity() const { return m_positionX.capacity(); }
+    size_t GetMemoryUsage() const { return 6 * GetCapacity() * sizeof(float); } // in bytes
+    DirectX::XMVECTOR GetPosition(size_t index) const;
+    DirectX::XMVECTOR GetVelocity(size_t index) const;
+    void SetPosition(size_t index, DirectX::FXMVECTOR position);
+    void SetVelocity(size_t index, DirectX::FXMVECTOR velocity);
+    float GetMaxSpeed() const { return m_maxSpeed; }
+    void SetMaxSpeed(float maxSpeed) { m_maxSpeed = maxSpeed; }
+
+    // Returns a 64-bit FNV-1a hash of the bit patterns of all positions and velocities. Stores with
+    // bit-for-bit identical states have the same checksum; any difference almost surely changes it.
+    uint64_t ComputeChecksum() const;
+
+    // Component arrays
+    std::span<float> GetPositionsX() { return m_positionX; }
+    std::span<float> GetPositionsY() { return m_positionY; }
+    std::span<float> GetPositionsZ() { return m_positionZ; }
+    std::span<float> GetVelocitiesX() { return m_velocityX; }
+    std::span<float> GetVelocitiesY() { return m_velocityY; }
+    std::span<float> GetVelocitiesZ() { return m_velocityZ; }
+    std::span<float const> GetPositionsX() const { return m_positionX; }
+    std::span<float const> GetPositionsY() const { return m_positionY; }
+    std::span<float const> GetPositionsZ() const { return m_positionZ; }
+    std::span<float const> GetVelocitiesX() const { return m_velocityX; }
+    std::span<float const> GetVelocitiesY() const { return m_velocityY; }
+    std::span<float const> GetVelocitiesZ() const { return m_velocityZ; }
+
+private:
+    std::vector<float>  m_positionX;
+    std::vector<float>  m_positionY;
+    std::vector<float>  m_positionZ;
+    std::vector<float>  m_velocityX;
+    std::vector<float>  m_velocityY;
+    std::vector<float>  m_velocityZ;
+    float               m_maxSpeed;
+
+    void SetCapacity(size_t capacity);
+};
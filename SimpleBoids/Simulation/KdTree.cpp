@@ -0,0 +1,121 @@
+#include "pch.h"
+#include "KdTree.h"
+
+void KdTree::Build(std::span<float const> x, std::span<float const> y, std::span<float const> z)
+{
+    ASSERT(x.size() <= INDEX_MASK);
+
+    m_positions[0] = x;
+    m_positions[1] = y;
+    m_positions[2] = z;
+
+    m_entries.resize(x.size());
+    for (size_t i = 0; i < x.size(); ++i)
+        m_entries[i] = static_cast<uint32_t>(i);
+
+    BuildRange(0, m_entries.size());
+}
+
+// Splits the range at its median along the axis of its largest extent, then builds both halves.
+void KdTree::BuildRange(size_t begin, size_t end)
+{
+    if (end - begin <= BOIDS_PER_LEAF)
+        return;
+
+    uint32_t axis = 0;
+    float largestExtent = -1.f;
+
+    for (uint32_t c = 0; c < 3; ++c)
+    {
+        float lo = GetCoordinate(m_entries[begin], c);
+        float hi = lo;
+
+        for (size_t i = begin + 1; i < end; ++i)
+        {
+            float value = GetCoordinate(m_entries[i], c);
+            lo = std::min(lo, value);
+            hi = std::max(hi, value);
+        }
+
+        if (hi - lo > largestExtent)
+        {
+            axis = c;
+            largestExtent = hi - lo;
+        }
+    }
+
+    size_t mid = begin + (end - begin) / 2;
+    std::nth_element(m_entries.begin() + begin, m_entries.begin() + mid, m_entries.begin() + end,
+        [this, axis](uint32_t a, uint32_t b) { return GetCoordinate(a, axis) < GetCoordinate(b, axis); });
+
+    m_entries[mid] |= axis << AXIS_SHIFT;
+
+    BuildRange(begin, mid);
+    BuildRange(mid + 1, end);
+}
+
+size_t KdTree::FindNearest(float x, float y, float z, uint32_t excluded, std::span<NearestNeighbor> nearest) const
+{
+    Query query{ { x, y, z }, excluded, nearest, 0 };
+
+    if (!nearest.empty())
+        SearchRange(0, m_entries.size(), query);
+
+    return query.Count;
+}
+
+void KdTree::SearchRange(size_t begin, size_t end, Query& query) const
+{
+    if (end - begin <= BOIDS_PER_LEAF)
+    {
+        for (size_t i = begin; i < end; ++i)
+            Consider(m_entries[i], query);
+
+        return;
+    }
+
+    size_t mid = begin + (end - begin) / 2;
+    uint32_t median = m_entries[mid];
+    uint32_t axis = median >> AXIS_SHIFT;
+    float offset = query.Position[axis] - GetCoordinate(median, axis);
+
+    Consider(median, query);
+
+    // Search the half that holds the position first; the other half only if it may hold a nearer boid.
+    if (offset < 0.f)
+        SearchRange(begin, mid, query);
+    else
+        SearchRange(mid + 1, end, query);
+
+    if (query.Count < query.Nearest.size() || offset * offset < query.Nearest[query.Count - 1].DistanceSq)
+    {
+        if (offset < 0.f)
+            SearchRange(mid + 1, end, query);
+        else
+            SearchRange(begin, mid, query);
+    }
+}
+
+// Keeps the boid if it is one of the nearest found so far. The list stays sorted by distance.
+void KdTree::Consider(uint32_t entry, Query& query) const
+{
+    uint32_t index = entry & INDEX_MASK;
+    if (index == query.Excluded)
+        return;
+
+    float dx = m_positions[0][index] - query.Position[0];
+    float dy = m_positions[1][index] - query.Position[1];
+    float dz = m_positions[2][index] - query.Position[2];
+    float distanceSq = dx * dx + dy * dy + dz * dz;
+
+    auto& nearest = query.Nearest;
+    if (query.Count == nearest.size() && distanceSq >= nearest[query.Count - 1].DistanceSq)
+        return;
+
+    // Insertion sort; the list is short.
+    size_t slot = (query.Count < nearest.size()) ? query.Count++ : query.Count - 1;
+    for (; slot > 0 && nearest[slot - 1].DistanceSq > distanceSq; --slot)
+        nearest[slot] = nearest[slot - 1];
+
+    nearest[slot] = { distanceSq, index };
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <span>
+#include <vector>
+
+// A boid found by KdTree::FindNearest.
+struct NearestNeighbor
+{
+    float       DistanceSq;
+    uint32_t    Index;
+};
+
+// A k-d tree over boid positions that answers k-nearest-neighbour queries. Unlike a query on a uniform
+// grid, the cost of a query does not depend on how densely or sparsely the boids crowd together. The tree
+// is implicit: the boid indices are reordered so that the median of each range splits it, which costs
+// four bytes per boid. It is rebuilt from scratch every step.
+class KdTree
+{
+public:
+    // Builds the tree over the given positions. The positions must stay unchanged while the tree is queried.
+    void Build(std::span<float const> x, std::span<float const> y, std::span<float const> z);
+
+    // Finds the boids nearest to a position, except the excluded one. Fills the neighbours nearest first,
+    // up to the size of the span, and returns their number, which is smaller only if there are not enough
+    // other boids.
+    size_t FindNearest(float x, float y, float z, uint32_t excluded, std::span<NearestNeighbor> nearest) const;
+
+    // Returns the number of bytes allocated for the tree.
+    size_t GetMemoryUsage() const { return m_entries.capacity() * sizeof(uint32_t); }
+
+private:
+    // Ranges of this many boids or fewer are searched linearly.
+    static const size_t BOIDS_PER_LEAF = 8;
+
+    // Each entry holds a boid index in the low bits and, if the boid is the median of a range, the axis
+    // it splits the range along in the top bits.
+    static const int AXIS_SHIFT = 30;
+    static const uint32_t INDEX_MASK = (1u << AXIS_SHIFT) - 1;
+
+    struct Query
+    {
+        float                       Position[3];
+        uint32_t                    Excluded;
+        std::span<NearestNeighbor>  Nearest;
+        size_t                      Count;      // the number of neighbours found so far
+    };
+
+    std::span<float const>  m_positions[3];
+    std::vector<uint32_t>   m_entries;          // in tree order
+
+    float GetCoordinate(uint32_t entry, uint32_t axis) const { return m_positions[axis][entry & INDEX_MASK]; }
+
+    void BuildRange(size_t begin, size_t end);
+    void SearchRange(size_t begin, size_t end, Query& query) const;
+    void Consider(uint32_t entry, Query& query) const;
+};
@@ -0,0 +1,53 @@
+#include "pch.h"
+#include "SpatialGrid.h"
+
+SpatialGrid::SpatialGrid() :
+    m_cellSize(1.f),
+    m_inverseCellSize(1.f),
+    m_tableMask(0)
+{
+}
+
+void SpatialGrid::Build(std::span<float const> x, std::span<float const> y, std::span<float const> z, float cellSize)
+{
+    m_cellSize = (cellSize > 0.f ? cellSize : 1.f);
+    m_inverseCellSize = 1.f / m_cellSize;
+
+    // Keep the table at least as large as the number of boids. Boids crowd into far fewer cells than
+    // there are boids, so collisions stay rare while the table costs at most eight bytes per boid.
+    uint32_t tableSize = 64;
+    while (tableSize < x.size())
+        tableSize <<= 1;
+    m_tableMask = tableSize - 1;
+
+    // Count the boids in each bucket.
+    m_bucketStart.assign(tableSize + 1, 0);
+
+    for (size_t i = 0; i < x.size(); ++i)
+        ++m_bucketStart[GetBucket(x[i], y[i], z[i])];
+
+    // Turn the counts into the end offset of each bucket.
+    for (uint32_t i = 1; i < tableSize; ++i)
+        m_bucketStart[i] += m_bucketStart[i - 1];
+
+    // Scatter the boid indices back to front, which moves the offset of each bucket from its end to its
+    // start. Each bucket is filled in ascending index order. Hashing the positions again is cheaper than
+    // keeping the bucket of every boid in memory.
+    m_bucketEntries.resize(x.size());
+
+    for (size_t i = x.size(); i-- > 0;)
+        m_bucketEntries[--m_bucketStart[GetBucket(x[i], y[i], z[i])]] = static_cast<uint32_t>(i);
+
+    m_bucketStart[tableSize] = static_cast<uint32_t>(x.size());
+}
+
+uint32_t SpatialGrid::GetBucket(int x, int y, int z) const
+{
+    // Spatial hash from Teschner et al. (2003) "Optimized Spatial Hashing for Collision Detection of Deformable Objects".
+    uint32_t hash =
+        (static_cast<uint32_t>(x) * 73856093u) ^
+        (static_cast<uint32_t>(y) * 19349663u) ^
+        (static_cast<uint32_t>(z) * 83492791u);
+
+    return hash & m_tableMask;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <cmath>
+#include <span>
+#include <vector>
+
+// A uniform grid that buckets boids by position. Cells are hashed into a table sized from the
+// number of boids, so the grid does not need to know the bounds of the swarm. The grid is
+// rebuilt from scratch every step with a counting sort.
+class SpatialGrid
+{
+public:
+    SpatialGrid();
+
+    // Sorts the given positions into cubic cells with the given edge length.
+    void Build(std::span<float const> x, std::span<float const> y, std::span<float const> z, float cellSize);
+
+    // Calls a function for the index of every boid in the 3x3x3 block of cells around a given position.
+    // The function receives candidates only; it has to check the actual distance itself.
+    template<typename TFunction>
+    void ForEachNeighbor(float x, float y, float z, TFunction const& function) const;
+
+    float GetCellSize() const { return m_cellSize; }
+
+    // Returns the number of bytes allocated for the grid.
+    size_t GetMemoryUsage() const { return (m_bucketStart.capacity() + m_bucketEntries.capacity()) * sizeof(uint32_t); }
+
+private:
+    float                   m_cellSize;
+    float                   m_inverseCellSize;
+    uint32_t                m_tableMask;
+    std::vector<uint32_t>   m_bucketStart;      // the first entry of each bucket; one extra element marks the end
+    std::vector<uint32_t>   m_bucketEntries;    // boid indices sorted by bucket
+
+    int GetCellCoordinate(float value) const { return static_cast<int>(std::floor(value * m_inverseCellSize)); }
+    uint32_t GetBucket(int x, int y, int z) const;
+    uint32_t GetBucket(float x, float y, float z) const { return GetBucket(GetCellCoordinate(x), GetCellCoordinate(y), GetCellCoordinate(z)); }
+};
+
+template<typename TFunction>
+void SpatialGrid::ForEachNeighbor(float x, float y, float z, TFunction const& function) const
+{
+    if (m_bucketEntries.empty())
+        return;
+
+    int cellX = GetCellCoordinate(x);
+    int cellY = GetCellCoordinate(y);
+    int cellZ = GetCellCoordinate(z);
+
+    // Different cells may hash to the same bucket. Remember the visited buckets so that no boid is reported twice.
+    uint32_t visited[27];
+    int visitedCount = 0;
+
+    for (int dz = -1; dz <= 1; ++dz)
+    {
+        for (int dy = -1; dy <= 1; ++dy)
+        {
+            for (int dx = -1; dx <= 1; ++dx)
+            {
+                uint32_t bucket = GetBucket(cellX + dx, cellY + dy, cellZ + dz);
+
+                bool isVisited = false;
+                for (int i = 0; i < visitedCount && !isVisited; ++i)
+                    isVisited = (visited[i] == bucket);
+
+                if (isVisited)
+                    continue;
+
+                visited[visitedCount++] = bucket;
+
+                for (uint32_t i = m_bucketStart[bucket]; i < m_bucketStart[bucket + 1]; ++i)
+                    function(m_bucketEntries[i]);
+            }
+        }
+    }
+}
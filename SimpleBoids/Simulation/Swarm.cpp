@@ -0,0 +1,1121 @@
+#include "pch.h"
+#include "Swarm.h"
+
+#include <cmath>
+#include <cstring>
+
+using namespace DirectX;
+
+namespace
+{
+    // Spreads the low 10 bits of the value out to every third bit.
+    uint32_t SpreadBits(uint32_t value)
+    {
+        value &= 0x3ff;
+        value = (value | (value << 16)) & 0x030000ff;
+        value = (value | (value << 8)) & 0x0300f00f;
+        value = (value | (value << 4)) & 0x030c30c3;
+        value = (value | (value << 2)) & 0x09249249;
+        return value;
+    }
+
+    // Interleaves three 10-bit cell coordinates into a 30-bit Morton code. Sorting by the code lays out
+    // the cells along a Z-shaped curve that keeps cells near in space mostly near in order.
+    uint32_t GetMortonCode(uint32_t x, uint32_t y, uint32_t z)
+    {
+        return SpreadBits(x) | (SpreadBits(y) << 1) | (SpreadBits(z) << 2);
+    }
+}
+
+Swarm::Swarm(
+    float boidRadius, 
+    float boidMinDistance, 
+    float boidMatchingFactor, 
+    float maxBoidSpeed,
+    float boidAvoidFactor,
+    float boidTurnFactor,
+    float boidVisualRange,
+    float boidMoveToCenterFactor,
+    float boxEdgeLength) :
+    m_boids(maxBoidSpeed),
+    m_nextBoids(maxBoidSpeed),
+    m_speciesEnds(),
+    m_nextId(0),
+    m_size(0),
+    m_speciesSizes(),
+    m_speciesCount(1),
+    m_boidRadius(boidRadius),
+    m_isVisualRangeEnabled(false),
+    m_isTopologicalEnabled(false),
+    m_topologicalNeighborCount(DEFAULT_TOPOLOGICAL_NEIGHBOR_COUNT),
+    m_sortInterval(0),
+    m_stepsSinceSort(0),
+    m_integrator(Integrator::Legacy),
+    m_maxSubstepCount(1),
+    m_boxEdgeLength(boxEdgeLength),
+    m_kernelWidth(GetSupportedKernelWidth()),
+    m_step()
+{
+    BoidParameterValues parameters;
+    parameters[BoidParameter::MinDistance] = boidMinDistance;
+    parameters[BoidParameter::MatchingFactor] = boidMatchingFactor;
+    parameters[BoidParameter::MaxSpeed] = maxBoidSpeed;
+    parameters[BoidParameter::AvoidFactor] = boidAvoidFactor;
+    parameters[BoidParameter::TurnFactor] = boidTurnFactor;
+    parameters[BoidParameter::VisualRange] = boidVisualRange;
+    parameters[BoidParameter::MoveToCenterFactor] = boidMoveToCenterFactor;
+    parameters[BoidParameter::ObstacleDistance] = DEFAULT_OBSTACLE_DISTANCE;
+    parameters[BoidParameter::ObstacleFactor] = DEFAULT_OBSTACLE_FACTOR;
+    parameters[BoidParameter::PredatorDistance] = DEFAULT_PREDATOR_DISTANCE;
+    parameters[BoidParameter::PredatorFactor] = DEFAULT_PREDATOR_FACTOR;
+    m_boidParameters[0].Set(parameters);
+
+    m_rand = std::make_unique<RandomNumberHelper>();
+
+    m_threadPool = std::make_unique<ThreadPool>();
+    m_candidates.resize(m_threadPool->GetThreadCount());
+    m_avoidedCandidates.resize(m_threadPool->GetThreadCount());
+}
+
+void Swarm::AddBoids(int count, int species)
+{
+    if (count <= 0 || !IsValidSpecies(species))
+        return;
+
+    std::lock_guard<std::mutex> lock(m_pendingMutex);
+
+    auto& pending = m_pending[species];
+    pending.Boids.Reserve(pending.Boids.Size() + count);
+    pending.Ids.reserve(pending.Boids.GetCapacity());
+
+    for (auto i = 0; i < count; ++i)
+    {
+        auto [randomPosition, randomVelocity] = GetRandomPositionAndVelocity(species);
+        pending.Boids.Add(randomPosition, randomVelocity);
+        pending.Ids.push_back(m_nextId++);
+    }
+
+    m_speciesSizes[species] += count;
+    m_size += count;
+}
+
+void Swarm::RemoveBoids(int count, int species)
+{
+    if (count <= 0 || !IsValidSpecies(species))
+        return;
+
+    std::lock_guard<std::mutex> lock(m_pendingMutex);
+
+    // Take back boids that have not been added yet before removing existing ones.
+    auto& pending = m_pending[species];
+    size_t removeCount = std::min<size_t>(count, m_speciesSizes[species]);
+    size_t pendingCount = std::min(removeCount, pending.Boids.Size());
+
+    pending.Boids.Resize(pending.Boids.Size() - pendingCount);
+    pending.Ids.resize(pending.Boids.Size());
+    pending.RemoveCount += removeCount - pendingCount;
+    m_speciesSizes[species] -= removeCount;
+    m_size -= removeCount;
+}
+
+int Swarm::AddSpecies()
+{
+    std::lock_guard<std::mutex> lock(m_pendingMutex);
+
+    int species = m_speciesCount;
+    if (species == MAX_SPECIES_COUNT)
+        return -1;
+
+    m_boidParameters[species].Set(m_boidParameters[0].Read());
+
+    for (int other = 0; other <= species; ++other)
+    {
+        m_interactions[species * MAX_SPECIES_COUNT + other] = SpeciesInteraction::Attract;
+        m_interactions[other * MAX_SPECIES_COUNT + species] = SpeciesInteraction::Attract;
+    }
+
+    // Publish the species only once its parameters are set.
+    m_speciesCount = species + 1;
+    return species;
+}
+
+size_t Swarm::GetSpeciesSize(int species) const
+{
+    return IsValidSpecies(species) ? m_speciesSizes[species].load() : 0;
+}
+
+float Swarm::GetBoidParameter(int species, BoidParameter parameter) const
+{
+    return IsValidSpecies(species) ? m_boidParameters[species].Get(parameter) : 0.f;
+}
+
+void Swarm::SetBoidParameter(int species, BoidParameter parameter, float value)
+{
+    if (IsValidSpecies(species))
+        m_boidParameters[species].Set(parameter, value);
+}
+
+SpeciesInteraction Swarm::GetInteraction(int species, int other) const
+{
+    if (!IsValidSpecies(species) || !IsValidSpecies(other))
+        return SpeciesInteraction::Ignore;
+
+    return m_interactions[species * MAX_SPECIES_COUNT + other];
+}
+
+void Swarm::SetInteraction(int species, int other, SpeciesInteraction interaction)
+{
+    if (IsValidSpecies(species) && IsValidSpecies(other))
+        m_interactions[species * MAX_SPECIES_COUNT + other] = interaction;
+}
+
+void Swarm::SetObstacles(std::span<DirectX::XMFLOAT3 const> positions, std::span<uint32_t const> indices)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_obstacles.Build(positions.data(), positions.size(), indices.data(), indices.size());
+}
+
+void Swarm::SetPredators(std::span<DirectX::XMFLOAT3 const> positions)
+{
+    std::lock_guard<std::mutex> lock(m_predatorMutex);
+    m_pendingPredators.assign(positions.begin(), positions.end());
+}
+
+void Swarm::Update(float timeDelta)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    SWARM_PROFILE_BEGIN_STEP(m_profiler, m_threadPool->GetThreadCount());
+
+    ApplyPendingChanges();
+
+    {
+        std::lock_guard<std::mutex> predatorLock(m_predatorMutex);
+        m_predators.assign(m_pendingPredators.begin(), m_pendingPredators.end());
+    }
+
+    int sortInterval = m_sortInterval;
+    if (sortInterval > 0 && ++m_stepsSinceSort >= sortInterval)
+    {
+        SortBoids();
+        m_stepsSinceSort = 0;
+    }
+
+    ReadStepParameters();
+
+    // The store carries the max speed of species 0; UpdateBoids limits each boid to the max speed of its species.
+    m_boids.SetMaxSpeed(m_step.Species[0].MaxSpeed);
+
+    int substepCount = GetSubstepCount(timeDelta);
+    float substepDelta = timeDelta / substepCount;
+
+    for (int substep = 0; substep < substepCount; ++substep)
+    {
+        BuildGrid();
+        BuildTree();
+        ComputeTotals();
+        UpdateAllBoids(substepDelta);
+    }
+
+    // The per-boid sections run once per sub-step.
+    SWARM_PROFILE_END_STEP(m_profiler, m_boids.Size() * substepCount);
+}
+
+int Swarm::GetSubstepCount(float timeDelta) const
+{
+    // Legacy moves the boids by their velocity once per step, so splitting a step would only speed them up.
+    if (m_step.Integration == Integrator::Legacy || m_step.MaxSubstepCount <= 1)
+        return 1;
+
+    float substepCount = 1.f;
+    for (int s = 0; s < m_step.SpeciesCount; ++s)
+    {
+        SpeciesParameters const& species = m_step.Species[s];
+
+        float maxDisplacement = species.MaxSpeed * timeDelta / Boid::REFERENCE_TIME_STEP;
+        float maxSubstepDisplacement = SUBSTEP_SEPARATION_FRACTION * species.SeparationDistance;
+        if (maxSubstepDisplacement > 0.f)
+            substepCount = std::max(substepCount, std::ceil(maxDisplacement / maxSubstepDisplacement));
+    }
+
+    return static_cast<int>(std::min(substepCount, static_cast<float>(m_step.MaxSubstepCount)));
+}
+
+void Swarm::UpdateAllBoids(float timeDelta)
+{
+    SWARM_PROFILE_PHASE(m_profiler, SwarmPhase::UpdateBoids);
+
+    // Every boid reads the current state and writes its next state to the back buffer, so the result
+    // does not depend on the order in which the boids are processed.
+    m_nextBoids.Resize(m_boids.Size());
+    m_nextBoids.SetMaxSpeed(m_boids.GetMaxSpeed());
+
+    m_threadPool->ParallelFor(m_boids.Size(), BOIDS_PER_TASK, [this, timeDelta](size_t begin, size_t end, unsigned participant)
+        {
+            UpdateBoids(begin, end, participant, timeDelta);
+        });
+
+    std::swap(m_boids, m_nextBoids);
+}
+
+void Swarm::UpdateBoids(size_t begin, size_t end, unsigned participant, float timeDelta)
+{
+    SWARM_PROFILE_TASK(m_profiler, participant);
+
+    XMVECTOR v1, v2, v3, v4, v5, v6;
+
+    // A task may span the end of one species and the start of the next.
+    int speciesIndex = GetSpecies(begin);
+
+    for (int i = static_cast<int>(begin); i < static_cast<int>(end); ++i)
+    {
+        SWARM_PROFILE_BOID(m_profiler, participant, i);
+
+        while (static_cast<size_t>(i) >= m_speciesEnds[speciesIndex])
+            ++speciesIndex;
+
+        SpeciesParameters const& species = m_step.Species[speciesIndex];
+
+        // Accumulate the neighbour sums the rules need in a single fused pass over the nearby boids
+        // found in the grid. The rules over all other boids use the totals computed at the start of the step.
+        NeighborSums nearby = GetNearbySums(i, species, participant);
+        if (m_step.IsTopologicalEnabled)
+            SetNearestSums(i, species, nearby);
+
+        SWARM_PROFILE_NEIGHBORS(m_profiler, participant, m_candidates[participant].size() + m_avoidedCandidates[participant].size(), nearby.RangeCount);
+        SWARM_PROFILE_MARK(SwarmPhase::NeighborSearch);
+
+        // Perform vector operations on the positions of the boids. Operations are independent from each other.
+
+        // Rule 1: Make boids fly towards the centre of the mass of neighbouring boids.
+        v1 = ExecuteRule1(i, species);
+        SWARM_PROFILE_MARK(SwarmPhase::Cohesion);
+
+        // Rule 2: Move away from other boids that are too close to avoid colliding.
+        v2 = ExecuteRule2(nearby, species);
+        SWARM_PROFILE_MARK(SwarmPhase::Separation);
+
+        // Rule 3: Find the average velocity (speed and direction) of the other boids and adjust velocity to match.
+        v3 = ExecuteRule3(i, nearby, species);
+        SWARM_PROFILE_MARK(SwarmPhase::Alignment);
+
+        // Rule 4: Encourage boids to stay within rough boundaries.
+        v4 = ExecuteRule4(i, species);
+        SWARM_PROFILE_MARK(SwarmPhase::Bounds);
+
+        // Rule 5: Steer away from static obstacles.
+        v5 = ExecuteRule5(i, species);
+        SWARM_PROFILE_MARK(SwarmPhase::Obstacles);
+
+        // Rule 6: Flee from predators.
+        v6 = ExecuteRule6(i, species);
+        SWARM_PROFILE_MARK(SwarmPhase::Predators);
+
+        XMVECTOR velocityDelta = timeDelta * (v1 + v2 + v3 + v4 + v5 + v6);
+
+        Boid::Integrate(m_boids, m_nextBoids, i, velocityDelta, species.MaxSpeed, m_step.Integration, timeDelta);
+        SWARM_PROFILE_MARK(SwarmPhase::Integration);
+    }
+}
+
+void Swarm::ResetBoids()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::lock_guard<std::mutex> pendingLock(m_pendingMutex);
+
+    // The staged boids are placed at random positions anyway.
+    int species = 0;
+    for (size_t i = 0; i < m_boids.Size(); ++i)
+    {
+        while (i >= m_speciesEnds[species])
+            ++species;
+
+        auto [randomPosition, randomVelocity] = GetRandomPositionAndVelocity(species);
+        m_boids.SetPosition(i, randomPosition);
+        m_boids.SetVelocity(i, randomVelocity);
+    }
+}
+
+void Swarm::Seed(uint32_t seed)
+{
+    std::lock_guard<std::mutex> lock(m_pendingMutex);
+    m_rand->Seed(seed);
+}
+
+uint64_t Swarm::ComputeChecksum()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_boids.ComputeChecksum();
+}
+
+size_t Swarm::WriteInstanceTransforms(std::span<DirectX::XMFLOAT4X4> transforms)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    size_t count = std::min(m_boids.Size(), transforms.size());
+
+    m_threadPool->ParallelFor(count, TRANSFORMS_PER_TASK, [this, transforms](size_t begin, size_t end, unsigned)
+        {
+            for (size_t i = begin; i < end; ++i)
+                XMStoreFloat4x4(&transforms[i], Boid::ComputeWorldMatrix(m_boids.GetPosition(i), m_boids.GetVelocity(i)));
+        });
+
+    return count;
+}
+
+void Swarm::CopyState(BoidStore& target, std::vector<uint32_t>& ids)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Assignment reuses the target's memory once it has grown to the size of the swarm.
+    target = m_boids;
+    ids = m_ids;
+}
+
+void Swarm::SaveCheckpoint(std::vector<std::byte>& checkpoint, CheckpointPositionFormat format)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::lock_guard<std::mutex> pendingLock(m_pendingMutex);
+
+    std::string randomState = m_rand->SaveState();
+
+    std::vector<XMFLOAT3> predators;
+    {
+        std::lock_guard<std::mutex> predatorLock(m_predatorMutex);
+        predators = m_pendingPredators;
+    }
+
+    std::span<float const> positions[] = { m_boids.GetPositionsX(), m_boids.GetPositionsY(), m_boids.GetPositionsZ() };
+    std::span<float const> velocities[] = { m_boids.GetVelocitiesX(), m_boids.GetVelocitiesY(), m_boids.GetVelocitiesZ() };
+
+    SwarmCheckpointHeader header{};
+    header.Magic = SwarmCheckpoint::MAGIC;
+    header.Version = SwarmCheckpoint::VERSION;
+    header.BoidCount = m_boids.Size();
+    header.NextId = m_nextId;
+    header.PositionFormat = static_cast<uint32_t>(format);
+    header.SpeciesCount = static_cast<uint32_t>(m_speciesCount.load());
+    header.ParameterCount = static_cast<uint32_t>(BoidParameter::Count);
+    header.PredatorCount = static_cast<uint32_t>(predators.size());
+    header.RandomStateSize = static_cast<uint32_t>(randomState.size());
+    header.BoidRadius = m_boidRadius;
+    header.BoxEdgeLength = m_boxEdgeLength;
+    header.Flags = (m_isVisualRangeEnabled ? SwarmCheckpoint::VISUAL_RANGE_FLAG : 0) |
+        (m_isTopologicalEnabled ? SwarmCheckpoint::TOPOLOGICAL_FLAG : 0);
+    header.TopologicalNeighborCount = m_topologicalNeighborCount;
+    header.SortInterval = m_sortInterval;
+    header.StepsSinceSort = m_stepsSinceSort;
+    header.Integrator = static_cast<uint32_t>(m_integrator.load());
+    header.MaxSubstepCount = m_maxSubstepCount;
+
+    if (format == CheckpointPositionFormat::Quantized16)
+    {
+        for (int axis = 0; axis < 3; ++axis)
+            SwarmCheckpoint::GetQuantization(positions[axis], header.PositionMin[axis], header.PositionScale[axis]);
+    }
+
+    SwarmCheckpointLayout layout = SwarmCheckpoint::ComputeLayout(header);
+    checkpoint.assign(layout.Size, std::byte{ 0 });
+
+    auto write = [&checkpoint](size_t offset, void const* data, size_t size)
+        {
+            if (size > 0)
+                std::memcpy(checkpoint.data() + offset, data, size);
+        };
+
+    write(0, &header, sizeof(header));
+
+    for (int s = 0; s < m_speciesCount; ++s)
+    {
+        uint64_t end = m_speciesEnds[s];
+        write(layout.SpeciesEnds + s * sizeof(uint64_t), &end, sizeof(end));
+
+        BoidParameterValues values = m_boidParameters[s].Read();
+        for (uint32_t p = 0; p < header.ParameterCount; ++p)
+        {
+            float value = values[static_cast<BoidParameter>(p)];
+            write(layout.Parameters + (s * header.ParameterCount + p) * sizeof(float), &value, sizeof(value));
+        }
+
+        for (int t = 0; t < m_speciesCount; ++t)
+        {
+            auto interaction = static_cast<uint8_t>(m_interactions[s * MAX_SPECIES_COUNT + t].load());
+            write(layout.Interactions + s * header.SpeciesCount + t, &interaction, sizeof(interaction));
+        }
+    }
+
+    write(layout.Predators, predators.data(), predators.size() * sizeof(XMFLOAT3));
+    write(layout.RandomState, randomState.data(), randomState.size());
+    write(layout.Ids, m_ids.data(), m_ids.size() * sizeof(uint32_t));
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        if (format == CheckpointPositionFormat::Quantized16)
+        {
+            auto steps = reinterpret_cast<uint16_t*>(checkpoint.data() + layout.Positions[axis]);
+            for (size_t i = 0; i < positions[axis].size(); ++i)
+                steps[i] = SwarmCheckpoint::Quantize(positions[axis][i], header.PositionMin[axis], header.PositionScale[axis]);
+        }
+        else
+            write(layout.Positions[axis], positions[axis].data(), positions[axis].size_bytes());
+
+        write(layout.Velocities[axis], velocities[axis].data(), velocities[axis].size_bytes());
+    }
+}
+
+bool Swarm::LoadCheckpoint(SwarmCheckpoint const& checkpoint)
+{
+    SwarmCheckpointHeader const& header = checkpoint.GetHeader();
+    size_t count = checkpoint.GetBoidCount();
+    int speciesCount = static_cast<int>(header.SpeciesCount);
+
+    // Check everything before changing anything.
+    if (speciesCount > MAX_SPECIES_COUNT || header.Integrator > static_cast<uint32_t>(Integrator::Verlet))
+        return false;
+
+    auto speciesEnds = checkpoint.GetSpeciesEnds();
+    if (!std::is_sorted(speciesEnds.begin(), speciesEnds.end()) || speciesEnds.back() != count)
+        return false;
+
+    auto interactions = checkpoint.GetInteractions();
+    if (std::any_of(interactions.begin(), interactions.end(), [](uint8_t i) { return i > static_cast<uint8_t>(SpeciesInteraction::Avoid); }))
+        return false;
+
+    auto ids = checkpoint.GetIds();
+    if (std::any_of(ids.begin(), ids.end(), [&header](uint32_t id) { return id >= header.NextId; }))
+        return false;
+
+    RandomNumberHelper random(0);
+    if (!random.LoadState(checkpoint.GetRandomState()))
+        return false;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::lock_guard<std::mutex> pendingLock(m_pendingMutex);
+
+    // Read the arrays straight from the checkpoint into the store.
+    m_boids.Resize(count);
+
+    std::span<float> positions[] = { m_boids.GetPositionsX(), m_boids.GetPositionsY(), m_boids.GetPositionsZ() };
+    std::span<float> velocities[] = { m_boids.GetVelocitiesX(), m_boids.GetVelocitiesY(), m_boids.GetVelocitiesZ() };
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        checkpoint.ReadPositions(axis, positions[axis]);
+
+        auto saved = checkpoint.GetVelocities(axis);
+        std::copy(saved.begin(), saved.end(), velocities[axis].begin());
+    }
+
+    m_ids.reserve(m_boids.GetCapacity());
+    m_ids.assign(ids.begin(), ids.end());
+    m_nextId = header.NextId;
+    m_size = count;
+
+    size_t begin = 0;
+    for (int s = 0; s < MAX_SPECIES_COUNT; ++s)
+    {
+        m_speciesEnds[s] = s < speciesCount ? static_cast<size_t>(speciesEnds[s]) : count;
+        m_speciesSizes[s] = m_speciesEnds[s] - begin;
+        begin = m_speciesEnds[s];
+
+        m_pending[s].Boids.Clear();
+        m_pending[s].Ids.clear();
+        m_pending[s].RemoveCount = 0;
+    }
+
+    // Parameters added to BoidParameter after the checkpoint was saved keep their current values.
+    uint32_t parameterCount = std::min(header.ParameterCount, static_cast<uint32_t>(BoidParameter::Count));
+    for (int s = 0; s < speciesCount; ++s)
+    {
+        BoidParameterValues values = m_boidParameters[s].Read();
+        auto saved = checkpoint.GetParameters(s);
+        for (uint32_t p = 0; p < parameterCount; ++p)
+            values[static_cast<BoidParameter>(p)] = saved[p];
+        m_boidParameters[s].Set(values);
+
+        for (int t = 0; t < speciesCount; ++t)
+            m_interactions[s * MAX_SPECIES_COUNT + t] = static_cast<SpeciesInteraction>(interactions[s * speciesCount + t]);
+    }
+
+    m_speciesCount = speciesCount;
+    m_boids.SetMaxSpeed(m_boidParameters[0].Get(BoidParameter::MaxSpeed));
+
+    m_boidRadius = header.BoidRadius;
+    m_boxEdgeLength = header.BoxEdgeLength;
+    m_isVisualRangeEnabled = (header.Flags & SwarmCheckpoint::VISUAL_RANGE_FLAG) != 0;
+    m_isTopologicalEnabled = (header.Flags & SwarmCheckpoint::TOPOLOGICAL_FLAG) != 0;
+    SetTopologicalNeighborCount(header.TopologicalNeighborCount);
+    SetSortInterval(header.SortInterval);
+    m_stepsSinceSort = header.StepsSinceSort;
+    m_integrator = static_cast<Integrator>(header.Integrator);
+    SetMaxSubstepCount(header.MaxSubstepCount);
+
+    {
+        std::lock_guard<std::mutex> predatorLock(m_predatorMutex);
+        auto predators = checkpoint.GetPredators();
+        m_pendingPredators.assign(predators.begin(), predators.end());
+    }
+
+    *m_rand = std::move(random);
+    return true;
+}
+
+size_t Swarm::GetMemoryUsage()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    std::lock_guard<std::mutex> pendingLock(m_pendingMutex);
+
+    size_t usage = m_boids.GetMemoryUsage() + m_nextBoids.GetMemoryUsage() + m_ids.capacity() * sizeof(uint32_t) +
+        m_grid.GetMemoryUsage() + m_tree.GetMemoryUsage();
+    for (auto const& pending : m_pending)
+        usage += pending.Boids.GetMemoryUsage() + pending.Ids.capacity() * sizeof(uint32_t);
+    for (auto const& candidates : m_candidates)
+        usage += candidates.capacity() * sizeof(uint32_t);
+    for (auto const& candidates : m_avoidedCandidates)
+        usage += candidates.capacity() * sizeof(uint32_t);
+
+    return usage;
+}
+
+void Swarm::SetKernelWidth(KernelWidth width)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // Never select a kernel the CPU cannot run.
+    m_kernelWidth = std::min(width, GetSupportedKernelWidth());
+}
+
+void Swarm::SetTopologicalNeighborCount(int count)
+{
+    m_topologicalNeighborCount = std::clamp(count, 1, MAX_TOPOLOGICAL_NEIGHBOR_COUNT);
+}
+
+void Swarm::SetMaxSubstepCount(int count)
+{
+    m_maxSubstepCount = std::clamp(count, 1, MAX_SUBSTEP_COUNT);
+}
+
+void Swarm::SetThreadCount(unsigned threadCount)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_threadPool = std::make_unique<ThreadPool>(threadCount);
+    m_candidates.resize(m_threadPool->GetThreadCount());
+    m_avoidedCandidates.resize(m_threadPool->GetThreadCount());
+}
+
+// Move the boid toward its 'perceived centre', which is the centre of all the other boids of the species it is
+// attracted by, not including itself.
+DirectX::XMVECTOR Swarm::ExecuteRule1(int boidIndex, SpeciesParameters const& species)
+{
+    if (species.GetOtherCount() == 0)
+        return XMVectorZero();
+
+    XMVECTOR boidPosition = m_boids.GetPosition(boidIndex);
+    XMVECTOR centre = GetAverageOfOthers(species.PositionTotal, species, boidPosition); // the center of mass
+    XMVECTOR v = XMVectorSubtract(centre, boidPosition) * species.MoveToCenterFactor;
+
+    return v;
+}
+
+// Move away from other boids that are too close to avoid colliding.
+DirectX::XMVECTOR Swarm::ExecuteRule2(NeighborSums const& nearby, SpeciesParameters const& species)
+{
+    // The sums hold the accumulated displacement of each boid that is nearby.
+    XMVECTOR moveDelta = XMLoadFloat3(&nearby.Separation);
+
+    XMVECTOR v = species.AvoidFactor * moveDelta;
+    return v;
+}
+
+// Adjust the boid's velocity to match the average velocity of the other boids of the species it is attracted by.
+// In the visual range mode, the sums take into account only boids in a certain range from a given boid; in the
+// topological mode, only the nearest boids; otherwise, all other boids.
+DirectX::XMVECTOR Swarm::ExecuteRule3(int boidIndex, NeighborSums const& nearby, SpeciesParameters const& species)
+{
+    XMVECTOR v = XMVectorZero();
+    XMVECTOR boidVelocity = m_boids.GetVelocity(boidIndex);
+
+    if (m_step.IsVisualRangeEnabled || m_step.IsTopologicalEnabled)
+    {
+        if (nearby.RangeCount > 0)
+        {
+            XMVECTOR centre = XMLoadFloat3(&nearby.Alignment) / static_cast<float>(nearby.RangeCount);
+            v = XMVectorSubtract(centre, boidVelocity) * species.MatchingFactor;
+        }
+    }
+    else if (species.GetOtherCount() > 0)
+    {
+        XMVECTOR centre = GetAverageOfOthers(species.VelocityTotal, species, boidVelocity);
+        v = XMVectorSubtract(centre, boidVelocity) * species.MatchingFactor;
+    }
+
+    return v;
+}
+
+// Keeps the boid within bounds. The boids can fly out of boundaries, but then slowly turn back, avoiding any harsh motions
+DirectX::XMVECTOR Swarm::ExecuteRule4(int boidIndex, SpeciesParameters const& species)
+{
+    XMFLOAT3 v(0.f, 0.f, 0.f);
+    XMFLOAT3 pos;
+    XMStoreFloat3(&pos, m_boids.GetPosition(boidIndex));
+
+    float turnFactor = species.TurnFactor;
+
+    if (pos.x < -m_boxEdgeLength)
+        v.x = turnFactor;
+    else if (pos.x > m_boxEdgeLength)
+        v.x = -turnFactor;
+
+    if (pos.y < -m_boxEdgeLength)
+        v.y = turnFactor;
+    else if (pos.y > m_boxEdgeLength)
+        v.y = -turnFactor;
+
+    if (pos.z < -m_boxEdgeLength)
+        v.z = turnFactor;
+    else if (pos.z > m_boxEdgeLength)
+        v.z = -turnFactor;
+
+    return XMLoadFloat3(&v);
+}
+
+// Pushes the boid away from the closest point of the obstacles within the obstacle distance. The push grows
+// from nothing at that distance to the full obstacle factor at the surface, so boids curve around obstacles
+// rather than bounce off them. A boid touching the surface has no direction to go and is left alone.
+DirectX::XMVECTOR Swarm::ExecuteRule5(int boidIndex, SpeciesParameters const& species)
+{
+    float range = species.ObstacleDistance;
+    if (m_obstacles.IsEmpty() || range <= 0.f)
+        return XMVectorZero();
+
+    XMVECTOR position = m_boids.GetPosition(boidIndex);
+
+    BvhClosestPoint closest;
+    if (!m_obstacles.FindClosestPoint(position, range, closest) || closest.Distance <= 0.f)
+        return XMVectorZero();
+
+    XMVECTOR away = XMVectorSubtract(position, XMLoadFloat3(&closest.Position)) / closest.Distance;
+    return away * ((1.f - closest.Distance / range) * species.ObstacleFactor);
+}
+
+// Makes the boid flee from every predator within the predator distance, harder the closer the predator is.
+// There are only ever a few predators, so the boid visits all of them.
+DirectX::XMVECTOR Swarm::ExecuteRule6(int boidIndex, SpeciesParameters const& species)
+{
+    XMVECTOR v = XMVectorZero();
+
+    float range = species.PredatorDistance;
+    if (m_predators.empty() || range <= 0.f)
+        return v;
+
+    XMVECTOR position = m_boids.GetPosition(boidIndex);
+
+    for (auto const& predator : m_predators)
+    {
+        XMVECTOR away = XMVectorSubtract(position, XMLoadFloat3(&predator));
+        float distance = XMVectorGetX(XMVector3Length(away));
+
+        if (distance > 0.f && distance < range)
+            v += away * ((1.f - distance / range) * species.PredatorFactor / distance);
+    }
+
+    return v;
+}
+
+// Applies the additions and removals staged since the last step. Removals come first; they only ever take
+// boids that existed before the additions. The boids stay grouped by species: each species keeps the boids
+// that remain at the start of its range, followed by its new boids. Called with m_mutex held.
+void Swarm::ApplyPendingChanges()
+{
+    SWARM_PROFILE_PHASE(m_profiler, SwarmPhase::ApplyChanges);
+
+    std::unique_lock<std::mutex> lock(m_pendingMutex, std::try_to_lock);
+
+    // AddBoids is still creating boids; apply them at a later step.
+    if (!lock.owns_lock())
+        return;
+
+    size_t size = 0;
+    bool hasChanges = false;
+    for (int s = 0; s < MAX_SPECIES_COUNT; ++s)
+    {
+        size += m_speciesSizes[s];
+        hasChanges = hasChanges || m_pending[s].RemoveCount > 0 || m_pending[s].Boids.Size() > 0;
+    }
+
+    if (!hasChanges)
+        return;
+
+    // Rebuild the boids in the back buffer, keeping the IDs in the same chunks as the boids.
+    m_nextBoids.Resize(size);
+    m_nextBoids.SetMaxSpeed(m_boids.GetMaxSpeed());
+
+    std::vector<uint32_t> ids;
+    ids.reserve(m_nextBoids.GetCapacity());
+
+    size_t begin = 0;
+    for (int s = 0; s < MAX_SPECIES_COUNT; ++s)
+    {
+        auto& pending = m_pending[s];
+        size_t end = m_speciesEnds[s];
+        size_t keepCount = end - begin - pending.RemoveCount;
+
+        m_nextBoids.Copy(ids.size(), m_boids, begin, keepCount);
+        ids.insert(ids.end(), m_ids.begin() + begin, m_ids.begin() + begin + keepCount);
+
+        m_nextBoids.Copy(ids.size(), pending.Boids, 0, pending.Boids.Size());
+        ids.insert(ids.end(), pending.Ids.begin(), pending.Ids.end());
+
+        m_speciesEnds[s] = ids.size();
+        begin = end;
+
+        pending.Boids.Clear();
+        pending.Ids.clear();
+        pending.Ids.shrink_to_fit();
+        pending.RemoveCount = 0;
+    }
+
+    std::swap(m_boids, m_nextBoids);
+    m_ids.swap(ids);
+}
+
+// Reorders the boids by the Morton code of their position, so boids near in space are mostly near in memory
+// too and the neighbour loops walk far fewer cache lines. Boids do not move far in a step, so the order stays
+// good for a while. Sorting does not change the motion of a boid, only the order in which its neighbours are
+// summed, so sorted and unsorted runs agree to within float rounding. Called with m_mutex held.
+void Swarm::SortBoids()
+{
+    SWARM_PROFILE_PHASE(m_profiler, SwarmPhase::Sort);
+
+    size_t count = m_boids.Size();
+    if (count < 2)
+        return;
+
+    std::span<float const> positions[] = { m_boids.GetPositionsX(), m_boids.GetPositionsY(), m_boids.GetPositionsZ() };
+
+    // Quantize the positions to a 1024^3 grid over the bounds of the swarm.
+    float lo[3], scale[3];
+    for (int c = 0; c < 3; ++c)
+    {
+        auto [min, max] = std::minmax_element(positions[c].begin(), positions[c].end());
+        lo[c] = *min;
+        scale[c] = (*max > *min) ? 1023.f / (*max - *min) : 0.f;
+    }
+
+    // Sort the codes together with the boid indices in the low bits, which also makes the order deterministic.
+    std::vector<uint64_t> keys(count);
+
+    m_threadPool->ParallelFor(count, BOIDS_PER_SORT_TASK, [&](size_t begin, size_t end, unsigned)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                uint32_t cell[3];
+                for (int c = 0; c < 3; ++c)
+                    cell[c] = static_cast<uint32_t>((positions[c][i] - lo[c]) * scale[c]);
+
+                keys[i] = (static_cast<uint64_t>(GetMortonCode(cell[0], cell[1], cell[2])) << 32) | i;
+            }
+        });
+
+    // Sort each species on its own, so the boids stay grouped by species.
+    for (int s = 0; s < MAX_SPECIES_COUNT; ++s)
+        std::sort(keys.begin() + GetSpeciesBegin(s), keys.begin() + GetSpeciesEnd(s));
+
+    // Gather the boids into the back buffer in the new order.
+    m_nextBoids.Resize(count);
+
+    std::span<float const> sources[] = {
+        m_boids.GetPositionsX(), m_boids.GetPositionsY(), m_boids.GetPositionsZ(),
+        m_boids.GetVelocitiesX(), m_boids.GetVelocitiesY(), m_boids.GetVelocitiesZ() };
+    std::span<float> targets[] = {
+        m_nextBoids.GetPositionsX(), m_nextBoids.GetPositionsY(), m_nextBoids.GetPositionsZ(),
+        m_nextBoids.GetVelocitiesX(), m_nextBoids.GetVelocitiesY(), m_nextBoids.GetVelocitiesZ() };
+
+    m_threadPool->ParallelFor(count, BOIDS_PER_SORT_TASK, [&](size_t begin, size_t end, unsigned)
+        {
+            for (size_t c = 0; c < std::size(sources); ++c)
+            {
+                for (size_t i = begin; i < end; ++i)
+                    targets[c][i] = sources[c][static_cast<uint32_t>(keys[i])];
+            }
+        });
+
+    m_nextBoids.SetMaxSpeed(m_boids.GetMaxSpeed());
+    std::swap(m_boids, m_nextBoids);
+
+    // Reuse the keys to carry the IDs along.
+    for (size_t i = 0; i < count; ++i)
+        keys[i] = m_ids[static_cast<uint32_t>(keys[i])];
+
+    for (size_t i = 0; i < count; ++i)
+        m_ids[i] = static_cast<uint32_t>(keys[i]);
+}
+
+// Reads the parameters of every species and the interaction matrix once for the whole step.
+void Swarm::ReadStepParameters()
+{
+    m_step.IsTopologicalEnabled = m_isTopologicalEnabled;
+    m_step.IsVisualRangeEnabled = m_isVisualRangeEnabled && !m_step.IsTopologicalEnabled;
+    m_step.TopologicalNeighborCount = m_topologicalNeighborCount;
+    m_step.SpeciesCount = m_speciesCount;
+    m_step.Integration = m_integrator;
+    m_step.MaxSubstepCount = m_maxSubstepCount;
+    m_step.IsUniform = true;
+
+    for (int s = 0; s < m_step.SpeciesCount; ++s)
+    {
+        BoidParameterValues parameters = m_boidParameters[s].Read();
+
+        auto& species = m_step.Species[s];
+        species.SeparationDistance = m_boidRadius + parameters[BoidParameter::MinDistance];
+        species.VisualRange = parameters[BoidParameter::VisualRange];
+        species.MoveToCenterFactor = parameters[BoidParameter::MoveToCenterFactor];
+        species.AvoidFactor = parameters[BoidParameter::AvoidFactor];
+        species.MatchingFactor = parameters[BoidParameter::MatchingFactor];
+        species.TurnFactor = parameters[BoidParameter::TurnFactor];
+        species.MaxSpeed = parameters[BoidParameter::MaxSpeed];
+        species.ObstacleDistance = parameters[BoidParameter::ObstacleDistance];
+        species.ObstacleFactor = parameters[BoidParameter::ObstacleFactor];
+        species.PredatorDistance = parameters[BoidParameter::PredatorDistance];
+        species.PredatorFactor = parameters[BoidParameter::PredatorFactor];
+
+        species.AttractMask = 0;
+        species.AvoidMask = 0;
+        for (int t = 0; t < m_step.SpeciesCount; ++t)
+        {
+            SpeciesInteraction interaction = m_interactions[s * MAX_SPECIES_COUNT + t];
+            if (interaction == SpeciesInteraction::Attract)
+                species.AttractMask |= 1u << t;
+            else if (interaction == SpeciesInteraction::Avoid)
+                species.AvoidMask |= 1u << t;
+
+            m_step.IsUniform = m_step.IsUniform && interaction == SpeciesInteraction::Attract;
+        }
+
+        species.IsSelfAttracted = (species.AttractMask & (1u << s)) != 0;
+    }
+}
+
+// Sorts the boids into a uniform grid so rules 2 and 3 only need to visit the neighbouring cells. A single grid
+// serves all species, so its cells are sized for the largest distance any species looks at.
+void Swarm::BuildGrid()
+{
+    SWARM_PROFILE_PHASE(m_profiler, SwarmPhase::BuildGrid);
+
+    float queryRange = 0.f;
+    for (int s = 0; s < m_step.SpeciesCount; ++s)
+    {
+        auto const& species = m_step.Species[s];
+        queryRange = std::max(queryRange, species.SeparationDistance);
+
+        if (m_step.IsVisualRangeEnabled || species.AvoidMask != 0)
+            queryRange = std::max(queryRange, species.VisualRange);
+    }
+
+    m_grid.Build(m_boids.GetPositionsX(), m_boids.GetPositionsY(), m_boids.GetPositionsZ(), queryRange);
+}
+
+// Indexes the boids for the nearest neighbour queries of the topological mode. A grid would need ever more
+// cells searched where the boids are sparse; the cost of a query on the tree does not depend on the density.
+void Swarm::BuildTree()
+{
+    SWARM_PROFILE_PHASE(m_profiler, SwarmPhase::BuildTree);
+
+    if (m_step.IsTopologicalEnabled)
+        m_tree.Build(m_boids.GetPositionsX(), m_boids.GetPositionsY(), m_boids.GetPositionsZ());
+}
+
+// Accumulates the separation sums and, in the visual range mode, the alignment sums over the boids in the neighbouring
+// grid cells. With several species, the candidates are first split by how the boid responds to their species, and each
+// list goes through the kernel on its own.
+NeighborSums Swarm::GetNearbySums(int boidIndex, SpeciesParameters const& species, unsigned participant)
+{
+    float minDistance = species.SeparationDistance;
+    float visualRange = m_step.IsVisualRangeEnabled ? species.VisualRange : 0.f;
+
+    NeighborQuery query;
+    XMStoreFloat3(&query.Position, m_boids.GetPosition(boidIndex));
+    query.SeparationDistanceSq = minDistance * minDistance;
+    query.RangeDistanceSq = visualRange * visualRange;
+
+    auto& candidates = m_candidates[participant];
+    auto& avoidedCandidates = m_avoidedCandidates[participant];
+    candidates.clear();
+    avoidedCandidates.clear();
+
+    if (m_step.IsUniform)
+    {
+        m_grid.ForEachNeighbor(query.Position.x, query.Position.y, query.Position.z, [boidIndex, &candidates](uint32_t i)
+            {
+                if (boidIndex != static_cast<int>(i))
+                    candidates.push_back(i);
+            });
+    }
+    else
+    {
+        // The boids are grouped by species, so the species of a candidate is the number of species ranges that
+        // end at or before its index. Counting them without branches keeps the loop cheap.
+        int boundaryCount = m_step.SpeciesCount - 1;
+        auto const& ends = m_speciesEnds;
+
+        m_grid.ForEachNeighbor(query.Position.x, query.Position.y, query.Position.z, [&](uint32_t i)
+            {
+                if (boidIndex == static_cast<int>(i))
+                    return;
+
+                int speciesIndex = 0;
+                for (int s = 0; s < boundaryCount; ++s)
+                    speciesIndex += i >= ends[s] ? 1 : 0;
+
+                uint32_t speciesBit = 1u << speciesIndex;
+                if (species.AttractMask & speciesBit)
+                    candidates.push_back(i);
+                else if (species.AvoidMask & speciesBit)
+                    avoidedCandidates.push_back(i);
+            });
+    }
+
+    NeighborSums sums{};
+    AccumulateNeighbors(m_kernelWidth, m_boids, query, candidates, sums);
+
+    // Avoided boids only push the boid away, from as far as the visual range.
+    if (!avoidedCandidates.empty())
+    {
+        float avoidDistance = std::max(species.VisualRange, minDistance);
+
+        NeighborQuery avoidQuery = query;
+        avoidQuery.SeparationDistanceSq = avoidDistance * avoidDistance;
+        avoidQuery.RangeDistanceSq = 0.f;
+
+        AccumulateNeighbors(m_kernelWidth, m_boids, avoidQuery, avoidedCandidates, sums);
+    }
+
+    return sums;
+}
+
+// Sets the alignment sums to the velocities of the boid's nearest neighbours. Unlike the visual range, the
+// number of neighbours does not depend on how densely the boids crowd together. Of the nearest neighbours,
+// only those of the species the boid is attracted by count.
+void Swarm::SetNearestSums(int boidIndex, SpeciesParameters const& species, NeighborSums& sums)
+{
+    NearestNeighbor nearest[MAX_TOPOLOGICAL_NEIGHBOR_COUNT];
+
+    XMFLOAT3 position;
+    XMStoreFloat3(&position, m_boids.GetPosition(boidIndex));
+
+    size_t count = m_tree.FindNearest(position.x, position.y, position.z, static_cast<uint32_t>(boidIndex),
+        std::span(nearest, m_step.TopologicalNeighborCount));
+
+    XMVECTOR alignment = XMVectorZero();
+    uint32_t alignedCount = 0;
+    for (size_t n = 0; n < count; ++n)
+    {
+        if (m_step.IsUniform || (species.AttractMask & (1u << GetSpecies(nearest[n].Index))))
+        {
+            alignment += m_boids.GetVelocity(nearest[n].Index);
+            ++alignedCount;
+        }
+    }
+
+    XMStoreFloat3(&sums.Alignment, alignment);
+    sums.RangeCount = alignedCount;
+}
+
+// Sums the positions and velocities of the boids of each species once per step, so rules 1 and 3 can average over
+// the other boids in constant time instead of visiting all of them for every boid. Each species then adds up the
+// totals of the species it is attracted by. The totals are kept in double precision, so subtracting the boid's own
+// contribution does not cancel away the significant digits.
+void Swarm::ComputeTotals()
+{
+    SWARM_PROFILE_PHASE(m_profiler, SwarmPhase::ComputeTotals);
+
+    std::span<float const> components[] = {
+        m_boids.GetPositionsX(), m_boids.GetPositionsY(), m_boids.GetPositionsZ(),
+        m_boids.GetVelocitiesX(), m_boids.GetVelocitiesY(), m_boids.GetVelocitiesZ() };
+
+    PerSpecies<std::array<double, 6>> speciesTotals{}; // the totals of each component of each species
+
+    for (int s = 0; s < m_step.SpeciesCount; ++s)
+    {
+        size_t begin = GetSpeciesBegin(s);
+        size_t end = GetSpeciesEnd(s);
+
+        for (size_t c = 0; c < std::size(components); ++c)
+        {
+            double total = 0.0;
+            for (float value : components[c].subspan(begin, end - begin))
+                total += value;
+
+            speciesTotals[s][c] = total;
+        }
+    }
+
+    for (int s = 0; s < m_step.SpeciesCount; ++s)
+    {
+        auto& species = m_step.Species[s];
+        double* totals[] = {
+            &species.PositionTotal[0], &species.PositionTotal[1], &species.PositionTotal[2],
+            &species.VelocityTotal[0], &species.VelocityTotal[1], &species.VelocityTotal[2] };
+
+        species.AttractCount = 0;
+        for (size_t c = 0; c < std::size(totals); ++c)
+            *totals[c] = 0.0;
+
+        for (int t = 0; t < m_step.SpeciesCount; ++t)
+        {
+            if ((species.AttractMask & (1u << t)) == 0)
+                continue;
+
+            species.AttractCount += GetSpeciesEnd(t) - GetSpeciesBegin(t);
+            for (size_t c = 0; c < std::size(totals); ++c)
+                *totals[c] += speciesTotals[t][c];
+        }
+    }
+}
+
+// Returns (total - self) / (N - 1), the average over the boids the species is attracted by except the one whose value
+// is self. If the species is not attracted by its own boids, the boid is not part of the total.
+DirectX::XMVECTOR Swarm::GetAverageOfOthers(double const total[3], SpeciesParameters const& species, DirectX::FXMVECTOR self) const
+{
+    XMFLOAT3 value(0.f, 0.f, 0.f);
+    if (species.IsSelfAttracted)
+        XMStoreFloat3(&value, self);
+
+    double otherCount = static_cast<double>(species.GetOtherCount());
+
+    return XMVectorSet(
+        static_cast<float>((total[0] - value.x) / otherCount),
+        static_cast<float>((total[1] - value.y) / otherCount),
+        static_cast<float>((total[2] - value.z) / otherCount),
+        0.f);
+}
+
+// Returns the species of the boid at the index. The boids are grouped by species.
+int Swarm::GetSpecies(size_t boidIndex) const
+{
+    int species = 0;
+    while (species < MAX_SPECIES_COUNT - 1 && boidIndex >= m_speciesEnds[species])
+        ++species;
+
+    return species;
+}
+
+std::tuple<DirectX::XMVECTOR, DirectX::XMVECTOR> Swarm::GetRandomPositionAndVelocity(int species)
+{
+    // Draw the numbers one per statement. The evaluation order of function arguments is unspecified,
+    // so drawing them inside XMVectorSet would make seeded runs differ between compilers.
+    XMFLOAT3 position;
+    position.x = m_rand->GetFloat(-8.0f * m_boxEdgeLength, 8.0f * m_boxEdgeLength);
+    position.y = m_rand->GetFloat(2.0f * m_boxEdgeLength, 5.0f * m_boxEdgeLength);
+    position.z = m_rand->GetFloat(-2.0f * m_boxEdgeLength, -6.5f * m_boxEdgeLength);
+
+    XMFLOAT3 direction;
+    direction.x = m_rand->GetFloat(-1, 1);
+    direction.y = m_rand->GetFloat(-1, 1);
+    direction.z = m_rand->GetFloat(-1, 1);
+
+    XMVECTOR randomPosition = XMLoadFloat3(&position);
+    XMVECTOR randomVelocity = GetBoidParameter(species, BoidParameter::MaxSpeed) * XMVector4Normalize(XMLoadFloat3(&direction));
+
+    return { randomPosition, randomVelocity };
+}
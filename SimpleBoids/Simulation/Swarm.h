@@ -0,0 +1,300 @@
+#pragma once
+
+#include "Boid.h"
+#include "BoidKernel.h"
+#include "BoidParameters.h"
+#include "BoidStore.h"
+#include "Bvh.h"
+#include "KdTree.h"
+#include "RandomNumberHelper.h"
+#include "SpatialGrid.h"
+#include "SwarmProfiler.h"
+#include "SwarmCheckpoint.h"
+#include "ThreadPool.h"
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <tuple>
+
+// How the boids of one species respond to the boids of another.
+enum class SpeciesInteraction : uint8_t
+{
+    Attract,    // flock with them: keep the separation distance, move towards them and match their velocity
+    Ignore,     // pay no attention to them
+    Avoid,      // keep them out of the visual range, without moving towards them or matching their velocity
+};
+
+// A swarm of boids of one or more species. Each species has its own parameters, and an interaction matrix
+// sets how each species responds to each other one. The boids are stored grouped by species, so the boids
+// of a species occupy a contiguous range of the arrays.
+class Swarm
+{
+public:
+    Swarm(
+        float boidRadius, 
+        float boidMinDistance, 
+        float boidMatchingFactor, 
+        float maxBoidSpeed,
+        float boidAvoidFactor,
+        float boidTurnFactor,
+        float boidVisualRange,
+        float boidMoveToCenterFactor,
+        float boxEdgeLength);
+
+    // Creates or destroys the given number of boids of a species. The changes are staged and take effect at
+    // the start of the next Update, so neither call waits for a running Update. Removing boids takes back the
+    // boids of the species that have not been added yet first, then removes the ones stored last.
+    void AddBoids(int count, int species = 0);
+    void RemoveBoids(int count, int species = 0);
+
+    // Adds a species with the parameters of species 0, which attracts and is attracted by all species.
+    // Returns the index of the new species, or -1 if there are MAX_SPECIES_COUNT already. Species cannot
+    // be removed, but they can be emptied.
+    int AddSpecies();
+
+    // Moves boids to new positions. The boids are updated in parallel from the state at the start of the step.
+    // Staged additions and removals are applied first, unless AddBoids is still creating boids on another
+    // thread; then they are left for a later step rather than holding up this one. Every SortInterval steps,
+    // the boids are then sorted by the Morton code of their position. With a time-correct integrator, a step
+    // in which the fastest boids would move further than SUBSTEP_SEPARATION_FRACTION of their separation
+    // distance is split into up to MaxSubstepCount sub-steps, each of which evaluates the rules again, so the
+    // flock behaves alike at any update rate.
+    void Update(float timeDelta);
+
+    // Sets the static obstacles the boids steer around, as a triangle list, e.g. the vertex positions and
+    // indices of a mesh. The triangles are indexed in a BVH, so a boid only tests the few near it. Waits for a
+    // running Update. Empty spans remove the obstacles.
+    void SetObstacles(std::span<DirectX::XMFLOAT3 const> positions, std::span<uint32_t const> indices);
+
+    // Sets the positions of the predators the boids flee from. The caller moves the predators; the positions
+    // take effect at the start of the next Update, without waiting for a running one.
+    void SetPredators(std::span<DirectX::XMFLOAT3 const> positions);
+
+    // Moves boids to initial random positions.
+    void ResetBoids();
+
+    // Restarts the random sequence used by AddBoids and ResetBoids. A swarm seeded with the same value
+    // and given the same calls and time steps produces the same states on every run.
+    void Seed(uint32_t seed);
+
+    // Returns a hash of the positions and velocities of all boids. See BoidStore::ComputeChecksum.
+    uint64_t ComputeChecksum();
+
+    // Writes the world matrix of each boid to the transforms, in the boid order and in the row-vector
+    // convention of XMMATRIX. Returns the number of matrices written, which is the smaller of Size() and
+    // the size of the transforms.
+    size_t WriteInstanceTransforms(std::span<DirectX::XMFLOAT4X4> transforms);
+
+    // Copies the positions and velocities of all boids to the target, and their IDs to the IDs.
+    void CopyState(BoidStore& target, std::vector<uint32_t>& ids);
+
+    // Writes the boids, the species with their parameters and interactions, the settings, the predators and the
+    // position in the random sequence to a checkpoint (see SwarmCheckpoint). Staged additions and removals, the
+    // obstacles and the thread and kernel choices are not saved.
+    void SaveCheckpoint(std::vector<std::byte>& checkpoint, CheckpointPositionFormat format = CheckpointPositionFormat::Float32);
+
+    // Replaces the state of the swarm with a checkpoint and drops the staged changes. A swarm restored from a
+    // Float32 checkpoint and given the same calls and time steps produces the same states as the saved one. Returns
+    // false and leaves the swarm unchanged if the checkpoint does not describe a valid swarm.
+    bool LoadCheckpoint(SwarmCheckpoint const& checkpoint);
+
+    // Returns the number of bytes allocated for the boids and the data structures Update builds from them.
+    size_t GetMemoryUsage();
+
+    // Profiling counters. They are only gathered when the simulation is compiled with SWARM_PROFILING.
+    static constexpr bool IsProfilingCompiledIn()
+    {
+#if defined(SWARM_PROFILING)
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    SwarmProfiler& GetProfiler() { return m_profiler; }
+
+    // Accessors
+    size_t Size() const { return m_size; } // including the staged changes
+    Boid GetBoid(size_t index) { return Boid(m_boids, index); }
+    float GetBoidParameter(BoidParameter parameter) const { return GetBoidParameter(0, parameter); }
+    void SetBoidParameter(BoidParameter parameter, float value) { SetBoidParameter(0, parameter, value); }
+    int GetSpeciesCount() const { return m_speciesCount; }
+    size_t GetSpeciesSize(int species) const; // including the staged changes
+    float GetBoidParameter(int species, BoidParameter parameter) const;
+    void SetBoidParameter(int species, BoidParameter parameter, float value);
+    SpeciesInteraction GetInteraction(int species, int other) const; // how the boids of the species respond to the other
+    void SetInteraction(int species, int other, SpeciesInteraction interaction);
+    bool IsVisualRangeEnabled() const { return m_isVisualRangeEnabled; }
+    void IsVisualRangeEnabled(bool enabled) { m_isVisualRangeEnabled = enabled; }
+    bool IsTopologicalEnabled() const { return m_isTopologicalEnabled; }
+    void IsTopologicalEnabled(bool enabled) { m_isTopologicalEnabled = enabled; } // takes precedence over the visual range
+    int GetTopologicalNeighborCount() const { return m_topologicalNeighborCount; }
+    void SetTopologicalNeighborCount(int count); // clamped to [1, MAX_TOPOLOGICAL_NEIGHBOR_COUNT]
+    KernelWidth GetKernelWidth() const { return m_kernelWidth; }
+    void SetKernelWidth(KernelWidth width);
+    unsigned GetThreadCount() const { return m_threadPool->GetThreadCount(); }
+    void SetThreadCount(unsigned threadCount); // zero selects the number of hardware threads
+    int GetSortInterval() const { return m_sortInterval; }
+    void SetSortInterval(int steps) { m_sortInterval = std::max(steps, 0); } // zero never sorts
+    Integrator GetIntegrator() const { return m_integrator; }
+    void SetIntegrator(Integrator integrator) { m_integrator = integrator; }
+    int GetMaxSubstepCount() const { return m_maxSubstepCount; }
+    void SetMaxSubstepCount(int count); // clamped to [1, MAX_SUBSTEP_COUNT]; one turns sub-stepping off
+
+    // Boid state as contiguous arrays. The spans are invalidated by Update once boids have been added or removed.
+    // Sorting moves the boids around in the arrays; the ID of a boid stays the same for as long as it exists.
+    std::span<uint32_t const> GetBoidIds() const { return m_ids; }
+    std::span<float const> GetPositionsX() const { return m_boids.GetPositionsX(); }
+    std::span<float const> GetPositionsY() const { return m_boids.GetPositionsY(); }
+    std::span<float const> GetPositionsZ() const { return m_boids.GetPositionsZ(); }
+    std::span<float const> GetVelocitiesX() const { return m_boids.GetVelocitiesX(); }
+    std::span<float const> GetVelocitiesY() const { return m_boids.GetVelocitiesY(); }
+    std::span<float const> GetVelocitiesZ() const { return m_boids.GetVelocitiesZ(); }
+
+    // The boids of a species are stored at the indices [GetSpeciesBegin(species), GetSpeciesEnd(species)).
+    // Like the spans, the ranges change when Update adds or removes boids.
+    size_t GetSpeciesBegin(int species) const { return species > 0 ? m_speciesEnds[species - 1] : 0; }
+    size_t GetSpeciesEnd(int species) const { return m_speciesEnds[species]; }
+
+    // In the topological mode, each boid matches the velocity of a fixed number of its nearest neighbours
+    // rather than of those within the visual range. Starlings, for one, follow about seven.
+    static constexpr int DEFAULT_TOPOLOGICAL_NEIGHBOR_COUNT = 7;
+    static constexpr int MAX_TOPOLOGICAL_NEIGHBOR_COUNT = 32;
+
+    // The initial values of the obstacle and predator parameters.
+    static constexpr float DEFAULT_OBSTACLE_DISTANCE = 4.f;
+    static constexpr float DEFAULT_OBSTACLE_FACTOR = 1.f;
+    static constexpr float DEFAULT_PREDATOR_DISTANCE = 15.f;
+    static constexpr float DEFAULT_PREDATOR_FACTOR = 1.f;
+
+    static constexpr int MAX_SPECIES_COUNT = 8;
+
+    // A sub-step moves no boid further than this fraction of its separation distance, so boids cannot pass
+    // through each other between two evaluations of the rules.
+    static constexpr float SUBSTEP_SEPARATION_FRACTION = 0.6f;
+    static constexpr int MAX_SUBSTEP_COUNT = 16;
+
+private:
+    template<typename T>
+    using PerSpecies = std::array<T, MAX_SPECIES_COUNT>;
+
+    // Row s holds the responses of species s to each species.
+    using InteractionMatrix = std::array<std::atomic<SpeciesInteraction>, MAX_SPECIES_COUNT * MAX_SPECIES_COUNT>;
+
+    // The number of boids a thread updates at a time.
+    static constexpr size_t BOIDS_PER_TASK = 64;
+
+    // The number of Morton codes a thread computes, or boids it moves, at a time.
+    static constexpr size_t BOIDS_PER_SORT_TASK = 4096;
+
+    // The number of world matrices a thread computes at a time.
+    static constexpr size_t TRANSFORMS_PER_TASK = 1024;
+
+    // The parameters of one species in a step.
+    struct SpeciesParameters
+    {
+        float SeparationDistance;
+        float VisualRange;
+        float MoveToCenterFactor;
+        float AvoidFactor;
+        float MatchingFactor;
+        float TurnFactor;
+        float MaxSpeed;
+        float ObstacleDistance;
+        float ObstacleFactor;
+        float PredatorDistance;
+        float PredatorFactor;
+        uint32_t AttractMask;       // bit t is set if the species is attracted by species t
+        uint32_t AvoidMask;         // bit t is set if the species avoids species t
+        bool IsSelfAttracted;
+        size_t AttractCount;        // the number of boids of the species it is attracted by
+        double PositionTotal[3];    // the sum of the positions of those boids at the start of the step
+        double VelocityTotal[3];    // the sum of their velocities
+
+        // The number of boids a boid of the species is attracted by, not counting itself.
+        size_t GetOtherCount() const { return AttractCount - (IsSelfAttracted ? 1 : 0); }
+    };
+
+    // Parameters read once per step, so a step sees a consistent set of values however the UI changes them.
+    struct StepParameters
+    {
+        bool IsVisualRangeEnabled;
+        bool IsTopologicalEnabled;
+        int TopologicalNeighborCount;
+        int SpeciesCount;
+        Integrator Integration;
+        int MaxSubstepCount;
+        bool IsUniform;             // all species attract each other, so the neighbours need not be told apart
+        PerSpecies<SpeciesParameters> Species;
+    };
+
+    // The changes to one species staged since the last Update.
+    struct PendingChanges
+    {
+        BoidStore               Boids{ 0.f };
+        std::vector<uint32_t>   Ids;
+        size_t                  RemoveCount = 0;
+    };
+
+    std::mutex                                  m_mutex;
+    BoidStore                                   m_boids;        // the current state
+    BoidStore                                   m_nextBoids;    // the state being computed by Update
+    std::vector<uint32_t>                       m_ids;          // the ID of each boid in m_boids
+    PerSpecies<size_t>                          m_speciesEnds;  // the end of the range of each species in m_boids
+    std::mutex                                  m_pendingMutex; // guards the staged changes and the random numbers
+    PerSpecies<PendingChanges>                  m_pending;
+    uint32_t                                    m_nextId;
+    std::atomic<size_t>                         m_size;
+    PerSpecies<std::atomic<size_t>>             m_speciesSizes; // including the staged changes
+    std::atomic<int>                            m_speciesCount;
+    std::unique_ptr<RandomNumberHelper>         m_rand;
+    float                                       m_boidRadius;
+    PerSpecies<BoidParameters>                  m_boidParameters;
+    InteractionMatrix                           m_interactions;
+    std::atomic<bool>                           m_isVisualRangeEnabled;
+    std::atomic<bool>                           m_isTopologicalEnabled;
+    std::atomic<int>                            m_topologicalNeighborCount;
+    std::atomic<int>                            m_sortInterval;
+    int                                         m_stepsSinceSort;
+    std::atomic<Integrator>                     m_integrator;
+    std::atomic<int>                            m_maxSubstepCount;
+    float                                       m_boxEdgeLength;
+    SpatialGrid                                 m_grid;
+    Bvh                                         m_obstacles;
+    std::mutex                                  m_predatorMutex;    // guards the staged predator positions
+    std::vector<DirectX::XMFLOAT3>              m_pendingPredators;
+    std::vector<DirectX::XMFLOAT3>              m_predators;        // the predator positions during the step
+    KdTree                                      m_tree;         // built only in the topological mode
+    std::vector<std::vector<uint32_t>>          m_candidates;   // scratch space for each thread
+    std::vector<std::vector<uint32_t>>          m_avoidedCandidates;
+    KernelWidth                                 m_kernelWidth;
+    std::unique_ptr<ThreadPool>                 m_threadPool;
+    StepParameters                              m_step;
+    SwarmProfiler                               m_profiler;
+
+    void ApplyPendingChanges();
+    void SortBoids();
+    void ReadStepParameters();
+    void BuildGrid();
+    void BuildTree();
+    void ComputeTotals();
+    int GetSubstepCount(float timeDelta) const;
+    void UpdateAllBoids(float timeDelta);
+    void UpdateBoids(size_t begin, size_t end, unsigned participant, float timeDelta);
+    DirectX::XMVECTOR ExecuteRule1(int boidIndex, SpeciesParameters const& species);
+    DirectX::XMVECTOR ExecuteRule2(NeighborSums const& nearby, SpeciesParameters const& species);
+    DirectX::XMVECTOR ExecuteRule3(int boidIndex, NeighborSums const& nearby, SpeciesParameters const& species);
+    DirectX::XMVECTOR ExecuteRule4(int boidIndex, SpeciesParameters const& species);
+    DirectX::XMVECTOR ExecuteRule5(int boidIndex, SpeciesParameters const& species);
+    DirectX::XMVECTOR ExecuteRule6(int boidIndex, SpeciesParameters const& species);
+
+    NeighborSums GetNearbySums(int boidIndex, SpeciesParameters const& species, unsigned participant);
+    void SetNearestSums(int boidIndex, SpeciesParameters const& species, NeighborSums& sums);
+    DirectX::XMVECTOR GetAverageOfOthers(double const total[3], SpeciesParameters const& species, DirectX::FXMVECTOR self) const;
+    int GetSpecies(size_t boidIndex) const;
+    bool IsValidSpecies(int species) const { return species >= 0 && species < m_speciesCount; }
+
+    std::tuple<DirectX::XMVECTOR, DirectX::XMVECTOR> GetRandomPositionAndVelocity(int species);
+};
+
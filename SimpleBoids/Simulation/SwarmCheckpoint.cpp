@@ -0,0 +1,155 @@
+#include "pch.h"
+#include "SwarmCheckpoint.h"
+
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+    const float QUANTIZATION_STEPS = 65535.f;
+
+    size_t AlignSection(size_t offset)
+    {
+        return (offset + SwarmCheckpoint::SECTION_ALIGNMENT - 1) / SwarmCheckpoint::SECTION_ALIGNMENT * SwarmCheckpoint::SECTION_ALIGNMENT;
+    }
+
+    // Reserves a section for the given number of values and returns its offset.
+    template<typename T>
+    size_t AddSection(size_t& offset, uint64_t count)
+    {
+        size_t section = AlignSection(offset);
+        offset = section + static_cast<size_t>(count) * sizeof(T);
+        return section;
+    }
+}
+
+bool SwarmCheckpoint::Open(std::span<std::byte const> data)
+{
+    m_data = {};
+    m_header = nullptr;
+
+    if (data.size() < sizeof(SwarmCheckpointHeader) || reinterpret_cast<uintptr_t>(data.data()) % alignof(SwarmCheckpointHeader) != 0)
+        return false;
+
+    auto header = *reinterpret_cast<SwarmCheckpointHeader const*>(data.data());
+    if (header.Magic != MAGIC || header.Version != VERSION || header.Size > data.size())
+        return false;
+
+    if (header.PositionFormat > static_cast<uint32_t>(CheckpointPositionFormat::Quantized16) || header.SpeciesCount == 0)
+        return false;
+
+    // Every count takes at least a byte per item, so none can exceed the size. This keeps the layout from overflowing.
+    uint64_t size = header.Size;
+    if (header.BoidCount > size || header.SpeciesCount > size || header.ParameterCount > size ||
+        header.PredatorCount > size || header.RandomStateSize > size)
+        return false;
+
+    uint64_t savedSize = header.Size;
+    m_layout = ComputeLayout(header);
+    if (m_layout.Size != savedSize)
+        return false;
+
+    m_data = data;
+    m_header = reinterpret_cast<SwarmCheckpointHeader const*>(data.data());
+    return true;
+}
+
+SwarmCheckpointLayout SwarmCheckpoint::ComputeLayout(SwarmCheckpointHeader& header)
+{
+    bool isQuantized = header.PositionFormat == static_cast<uint32_t>(CheckpointPositionFormat::Quantized16);
+
+    SwarmCheckpointLayout layout{};
+    size_t offset = sizeof(SwarmCheckpointHeader);
+
+    layout.SpeciesEnds = AddSection<uint64_t>(offset, header.SpeciesCount);
+    layout.Parameters = AddSection<float>(offset, uint64_t{ header.SpeciesCount } * header.ParameterCount);
+    layout.Interactions = AddSection<uint8_t>(offset, uint64_t{ header.SpeciesCount } * header.SpeciesCount);
+    layout.Predators = AddSection<XMFLOAT3>(offset, header.PredatorCount);
+    layout.RandomState = AddSection<char>(offset, header.RandomStateSize);
+    layout.Ids = AddSection<uint32_t>(offset, header.BoidCount);
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        layout.Positions[axis] = isQuantized ?
+            AddSection<uint16_t>(offset, header.BoidCount) :
+            AddSection<float>(offset, header.BoidCount);
+    }
+
+    for (int axis = 0; axis < 3; ++axis)
+        layout.Velocities[axis] = AddSection<float>(offset, header.BoidCount);
+
+    layout.Size = AlignSection(offset);
+    header.Size = layout.Size;
+    return layout;
+}
+
+void SwarmCheckpoint::GetQuantization(std::span<float const> positions, float& min, float& scale)
+{
+    min = 0.f;
+    scale = 0.f;
+    if (positions.empty())
+        return;
+
+    auto [lowest, highest] = std::minmax_element(positions.begin(), positions.end());
+    min = *lowest;
+    scale = (*highest - *lowest) / QUANTIZATION_STEPS;
+}
+
+uint16_t SwarmCheckpoint::Quantize(float position, float min, float scale)
+{
+    if (scale <= 0.f)
+        return 0;
+
+    float step = std::round((position - min) / scale);
+    return static_cast<uint16_t>(std::clamp(step, 0.f, QUANTIZATION_STEPS));
+}
+
+std::span<float const> SwarmCheckpoint::GetParameters(int species) const
+{
+    size_t count = m_header->ParameterCount;
+    return GetSection<float>(m_layout.Parameters + species * count * sizeof(float), count);
+}
+
+std::span<uint8_t const> SwarmCheckpoint::GetInteractions() const
+{
+    return GetSection<uint8_t>(m_layout.Interactions, size_t{ m_header->SpeciesCount } * m_header->SpeciesCount);
+}
+
+std::string_view SwarmCheckpoint::GetRandomState() const
+{
+    return { reinterpret_cast<char const*>(m_data.data() + m_layout.RandomState), m_header->RandomStateSize };
+}
+
+std::span<float const> SwarmCheckpoint::GetPositions(int axis) const
+{
+    if (GetPositionFormat() != CheckpointPositionFormat::Float32)
+        return {};
+
+    return GetSection<float>(m_layout.Positions[axis], GetBoidCount());
+}
+
+std::span<uint16_t const> SwarmCheckpoint::GetQuantizedPositions(int axis) const
+{
+    if (GetPositionFormat() != CheckpointPositionFormat::Quantized16)
+        return {};
+
+    return GetSection<uint16_t>(m_layout.Positions[axis], GetBoidCount());
+}
+
+void SwarmCheckpoint::ReadPositions(int axis, std::span<float> target) const
+{
+    if (GetPositionFormat() == CheckpointPositionFormat::Float32)
+    {
+        auto positions = GetPositions(axis);
+        std::copy(positions.begin(), positions.end(), target.begin());
+        return;
+    }
+
+    float min = m_header->PositionMin[axis];
+    float scale = m_header->PositionScale[axis];
+
+    auto steps = GetQuantizedPositions(axis);
+    for (size_t i = 0; i < steps.size(); ++i)
+        target[i] = min + scale * steps[i];
+}
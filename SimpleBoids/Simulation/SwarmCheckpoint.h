@@ -0,0 +1,107 @@
+#pragma once
+
+#include <span>
+#include <string_view>
+
+// How a checkpoint stores the boid positions.
+enum class CheckpointPositionFormat : uint32_t
+{
+    Float32,        // exactly, so a restored swarm continues bit for bit like the saved one
+    Quantized16,    // in 16 bits per component relative to the bounds of the swarm, which saves 6 bytes per boid
+};
+
+// The fixed part at the start of a checkpoint.
+struct SwarmCheckpointHeader
+{
+    uint32_t    Magic;
+    uint32_t    Version;
+    uint64_t    Size;                       // of the whole checkpoint, in bytes
+    uint64_t    BoidCount;
+    uint32_t    NextId;                     // the ID of the next boid to be added
+    uint32_t    PositionFormat;             // a CheckpointPositionFormat
+    uint32_t    SpeciesCount;
+    uint32_t    ParameterCount;             // per species, in the order of BoidParameter
+    uint32_t    PredatorCount;
+    uint32_t    RandomStateSize;            // in bytes
+    float       BoidRadius;
+    float       BoxEdgeLength;
+    uint32_t    Flags;                      // SwarmCheckpoint::VISUAL_RANGE_FLAG and TOPOLOGICAL_FLAG
+    int32_t     TopologicalNeighborCount;
+    int32_t     SortInterval;
+    int32_t     StepsSinceSort;
+    uint32_t    Integrator;
+    int32_t     MaxSubstepCount;
+    float       PositionMin[3];             // the origin of the quantized positions
+    float       PositionScale[3];           // the size of a quantization step along each axis
+};
+
+// The offsets of the sections of a checkpoint from its start, in bytes.
+struct SwarmCheckpointLayout
+{
+    size_t      SpeciesEnds;                // uint64_t per species: the end of the range of its boids
+    size_t      Parameters;                 // ParameterCount floats per species
+    size_t      Interactions;               // a SpeciesInteraction byte per pair of species, row by row
+    size_t      Predators;                  // an XMFLOAT3 per predator
+    size_t      RandomState;                // the state of the random sequence as text
+    size_t      Ids;                        // uint32_t per boid
+    size_t      Positions[3];               // a float or uint16_t per boid for each axis
+    size_t      Velocities[3];              // a float per boid for each axis
+    size_t      Size;
+};
+
+// A read-only view of a checkpoint of a swarm, made by Swarm::SaveCheckpoint. The header is followed by the
+// sections of SwarmCheckpointLayout. Each section starts on a cache line, so the boid arrays of a checkpoint mapped
+// from a file (see MappedFile) are read in place, without parsing or copying. Checkpoints are little-endian; the
+// version changes whenever the layout does.
+class SwarmCheckpoint
+{
+public:
+    static const uint32_t MAGIC = 0x44494f42; // "BOID"
+    static const uint32_t VERSION = 1;
+    static const size_t SECTION_ALIGNMENT = 64;
+
+    static const uint32_t VISUAL_RANGE_FLAG = 1;
+    static const uint32_t TOPOLOGICAL_FLAG = 2;
+
+    // Checks the header and that the sections lie within the data. Returns false if the data is not a checkpoint
+    // of this version. The view refers to the data, which must outlive it.
+    bool Open(std::span<std::byte const> data);
+
+    // Sets the size of the checkpoint described by the header and returns the offsets of its sections.
+    static SwarmCheckpointLayout ComputeLayout(SwarmCheckpointHeader& header);
+
+    // Chooses the origin and step of the quantization of the positions along one axis, so that the positions
+    // span the range of 16 bits.
+    static void GetQuantization(std::span<float const> positions, float& min, float& scale);
+
+    static uint16_t Quantize(float position, float min, float scale);
+
+    // Accessors
+    SwarmCheckpointHeader const& GetHeader() const { return *m_header; }
+    CheckpointPositionFormat GetPositionFormat() const { return static_cast<CheckpointPositionFormat>(m_header->PositionFormat); }
+    size_t GetBoidCount() const { return static_cast<size_t>(m_header->BoidCount); }
+    std::span<uint64_t const> GetSpeciesEnds() const { return GetSection<uint64_t>(m_layout.SpeciesEnds, m_header->SpeciesCount); }
+    std::span<float const> GetParameters(int species) const;
+    std::span<uint8_t const> GetInteractions() const;
+    std::span<DirectX::XMFLOAT3 const> GetPredators() const { return GetSection<DirectX::XMFLOAT3>(m_layout.Predators, m_header->PredatorCount); }
+    std::string_view GetRandomState() const;
+    std::span<uint32_t const> GetIds() const { return GetSection<uint32_t>(m_layout.Ids, GetBoidCount()); }
+    std::span<float const> GetPositions(int axis) const; // empty if the positions are quantized
+    std::span<uint16_t const> GetQuantizedPositions(int axis) const; // empty unless the positions are quantized
+    std::span<float const> GetVelocities(int axis) const { return GetSection<float>(m_layout.Velocities[axis], GetBoidCount()); }
+
+    // Writes the positions along an axis to the target, which holds GetBoidCount() floats, restoring
+    // quantized positions to the nearest step.
+    void ReadPositions(int axis, std::span<float> target) const;
+
+private:
+    std::span<std::byte const>  m_data;
+    SwarmCheckpointHeader const*  m_header = nullptr;
+    SwarmCheckpointLayout         m_layout{};
+
+    template<typename T>
+    std::span<T const> GetSection(size_t offset, size_t count) const
+    {
+        return { reinterpret_cast<T const*>(m_data.data() + offset), count };
+    }
+};
@@ -0,0 +1,228 @@
+#include "pch.h"
+#include "SwarmProfiler.h"
+
+#include <bit>
+
+namespace
+{
+    const char* PHASE_NAMES[] = {
+        "apply changes",
+        "sort",
+        "build grid",
+        "build tree",
+        "compute totals",
+        "update boids",
+        "neighbor search",
+        "cohesion",
+        "separation",
+        "alignment",
+        "bounds",
+        "obstacles",
+        "predators",
+        "integration",
+    };
+
+    static_assert(std::size(PHASE_NAMES) == SwarmProfile::PHASE_COUNT, "Name every phase.");
+
+    bool IsPerBoid(SwarmPhase phase)
+    {
+        return phase > SwarmPhase::UpdateBoids;
+    }
+
+    double GetMicroseconds(SwarmProfiler::Clock::duration duration)
+    {
+        return std::chrono::duration<double, std::micro>(duration).count();
+    }
+}
+
+char const* SwarmProfile::GetPhaseName(SwarmPhase phase)
+{
+    return PHASE_NAMES[static_cast<int>(phase)];
+}
+
+int SwarmProfile::GetHistogramBin(size_t count)
+{
+    return std::min(static_cast<int>(std::bit_width(count)), HISTOGRAM_BIN_COUNT - 1);
+}
+
+SwarmProfiler::BoidTimer::BoidTimer(ThreadStats& stats, size_t boidIndex) :
+    m_stats(boidIndex % BOID_SAMPLE_INTERVAL == 0 ? &stats : nullptr)
+{
+    if (m_stats)
+    {
+        ++m_stats->SampledBoidCount;
+        m_last = Clock::now();
+    }
+}
+
+void SwarmProfiler::BoidTimer::Mark(SwarmPhase phase)
+{
+    if (!m_stats)
+        return;
+
+    auto now = Clock::now();
+    m_stats->Seconds[static_cast<int>(phase)] += std::chrono::duration<double>(now - m_last).count();
+    m_last = now;
+}
+
+SwarmProfiler::SwarmProfiler() :
+    m_isTraceEnabled(false)
+{
+}
+
+void SwarmProfiler::BeginStep(unsigned threadCount)
+{
+    m_threadStats.resize(threadCount);
+    for (auto& stats : m_threadStats)
+    {
+        stats.Seconds.fill(0.0);
+        stats.CandidateCounts.fill(0);
+        stats.RangeCounts.fill(0);
+        stats.SampledBoidCount = 0;
+        stats.Events.clear();
+    }
+}
+
+void SwarmProfiler::EndStep(size_t boidCount)
+{
+    // Add up the threads. The per-boid sections were timed for the sampled boids only.
+    std::array<double, SwarmProfile::PHASE_COUNT> seconds{};
+    uint64_t sampledBoidCount = 0;
+
+    for (auto const& stats : m_threadStats)
+    {
+        for (int p = 0; p < SwarmProfile::PHASE_COUNT; ++p)
+            seconds[p] += stats.Seconds[p];
+
+        sampledBoidCount += stats.SampledBoidCount;
+    }
+
+    double scale = sampledBoidCount > 0 ? static_cast<double>(boidCount) / sampledBoidCount : 0.0;
+    for (int p = 0; p < SwarmProfile::PHASE_COUNT; ++p)
+    {
+        if (IsPerBoid(static_cast<SwarmPhase>(p)))
+            seconds[p] *= scale;
+    }
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    ++m_profile.StepCount;
+    m_profile.BoidStepCount += boidCount;
+    m_profile.LastStepSeconds = seconds;
+
+    for (int p = 0; p < SwarmProfile::PHASE_COUNT; ++p)
+        m_profile.Seconds[p] += seconds[p];
+
+    for (auto const& stats : m_threadStats)
+    {
+        for (int b = 0; b < SwarmProfile::HISTOGRAM_BIN_COUNT; ++b)
+        {
+            m_profile.CandidateCounts[b] += stats.CandidateCounts[b];
+            m_profile.RangeCounts[b] += stats.RangeCounts[b];
+        }
+    }
+
+    if (!m_isTraceEnabled)
+        return;
+
+    for (auto const& stats : m_threadStats)
+    {
+        size_t count = std::min(stats.Events.size(), MAX_TRACE_EVENT_COUNT - m_trace.size());
+        m_trace.insert(m_trace.end(), stats.Events.begin(), stats.Events.begin() + count);
+    }
+
+    if (m_trace.size() < MAX_TRACE_EVENT_COUNT)
+        m_traceCounters.push_back({ Clock::now(), seconds });
+}
+
+void SwarmProfiler::AddPhase(SwarmPhase phase, Clock::time_point start, Clock::time_point end)
+{
+    // The phases run on the thread that calls Update, which is participant 0 of the pool.
+    auto& stats = m_threadStats[0];
+    stats.Seconds[static_cast<int>(phase)] += std::chrono::duration<double>(end - start).count();
+
+    if (m_isTraceEnabled)
+        stats.Events.push_back({ phase, 0, start, end });
+}
+
+void SwarmProfiler::AddTask(unsigned thread, Clock::time_point start, Clock::time_point end)
+{
+    if (m_isTraceEnabled)
+        m_threadStats[thread].Events.push_back({ SwarmPhase::UpdateBoids, thread, start, end });
+}
+
+void SwarmProfiler::AddNeighborCounts(unsigned thread, size_t candidateCount, size_t rangeCount)
+{
+    auto& stats = m_threadStats[thread];
+    ++stats.CandidateCounts[SwarmProfile::GetHistogramBin(candidateCount)];
+    ++stats.RangeCounts[SwarmProfile::GetHistogramBin(rangeCount)];
+}
+
+SwarmProfile SwarmProfiler::GetProfile() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_profile;
+}
+
+void SwarmProfiler::Reset()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_profile = SwarmProfile();
+    m_trace.clear();
+    m_traceCounters.clear();
+    m_traceStart = Clock::now();
+}
+
+void SwarmProfiler::IsTraceEnabled(bool enabled)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (enabled && !m_isTraceEnabled)
+    {
+        m_trace.clear();
+        m_traceCounters.clear();
+        m_traceStart = Clock::now();
+    }
+
+    m_isTraceEnabled = enabled;
+}
+
+// Writes the trace in the Trace Event Format: a complete event for each phase and task, and a counter event
+// per step with the estimated time of the per-boid sections, all in microseconds.
+void SwarmProfiler::WriteChromeTrace(std::ostream& stream) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    stream << "{\"traceEvents\":[\n";
+    bool isFirst = true;
+
+    for (auto const& event : m_trace)
+    {
+        stream << (isFirst ? "" : ",\n")
+            << "{\"name\":\"" << SwarmProfile::GetPhaseName(event.Phase) << "\",\"cat\":\"swarm\",\"ph\":\"X\""
+            << ",\"ts\":" << GetMicroseconds(event.Start - m_traceStart)
+            << ",\"dur\":" << GetMicroseconds(event.End - event.Start)
+            << ",\"pid\":1,\"tid\":" << event.Thread << "}";
+        isFirst = false;
+    }
+
+    for (auto const& counters : m_traceCounters)
+    {
+        stream << (isFirst ? "" : ",\n")
+            << "{\"name\":\"per-boid sections (us)\",\"cat\":\"swarm\",\"ph\":\"C\""
+            << ",\"ts\":" << GetMicroseconds(counters.Time - m_traceStart)
+            << ",\"pid\":1,\"args\":{";
+
+        for (int p = static_cast<int>(SwarmPhase::UpdateBoids) + 1; p < SwarmProfile::PHASE_COUNT; ++p)
+        {
+            stream << (p > static_cast<int>(SwarmPhase::UpdateBoids) + 1 ? "," : "")
+                << "\"" << SwarmProfile::GetPhaseName(static_cast<SwarmPhase>(p)) << "\":" << counters.Seconds[p] * 1e6;
+        }
+
+        stream << "}}";
+        isFirst = false;
+    }
+
+    stream << "\n]}\n";
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+// The parts of Swarm::Update that the profiler times. The phases up to UpdateBoids run once per step and are
+// timed as wall-clock time. The sections after it run once per boid inside UpdateBoids; their time is the
+// CPU time summed over all threads of the pool.
+enum class SwarmPhase
+{
+    ApplyChanges,
+    Sort,
+    BuildGrid,
+    BuildTree,
+    ComputeTotals,
+    UpdateBoids,
+    NeighborSearch,
+    Cohesion,           // rule 1
+    Separation,         // rule 2
+    Alignment,          // rule 3
+    Bounds,             // rule 4
+    Obstacles,          // rule 5
+    Predators,          // rule 6
+    Integration,
+    Count               // the number of phases
+};
+
+// Statistics gathered by the profiler since it was last reset.
+struct SwarmProfile
+{
+    static const int PHASE_COUNT = static_cast<int>(SwarmPhase::Count);
+
+    // Bin 0 counts boids with no neighbours, bin b boids with [2^(b-1), 2^b) neighbours. The last bin also
+    // counts all boids with more.
+    static const int HISTOGRAM_BIN_COUNT = 16;
+    using Histogram = std::array<uint64_t, HISTOGRAM_BIN_COUNT>;
+
+    uint64_t                            StepCount = 0;
+    uint64_t                            BoidStepCount = 0;
+    std::array<double, PHASE_COUNT>     Seconds{};          // the total time of each phase
+    std::array<double, PHASE_COUNT>     LastStepSeconds{};  // the time of each phase in the last step
+    Histogram                           CandidateCounts{};  // boids by the number of candidates found in the grid
+    Histogram                           RangeCounts{};      // boids by the number of neighbours they align with
+
+    static char const* GetPhaseName(SwarmPhase phase);
+    static int GetHistogramBin(size_t count);
+};
+
+// Times the phases of Swarm::Update and counts the neighbours of the boids. The phases that run once per step
+// are timed exactly. Timing every boid would cost more than the rules themselves, so the per-boid sections
+// are timed for one boid in BOID_SAMPLE_INTERVAL and scaled up to all boids.
+//
+// The profiler is only used when the simulation is compiled with SWARM_PROFILING; otherwise the
+// SWARM_PROFILE macros compile to nothing and the profile stays empty.
+class SwarmProfiler
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static const size_t BOID_SAMPLE_INTERVAL = 16;
+
+    // The most events a trace holds; later events are dropped.
+    static const size_t MAX_TRACE_EVENT_COUNT = 1 << 20;
+
+    struct TraceEvent
+    {
+        SwarmPhase          Phase;
+        unsigned            Thread;
+        Clock::time_point   Start;
+        Clock::time_point   End;
+    };
+
+    // The statistics of one thread during one step. Only that thread writes to them, so no locking is needed.
+    struct ThreadStats
+    {
+        std::array<double, SwarmProfile::PHASE_COUNT>   Seconds{};
+        SwarmProfile::Histogram                         CandidateCounts{};
+        SwarmProfile::Histogram                         RangeCounts{};
+        uint64_t                                        SampledBoidCount = 0;
+        std::vector<TraceEvent>                         Events;
+    };
+
+    // Measures the lifetime of a scope as one phase.
+    class PhaseTimer
+    {
+    public:
+        PhaseTimer(SwarmProfiler& profiler, SwarmPhase phase) : m_profiler(profiler), m_phase(phase), m_start(Clock::now()) {}
+        ~PhaseTimer() { m_profiler.AddPhase(m_phase, m_start, Clock::now()); }
+
+    private:
+        SwarmProfiler&      m_profiler;
+        SwarmPhase          m_phase;
+        Clock::time_point   m_start;
+    };
+
+    // Measures the lifetime of a scope as a task run by a thread of the pool. Tasks only appear in the trace.
+    class TaskTimer
+    {
+    public:
+        TaskTimer(SwarmProfiler& profiler, unsigned thread) : m_profiler(profiler), m_thread(thread), m_start(Clock::now()) {}
+        ~TaskTimer() { m_profiler.AddTask(m_thread, m_start, Clock::now()); }
+
+    private:
+        SwarmProfiler&      m_profiler;
+        unsigned            m_thread;
+        Clock::time_point   m_start;
+    };
+
+    // Measures the per-boid sections of one boid, if it is sampled. Mark ends the section that started
+    // at the previous mark.
+    class BoidTimer
+    {
+    public:
+        BoidTimer(ThreadStats& stats, size_t boidIndex);
+        void Mark(SwarmPhase phase);
+
+    private:
+        ThreadStats*        m_stats;    // null if the boid is not sampled
+        Clock::time_point   m_last;
+    };
+
+    SwarmProfiler();
+
+    // Called by Swarm::Update around each step.
+    void BeginStep(unsigned threadCount);
+    void EndStep(size_t boidCount);
+
+    void AddPhase(SwarmPhase phase, Clock::time_point start, Clock::time_point end);
+    void AddTask(unsigned thread, Clock::time_point start, Clock::time_point end);
+    void AddNeighborCounts(unsigned thread, size_t candidateCount, size_t rangeCount);
+    ThreadStats& GetThreadStats(unsigned thread) { return m_threadStats[thread]; }
+
+    // Can be called from any thread.
+    SwarmProfile GetProfile() const;
+    void Reset();
+
+    // Records the phases and the tasks of every thread for a Chrome trace (chrome://tracing or Perfetto).
+    bool IsTraceEnabled() const { return m_isTraceEnabled; }
+    void IsTraceEnabled(bool enabled);
+    void WriteChromeTrace(std::ostream& stream) const;
+
+private:
+    // The estimated time of the per-boid sections in one step, shown as counters in the trace.
+    struct TraceCounters
+    {
+        Clock::time_point                               Time;
+        std::array<double, SwarmProfile::PHASE_COUNT>   Seconds;
+    };
+
+    mutable std::mutex          m_mutex;        // guards the profile and the trace; the thread stats belong to the step
+    SwarmProfile                m_profile;
+    std::vector<TraceEvent>     m_trace;
+    std::vector<TraceCounters>  m_traceCounters;
+    std::atomic<bool>           m_isTraceEnabled;
+    Clock::time_point           m_traceStart;
+    std::vector<ThreadStats>    m_threadStats;
+};
+
+#if defined(SWARM_PROFILING)
+#define SWARM_PROFILE_BEGIN_STEP(profiler, threadCount) (profiler).BeginStep(threadCount)
+#define SWARM_PROFILE_END_STEP(profiler, boidCount) (profiler).EndStep(boidCount)
+#define SWARM_PROFILE_PHASE(profiler, phase) SwarmProfiler::PhaseTimer phaseTimer(profiler, phase)
+#define SWARM_PROFILE_TASK(profiler, thread) SwarmProfiler::TaskTimer taskTimer(profiler, thread)
+#define SWARM_PROFILE_BOID(profiler, thread, boidIndex) SwarmProfiler::BoidTimer boidTimer((profiler).GetThreadStats(thread), boidIndex)
+#define SWARM_PROFILE_MARK(phase) boidTimer.Mark(phase)
+#define SWARM_PROFILE_NEIGHBORS(profiler, thread, candidateCount, rangeCount) (profiler).AddNeighborCounts(thread, candidateCount, rangeCount)
+#else
+#define SWARM_PROFILE_BEGIN_STEP(profiler, threadCount)
+#define SWARM_PROFILE_END_STEP(profiler, boidCount)
+#define SWARM_PROFILE_PHASE(profiler, phase)
+#define SWARM_PROFILE_TASK(profiler, thread)
+#define SWARM_PROFILE_BOID(profiler, thread, boidIndex)
+#define SWARM_PROFILE_MARK(phase)
+#define SWARM_PROFILE_NEIGHBORS(profiler, thread, candidateCount, rangeCount)
+#endif
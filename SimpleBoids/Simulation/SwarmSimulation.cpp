@@ -0,0 +1,128 @@
+#include "pch.h"
+#include "SwarmSimulation.h"
+
+using namespace DirectX;
+
+SwarmSimulation::SwarmSimulation(Swarm& swarm, double stepSeconds) :
+    m_swarm(swarm),
+    m_stepSeconds(static_cast<float>(stepSeconds)),
+    m_stepDuration(std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(stepSeconds))),
+    m_stepIndex(0),
+    m_isRunning(false)
+{
+}
+
+SwarmSimulation::~SwarmSimulation()
+{
+    Stop();
+}
+
+void SwarmSimulation::Start()
+{
+    if (m_isRunning.exchange(true))
+        return;
+
+    m_thread = std::thread(&SwarmSimulation::Run, this);
+}
+
+void SwarmSimulation::Stop()
+{
+    if (!m_isRunning.exchange(false))
+        return;
+
+    m_thread.join();
+}
+
+void SwarmSimulation::Invoke(std::function<void(Swarm&)> const& action)
+{
+    std::lock_guard<std::mutex> lock(m_stepMutex);
+    action(m_swarm);
+}
+
+void SwarmSimulation::SetStepCallback(StepCallback callback)
+{
+    std::lock_guard<std::mutex> lock(m_stepMutex);
+    m_stepCallback = std::move(callback);
+}
+
+size_t SwarmSimulation::WriteInstanceTransforms(std::vector<DirectX::XMFLOAT4X4>& transforms)
+{
+    m_snapshots.Update();
+    auto const& snapshot = m_snapshots.GetReadBuffer();
+
+    // Show the step gradually over the time until the next snapshot is due. This draws the swarm up to a
+    // step behind the simulation, but the motion stays smooth at any frame rate.
+    float elapsed = std::chrono::duration<float>(std::chrono::steady_clock::now() - snapshot.PublishTime).count();
+    float alpha = std::clamp(elapsed / m_stepSeconds, 0.f, 1.f);
+
+    auto const& previous = snapshot.Previous;
+    auto const& current = snapshot.Current;
+    transforms.resize(current.Size());
+
+    // Usually the step kept every boid in its place. When it added, removed or sorted boids, look up where
+    // each boid was before the step by its ID.
+    bool isSameOrder = (snapshot.PreviousIds == snapshot.CurrentIds);
+    if (!isSameOrder)
+    {
+        uint32_t idCount = 0;
+        for (uint32_t id : snapshot.PreviousIds)
+            idCount = std::max(idCount, id + 1);
+
+        m_previousIndices.assign(idCount, UINT32_MAX);
+        for (uint32_t i = 0; i < snapshot.PreviousIds.size(); ++i)
+            m_previousIndices[snapshot.PreviousIds[i]] = i;
+    }
+
+    for (size_t i = 0; i < current.Size(); ++i)
+    {
+        size_t previousIndex = i;
+        if (!isSameOrder)
+        {
+            uint32_t id = snapshot.CurrentIds[i];
+            previousIndex = (id < m_previousIndices.size()) ? m_previousIndices[id] : UINT32_MAX;
+        }
+
+        // Boids added by the step have no previous position.
+        XMVECTOR position = current.GetPosition(i);
+        if (previousIndex < previous.Size())
+            position = XMVectorLerp(previous.GetPosition(previousIndex), position, alpha);
+
+        XMStoreFloat4x4(&transforms[i], Boid::ComputeWorldMatrix(position, current.GetVelocity(i)));
+    }
+
+    return current.Size();
+}
+
+void SwarmSimulation::Run()
+{
+    auto nextStepTime = std::chrono::steady_clock::now();
+
+    while (m_isRunning)
+    {
+        std::this_thread::sleep_until(nextStepTime);
+        Step();
+
+        // When a step takes longer than the step time, continue from now instead of running the missed steps
+        // back to back, which would only make the simulation fall further behind.
+        nextStepTime = std::max(nextStepTime + m_stepDuration, std::chrono::steady_clock::now());
+    }
+}
+
+void SwarmSimulation::Step()
+{
+    std::lock_guard<std::mutex> lock(m_stepMutex);
+
+    auto& snapshot = m_snapshots.GetWriteBuffer();
+    m_swarm.CopyState(snapshot.Previous, snapshot.PreviousIds);
+
+    m_swarm.Update(m_stepSeconds);
+    ++m_stepIndex;
+
+    if (m_stepCallback)
+        m_stepCallback(m_swarm, m_stepIndex);
+
+    m_swarm.CopyState(snapshot.Current, snapshot.CurrentIds);
+    snapshot.StepIndex = m_stepIndex;
+    snapshot.PublishTime = std::chrono::steady_clock::now();
+    m_snapshots.Publish();
+}
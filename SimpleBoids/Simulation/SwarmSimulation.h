@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+#include "Swarm.h"
+#include "TripleBuffer.h"
+
+// The boid state published by the simulation thread after a step. Renderers interpolate between the
+// state before the step and the state after it, matching the boids by their IDs.
+struct SwarmSnapshot
+{
+    BoidStore                               Previous{ 0.f };
+    BoidStore                               Current{ 0.f };
+    std::vector<uint32_t>                   PreviousIds;
+    std::vector<uint32_t>                   CurrentIds;
+    uint64_t                                StepIndex = 0;
+    std::chrono::steady_clock::time_point   PublishTime;
+};
+
+// Steps a swarm at a fixed rate on a dedicated thread. After every step, it publishes a snapshot through
+// a lock-free triple buffer, so the render thread never waits for a step and a slow step never blocks a frame.
+class SwarmSimulation
+{
+public:
+    using StepCallback = std::function<void(Swarm& swarm, uint64_t stepIndex)>;
+
+    SwarmSimulation(Swarm& swarm, double stepSeconds);
+    ~SwarmSimulation();
+
+    SwarmSimulation(SwarmSimulation const&) = delete;
+    SwarmSimulation& operator=(SwarmSimulation const&) = delete;
+
+    // Starts or stops the simulation thread. Stopping pauses the simulation and Start resumes it.
+    void Start();
+    void Stop();
+
+    // Runs the action on the swarm between two steps, so a step never sees the action half done.
+    void Invoke(std::function<void(Swarm&)> const& action);
+
+    // Sets a function the simulation thread calls after every step, between two steps like Invoke.
+    void SetStepCallback(StepCallback callback);
+
+    // Called by the render thread only. Takes the latest snapshot and writes the world matrices of its boids,
+    // interpolated by the time that has passed since the snapshot was published. Returns the number of matrices.
+    size_t WriteInstanceTransforms(std::vector<DirectX::XMFLOAT4X4>& transforms);
+
+private:
+    Swarm&                                  m_swarm;
+    float                                   m_stepSeconds;
+    std::chrono::steady_clock::duration     m_stepDuration;
+    std::mutex                              m_stepMutex;        // held during a step and during Invoke
+    StepCallback                            m_stepCallback;
+    TripleBuffer<SwarmSnapshot>             m_snapshots;
+    uint64_t                                m_stepIndex;
+    std::thread                             m_thread;
+    std::atomic<bool>                       m_isRunning;
+    std::vector<uint32_t>                   m_previousIndices;  // the previous index of each boid by ID; used by the render thread
+
+    void Run();
+    void Step();
+};
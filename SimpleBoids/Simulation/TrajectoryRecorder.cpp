@@ -0,0 +1,528 @@
+#include "pch.h"
+#include "TrajectoryRecorder.h"
+
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+    // Set in a frame that lists the IDs of its boids, because they differ from those of the frame before.
+    const uint8_t IDS_FLAG = 1;
+
+    const uint32_t NO_INDEX = UINT32_MAX;
+
+    using QuantizedComponents = std::array<std::vector<int32_t>, 3>;
+
+    int32_t Quantize(float value, float scale)
+    {
+        double step = std::nearbyint(static_cast<double>(value) * scale);
+        return static_cast<int32_t>(std::clamp(step, double{ INT32_MIN }, double{ INT32_MAX }));
+    }
+
+    // Maps small negative and positive differences alike to small unsigned numbers.
+    uint64_t ZigZag(int64_t value)
+    {
+        return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+    }
+
+    int64_t UnZigZag(uint64_t value)
+    {
+        return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+    }
+
+    // Appends seven bits at a time, low bits first, with the top bit set on all bytes but the last.
+    void AppendVarint(std::vector<uint8_t>& buffer, uint64_t value)
+    {
+        while (value >= 0x80)
+        {
+            buffer.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        buffer.push_back(static_cast<uint8_t>(value));
+    }
+
+    template<typename T>
+    void Append(std::vector<uint8_t>& buffer, T value)
+    {
+        size_t offset = buffer.size();
+        buffer.resize(offset + sizeof(T));
+        std::memcpy(buffer.data() + offset, &value, sizeof(T));
+    }
+
+    // Reads the values appended to a buffer, failing rather than reading past its end.
+    class ByteReader
+    {
+    public:
+        explicit ByteReader(std::vector<uint8_t> const& buffer) : m_buffer(buffer), m_offset(0) {}
+
+        template<typename T>
+        bool Read(T& value)
+        {
+            if (m_buffer.size() - m_offset < sizeof(T))
+                return false;
+
+            std::memcpy(&value, m_buffer.data() + m_offset, sizeof(T));
+            m_offset += sizeof(T);
+            return true;
+        }
+
+        bool ReadVarint(uint64_t& value)
+        {
+            value = 0;
+            for (int shift = 0; shift < 64 && m_offset < m_buffer.size(); shift += 7)
+            {
+                uint8_t byte = m_buffer[m_offset++];
+                value |= static_cast<uint64_t>(byte & 0x7f) << shift;
+                if ((byte & 0x80) == 0)
+                    return true;
+            }
+
+            return false;
+        }
+
+        bool ReadDifference(int64_t& value)
+        {
+            uint64_t zigZag;
+            if (!ReadVarint(zigZag))
+                return false;
+
+            value = UnZigZag(zigZag);
+            return true;
+        }
+
+    private:
+        std::vector<uint8_t> const& m_buffer;
+        size_t m_offset;
+    };
+}
+
+// The recorder and the reader keep the same history, so they make the same predictions.
+class TrajectoryHistory
+{
+public:
+    std::vector<uint32_t> const& GetIds() const { return m_ids; }
+
+    // Finds the boids of the next frame in the last one by their IDs. Returns true if they are not in the
+    // same order, so the frame has to list its IDs.
+    bool Match(std::span<uint32_t const> ids)
+    {
+        m_isSameOrder = std::equal(ids.begin(), ids.end(), m_ids.begin(), m_ids.end());
+        if (m_isSameOrder)
+            return false;
+
+        uint32_t idCount = 0;
+        for (uint32_t id : m_ids)
+            idCount = std::max(idCount, id + 1);
+
+        m_lastIndices.assign(idCount, NO_INDEX);
+        for (uint32_t i = 0; i < m_ids.size(); ++i)
+            m_lastIndices[m_ids[i]] = i;
+
+        m_matches.resize(ids.size());
+        for (size_t i = 0; i < ids.size(); ++i)
+            m_matches[i] = ids[i] < idCount ? m_lastIndices[ids[i]] : NO_INDEX;
+
+        return true;
+    }
+
+    // Boids new to the frame are predicted to be at rest at the origin.
+    int64_t PredictPosition(int axis, size_t index) const
+    {
+        uint32_t last = GetLastIndex(index);
+        if (last == NO_INDEX)
+            return 0;
+
+        int64_t position = m_positions[axis][last];
+        return m_depths[last] >= 2 ? 2 * position - m_previousPositions[axis][last] : position;
+    }
+
+    int64_t PredictVelocity(int axis, size_t index) const
+    {
+        uint32_t last = GetLastIndex(index);
+        return last == NO_INDEX ? 0 : m_velocities[axis][last];
+    }
+
+    // Makes the frame the last frame. Takes the quantized components and hands back spare arrays in their place.
+    void Commit(std::span<uint32_t const> ids, QuantizedComponents& positions, QuantizedComponents& velocities)
+    {
+        size_t count = ids.size();
+
+        std::vector<uint8_t> depths(count);
+        for (size_t i = 0; i < count; ++i)
+            depths[i] = GetLastIndex(i) == NO_INDEX ? 1 : 2;
+
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            std::vector<int32_t> previous(count);
+            for (size_t i = 0; i < count; ++i)
+            {
+                uint32_t last = GetLastIndex(i);
+                previous[i] = last == NO_INDEX ? 0 : m_positions[axis][last];
+            }
+
+            m_previousPositions[axis].swap(previous);
+            m_positions[axis].swap(positions[axis]);
+            m_velocities[axis].swap(velocities[axis]);
+        }
+
+        m_depths.swap(depths);
+        m_ids.assign(ids.begin(), ids.end());
+    }
+
+private:
+    std::vector<uint32_t>   m_ids;
+    QuantizedComponents     m_positions;
+    QuantizedComponents     m_previousPositions;    // in the order of the last frame
+    QuantizedComponents     m_velocities;
+    std::vector<uint8_t>    m_depths;               // the number of frames each boid of the last frame appears in, up to two
+    bool                    m_isSameOrder = true;
+    std::vector<uint32_t>   m_matches;              // the index in the last frame of each boid of the next, unless in the same order
+    std::vector<uint32_t>   m_lastIndices;          // the index in the last frame by ID
+
+    uint32_t GetLastIndex(size_t index) const
+    {
+        if (m_isSameOrder)
+            return static_cast<uint32_t>(index);
+
+        return m_matches[index];
+    }
+};
+
+TrajectoryRecorder::TrajectoryRecorder() :
+    m_frameCount(0),
+    m_isClosing(false)
+{
+}
+
+TrajectoryRecorder::~TrajectoryRecorder()
+{
+    Close();
+}
+
+bool TrajectoryRecorder::Open(std::filesystem::path const& path, TrajectoryRecorderOptions const& options)
+{
+    Close();
+
+    m_file.open(path, std::ios::binary | std::ios::trunc);
+    if (!m_file)
+        return false;
+
+    m_options = options;
+    m_history = std::make_unique<TrajectoryHistory>();
+    m_stats = {};
+    m_isClosing = false;
+
+    std::vector<uint8_t> header;
+    Append(header, MAGIC);
+    Append(header, VERSION);
+    Append(header, m_options.PositionPrecision);
+    Append(header, m_options.VelocityPrecision);
+    if (!m_file.write(reinterpret_cast<char const*>(header.data()), header.size()))
+    {
+        m_file.close();
+        return false;
+    }
+
+    m_stats.WrittenBytes = header.size();
+
+    m_writer = std::thread(&TrajectoryRecorder::Write, this);
+    return true;
+}
+
+void TrajectoryRecorder::Close()
+{
+    if (!m_writer.joinable())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_isClosing = true;
+    }
+
+    m_frameReady.notify_one();
+    m_writer.join();
+
+    // Closing flushes the buffered end of the file, which can fail too.
+    auto start = std::chrono::steady_clock::now();
+    m_file.close();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stats.WriteSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    m_stats.IsWriteFailed = m_stats.IsWriteFailed || m_file.fail();
+    m_queue.clear();
+    m_freeFrames.clear();
+    m_frameCount = 0;
+}
+
+bool TrajectoryRecorder::Record(Swarm& swarm, uint64_t stepIndex)
+{
+    std::unique_ptr<Frame> frame;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        if (!m_writer.joinable() || m_isClosing || m_stats.IsWriteFailed)
+            return false;
+
+        size_t frameBytes = std::max<size_t>(swarm.Size() * BYTES_PER_BOID, 1);
+        size_t maxFrameCount = std::max<size_t>(m_options.MemoryBudget / frameBytes, 2);
+
+        // The swarm may have grown since the spare frames were allocated.
+        while (m_frameCount > maxFrameCount && !m_freeFrames.empty())
+        {
+            m_freeFrames.pop_back();
+            --m_frameCount;
+        }
+
+        if (m_frameCount - m_freeFrames.size() >= maxFrameCount)
+        {
+            ++m_stats.DroppedFrameCount;
+            return false;
+        }
+
+        if (!m_freeFrames.empty())
+        {
+            frame = std::move(m_freeFrames.back());
+            m_freeFrames.pop_back();
+        }
+        else
+        {
+            frame = std::make_unique<Frame>();
+            ++m_frameCount;
+        }
+    }
+
+    swarm.CopyState(frame->Boids, frame->Ids);
+    frame->StepIndex = stepIndex;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.push_back(std::move(frame));
+    }
+
+    m_frameReady.notify_one();
+    return true;
+}
+
+TrajectoryRecorderStats TrajectoryRecorder::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_stats;
+}
+
+void TrajectoryRecorder::Write()
+{
+    while (true)
+    {
+        std::unique_ptr<Frame> frame;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_frameReady.wait(lock, [this]() { return !m_queue.empty() || m_isClosing; });
+
+            // Closing writes the frames recorded before it.
+            if (m_queue.empty())
+                return;
+
+            frame = std::move(m_queue.front());
+            m_queue.pop_front();
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        Encode(*frame);
+
+        auto encoded = std::chrono::steady_clock::now();
+        bool isWritten = static_cast<bool>(m_file.write(reinterpret_cast<char const*>(m_buffer.data()), m_buffer.size()));
+
+        auto written = std::chrono::steady_clock::now();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        // The frames after a failed write could not be decoded, so the writer stops and Record drops the rest.
+        if (!isWritten)
+        {
+            m_stats.IsWriteFailed = true;
+            m_queue.clear();
+            m_freeFrames.clear();
+            m_frameCount = 0;
+            return;
+        }
+
+        ++m_stats.FrameCount;
+        m_stats.BoidFrameCount += frame->Ids.size();
+        m_stats.RawBytes += frame->Ids.size() * BYTES_PER_BOID;
+        m_stats.WrittenBytes += m_buffer.size();
+        m_stats.EncodeSeconds += std::chrono::duration<double>(encoded - start).count();
+        m_stats.WriteSeconds += std::chrono::duration<double>(written - encoded).count();
+        m_freeFrames.push_back(std::move(frame));
+    }
+}
+
+// A frame is its size in bytes, the step index, the boid count, the flags, the IDs if IDS_FLAG is set, and the
+// differences from the predicted quantized components: the positions along each axis, then the velocities.
+// IDs and differences are zigzag-encoded variable-length integers.
+void TrajectoryRecorder::Encode(Frame const& frame)
+{
+    size_t count = frame.Ids.size();
+    bool isReordered = m_history->Match(frame.Ids);
+
+    m_buffer.clear();
+    Append(m_buffer, uint32_t{ 0 });
+    Append(m_buffer, frame.StepIndex);
+    Append(m_buffer, static_cast<uint32_t>(count));
+    Append(m_buffer, isReordered ? IDS_FLAG : uint8_t{ 0 });
+
+    if (isReordered)
+    {
+        int64_t lastId = 0;
+        for (uint32_t id : frame.Ids)
+        {
+            AppendVarint(m_buffer, ZigZag(int64_t{ id } - lastId));
+            lastId = id;
+        }
+    }
+
+    std::span<float const> positions[] = { frame.Boids.GetPositionsX(), frame.Boids.GetPositionsY(), frame.Boids.GetPositionsZ() };
+    std::span<float const> velocities[] = { frame.Boids.GetVelocitiesX(), frame.Boids.GetVelocitiesY(), frame.Boids.GetVelocitiesZ() };
+
+    float positionScale = 1.f / m_options.PositionPrecision;
+    float velocityScale = 1.f / m_options.VelocityPrecision;
+
+    QuantizedComponents quantizedPositions, quantizedVelocities;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        quantizedPositions[axis].resize(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            int32_t position = Quantize(positions[axis][i], positionScale);
+            AppendVarint(m_buffer, ZigZag(position - m_history->PredictPosition(axis, i)));
+            quantizedPositions[axis][i] = position;
+        }
+    }
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        quantizedVelocities[axis].resize(count);
+        for (size_t i = 0; i < count; ++i)
+        {
+            int32_t velocity = Quantize(velocities[axis][i], velocityScale);
+            AppendVarint(m_buffer, ZigZag(velocity - m_history->PredictVelocity(axis, i)));
+            quantizedVelocities[axis][i] = velocity;
+        }
+    }
+
+    m_history->Commit(frame.Ids, quantizedPositions, quantizedVelocities);
+
+    uint32_t size = static_cast<uint32_t>(m_buffer.size() - sizeof(uint32_t));
+    std::memcpy(m_buffer.data(), &size, sizeof(size));
+}
+
+TrajectoryReader::TrajectoryReader() :
+    m_positionPrecision(0.f),
+    m_velocityPrecision(0.f)
+{
+}
+
+TrajectoryReader::~TrajectoryReader() = default;
+
+bool TrajectoryReader::Open(std::filesystem::path const& path)
+{
+    m_file.close();
+    m_file.clear();
+    m_file.open(path, std::ios::binary);
+
+    m_buffer.resize(4 * sizeof(uint32_t));
+    if (!m_file.read(reinterpret_cast<char*>(m_buffer.data()), m_buffer.size()))
+        return false;
+
+    ByteReader reader(m_buffer);
+    uint32_t magic = 0, version = 0;
+    reader.Read(magic);
+    reader.Read(version);
+    reader.Read(m_positionPrecision);
+    reader.Read(m_velocityPrecision);
+
+    m_history = std::make_unique<TrajectoryHistory>();
+    return magic == TrajectoryRecorder::MAGIC && version == TrajectoryRecorder::VERSION;
+}
+
+bool TrajectoryReader::ReadFrame(TrajectoryFrame& frame)
+{
+    uint32_t size = 0;
+    if (!m_history || !m_file.read(reinterpret_cast<char*>(&size), sizeof(size)))
+        return false;
+
+    m_buffer.resize(size);
+    if (!m_file.read(reinterpret_cast<char*>(m_buffer.data()), size))
+        return false;
+
+    ByteReader reader(m_buffer);
+    uint64_t stepIndex = 0;
+    uint32_t count = 0;
+    uint8_t flags = 0;
+    if (!reader.Read(stepIndex) || !reader.Read(count) || !reader.Read(flags) || count > size)
+        return false;
+
+    if (flags & IDS_FLAG)
+    {
+        frame.Ids.resize(count);
+
+        int64_t id = 0;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            int64_t difference;
+            if (!reader.ReadDifference(difference))
+                return false;
+
+            id += difference;
+            frame.Ids[i] = static_cast<uint32_t>(id);
+        }
+    }
+    else
+    {
+        frame.Ids = m_history->GetIds();
+        if (frame.Ids.size() != count)
+            return false;
+    }
+
+    m_history->Match(frame.Ids);
+    frame.Boids.Resize(count);
+    frame.StepIndex = stepIndex;
+
+    std::span<float> positions[] = { frame.Boids.GetPositionsX(), frame.Boids.GetPositionsY(), frame.Boids.GetPositionsZ() };
+    std::span<float> velocities[] = { frame.Boids.GetVelocitiesX(), frame.Boids.GetVelocitiesY(), frame.Boids.GetVelocitiesZ() };
+
+    QuantizedComponents quantizedPositions, quantizedVelocities;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        quantizedPositions[axis].resize(count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            int64_t difference;
+            if (!reader.ReadDifference(difference))
+                return false;
+
+            auto position = static_cast<int32_t>(m_history->PredictPosition(axis, i) + difference);
+            positions[axis][i] = position * m_positionPrecision;
+            quantizedPositions[axis][i] = position;
+        }
+    }
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        quantizedVelocities[axis].resize(count);
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            int64_t difference;
+            if (!reader.ReadDifference(difference))
+                return false;
+
+            auto velocity = static_cast<int32_t>(m_history->PredictVelocity(axis, i) + difference);
+            velocities[axis][i] = velocity * m_velocityPrecision;
+            quantizedVelocities[axis][i] = velocity;
+        }
+    }
+
+    m_history->Commit(frame.Ids, quantizedPositions, quantizedVelocities);
+    return true;
+}
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "Swarm.h"
+
+// Settings of a TrajectoryRecorder.
+struct TrajectoryRecorderOptions
+{
+    float   PositionPrecision = 1.f / 1024.f;   // the quantization step of the positions
+    float   VelocityPrecision = 1.f / 16384.f;  // the quantization step of the velocities
+    size_t  MemoryBudget = 64 << 20;            // the bytes the frames waiting to be written may take, at least two frames
+};
+
+// Statistics of a TrajectoryRecorder since it was opened.
+struct TrajectoryRecorderStats
+{
+    uint64_t    FrameCount = 0;         // written to the file
+    uint64_t    DroppedFrameCount = 0;  // skipped because the writer had fallen a memory budget behind
+    uint64_t    BoidFrameCount = 0;     // the boids of the written frames
+    uint64_t    RawBytes = 0;           // the size of the written frames as floats and IDs
+    uint64_t    WrittenBytes = 0;
+    double      EncodeSeconds = 0.0;
+    double      WriteSeconds = 0.0;
+    bool        IsWriteFailed = false;  // the file could not be written, so recording stopped and the file is incomplete
+};
+
+// One step of a recorded trajectory, as read back by TrajectoryReader.
+struct TrajectoryFrame
+{
+    uint64_t                StepIndex = 0;
+    BoidStore               Boids{ 0.f };
+    std::vector<uint32_t>   Ids;
+};
+
+// The quantized state of the boids in the last frame, which the next frame is predicted from.
+class TrajectoryHistory;
+
+// Streams the positions and velocities of every boid of a swarm to a file, step by step. Record only copies the
+// state into a free frame; a writer thread compresses the frames and writes them, so recording never holds up
+// Swarm::Update. The frames in flight are limited by the memory budget, so while the simulation fills one
+// frame the writer works through the others. If the writer falls that far behind, frames are dropped and
+// counted rather than waited for. If the file cannot be written, e.g. because the disk is full, recording stops
+// and the stats say so.
+//
+// Frames are compressed by quantizing the components to fixed steps and storing the difference from a
+// prediction made from the same boid, matched by ID, in the frames before: the last velocity, and the position
+// extrapolated from the last two positions. Boids fly smoothly, so the differences are small and mostly fit in
+// a byte or two of a variable-length integer.
+class TrajectoryRecorder
+{
+public:
+    TrajectoryRecorder();
+    ~TrajectoryRecorder();
+
+    TrajectoryRecorder(TrajectoryRecorder const&) = delete;
+    TrajectoryRecorder& operator=(TrajectoryRecorder const&) = delete;
+
+    // Creates the file and starts the writer thread. Returns false if the file cannot be created.
+    bool Open(std::filesystem::path const& path, TrajectoryRecorderOptions const& options = {});
+
+    // Writes the frames recorded so far and closes the file. See the stats for whether all of them were written.
+    void Close();
+
+    // Records the state of the swarm after the given step. Call it between steps, e.g. from the step callback
+    // of a SwarmSimulation. Returns false if the frame was dropped or recording stopped after a failed write.
+    bool Record(Swarm& swarm, uint64_t stepIndex);
+
+    TrajectoryRecorderStats GetStats() const;
+
+    // The file starts with "BTRJ" and the version.
+    static const uint32_t MAGIC = 0x4a525442;
+    static const uint32_t VERSION = 1;
+
+private:
+    // The bytes of a frame in memory per boid: six floats and an ID.
+    static const size_t BYTES_PER_BOID = 6 * sizeof(float) + sizeof(uint32_t);
+
+    struct Frame
+    {
+        uint64_t                StepIndex = 0;
+        BoidStore               Boids{ 0.f };
+        std::vector<uint32_t>   Ids;
+    };
+
+    TrajectoryRecorderOptions               m_options;
+    std::ofstream                           m_file;
+    std::thread                             m_writer;
+    mutable std::mutex                      m_mutex;        // guards the members below
+    std::condition_variable                 m_frameReady;
+    std::deque<std::unique_ptr<Frame>>      m_queue;        // recorded frames in order
+    std::vector<std::unique_ptr<Frame>>     m_freeFrames;
+    size_t                                  m_frameCount;   // including those in the queue and being written
+    bool                                    m_isClosing;
+    TrajectoryRecorderStats                 m_stats;
+    std::unique_ptr<TrajectoryHistory>      m_history;      // used by the writer thread only
+    std::vector<uint8_t>                    m_buffer;       // likewise
+
+    void Write();
+    void Encode(Frame const& frame);
+};
+
+// Reads back the frames of a file written by TrajectoryRecorder, in order.
+class TrajectoryReader
+{
+public:
+    TrajectoryReader();
+    ~TrajectoryReader();
+
+    // Opens the file and reads its header. Returns false if it is not a trajectory of this version.
+    bool Open(std::filesystem::path const& path);
+
+    // Decodes the next frame. Returns false at the end of the file or if the frame is damaged.
+    bool ReadFrame(TrajectoryFrame& frame);
+
+    // Accessors
+    float GetPositionPrecision() const { return m_positionPrecision; }
+    float GetVelocityPrecision() const { return m_velocityPrecision; }
+
+private:
+    std::ifstream                       m_file;
+    float                               m_positionPrecision;
+    float                               m_velocityPrecision;
+    std::unique_ptr<TrajectoryHistory>  m_history;
+    std::vector<uint8_t>                m_buffer;
+};